@@ -11,9 +11,13 @@
 #include <algorithm>
 #include <typeindex>
 #include "colors.h"
+#include "MoverBatcher.h"
+#include "SoftwareRasterizer.h"
+#include "DensityHeatmap.h"
 #include "util.h"
 #include "SimulatorCommander.h"
 #include "SimulatorCommand.h"
+#include "SimulationRunner.h"
 #include <memory>
 #include <typeindex>
 #include <unordered_set>
@@ -31,12 +35,15 @@ private:
     void CreateSetupScreen();
     void StartSimulation();
     void OnPaint(wxPaintEvent& event);
+    void paintBatched(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot);
+    void paintRasterized(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot);
+    void paintHeatmap(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot, DensityHeatmap::Quantity quantity);
+    void blit(wxBufferedPaintDC& dc, const std::vector<uint32_t>& pixels, wxSize size);
     void OnTimer(wxTimerEvent& event);
     void OnGravityCheckbox(wxCommandEvent& event);
     void OnSpringCheckbox(wxCommandEvent& event);
     void OnSoftCollideCheckbox(wxCommandEvent& event);
     void OnCoulombCheckbox(wxCommandEvent& event);
-    void draw(const Mover& mover, wxBufferedPaintDC& dc, wxColour color);
     bool ValidateInputs();
     void OnKeyDown(wxKeyEvent& event);
     void OnKeyUp(wxKeyEvent& event);
@@ -72,6 +79,14 @@ private:
     // functional members
     Simulator& simulator;
     std::shared_ptr<SimulatorCommander> commander;
+    std::unique_ptr<SimulationRunner> runner; //steps the simulation off the GUI thread
+    enum class RenderMode { Batched, Rasterized, DensityHeatmap, SpeedHeatmap }; //'v' cycles
+    RenderMode renderMode = RenderMode::Batched;
+    MoverBatcher moverBatcher; //culls and groups movers by colour for OnPaint
+    SoftwareRasterizer rasterizer; //draws into a pixel buffer on worker threads, for large mover counts
+    DensityHeatmap heatmap; //histogram of movers per screen cell, for very large counts
+    std::vector<uint32_t> rasterPalette; //colorPalette packed for the rasterizer, also the heatmap ramp
+    wxImage frameImage;
     Vect2 centeredOn;
     float zoomFactor = 1;
     float maxZoom = 10;
@@ -255,7 +270,10 @@ void MyFrame::StartSimulation() {
 
     // Bind timer event to update logic
     Bind(wxEVT_TIMER, &MyFrame::OnTimer, this);
+    commander->setCommandBudget({0, std::chrono::milliseconds(4)}); //a burst of script commands can't stall a frame
     commander->runSimulator();
+    runner = std::make_unique<SimulationRunner>(commander); //a fresh runner each start, OnStop stops the last one
+    runner->start();
 }
 
 
@@ -264,23 +282,84 @@ void MyFrame::OnPaint(wxPaintEvent& event) {
     // Clear the screen
     dc.SetBackground(wxBrush(wxColour(wxString("BLACK"))));
     dc.Clear();
-    //setting viewport based on center and zoom
+    //setting viewport based on center and zoom. both paths map to device pixels themselves
     zoomFactor = std::clamp(zoomFactor, minZoom, maxZoom);
-    dc.SetUserScale(zoomFactor, zoomFactor);
-    dc.SetDeviceOrigin(centeredOn.x, centeredOn.y);   
-    // Draw the circles
-    for (auto& mover : simulator.movers) {
-        int colorIndex = (mover->id) % colorPalette.size();
+    // draw from the latest published snapshot, never the live movers the simulator may be stepping
+    auto snapshot = simulator.snapshots.read();
+    if (rasterPalette.size() != colorPalette.size()) {
+        rasterPalette.clear();
+        for (const auto& color : colorPalette) {
+            rasterPalette.push_back(SoftwareRasterizer::packRGBA(color.Red(), color.Green(), color.Blue()));
+        }
+        heatmap.setRamp(rasterPalette);
+    }
+    switch (renderMode) {
+        case RenderMode::Batched: paintBatched(dc, *snapshot); break;
+        case RenderMode::Rasterized: paintRasterized(dc, *snapshot); break;
+        case RenderMode::DensityHeatmap: paintHeatmap(dc, *snapshot, DensityHeatmap::Quantity::Density); break;
+        case RenderMode::SpeedHeatmap: paintHeatmap(dc, *snapshot, DensityHeatmap::Quantity::Speed); break;
+    }
+}
+
+void MyFrame::paintBatched(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot) {
+    wxSize size = GetClientSize();
+    const auto& batches = moverBatcher.batch(snapshot, colorPalette.size(), zoomFactor, centeredOn, size.GetWidth(), size.GetHeight());
+    // one brush/pen change per palette colour rather than per mover
+    for (int colorIndex = 0; colorIndex < batches.size(); colorIndex++) {
+        const auto& batch = batches[colorIndex];
         wxColour color = colorPalette[colorIndex];
-        draw(*mover, dc, color);
+        dc.SetBrush(wxBrush(color));
+        dc.SetPen(*wxTRANSPARENT_PEN);
+        for (const auto& circle : batch.circles) {
+            dc.DrawCircle(wxRound(circle.x), wxRound(circle.y), wxRound(circle.radius));
+        }
+        for (const auto& square : batch.squares) {
+            dc.DrawRectangle(square.x, square.y, square.size, square.size);
+        }
+        if (batch.pixels.empty()) continue;
+        dc.SetPen(wxPen(color));
+        for (const auto& pixel : batch.pixels) {
+            dc.DrawPoint(pixel.x, pixel.y);
+        }
+    }
+    dc.SetPen(*wxWHITE_PEN);
+    for (int i = 0; i < snapshot.wallStarts.size(); i++) {
+        Vect2 start = snapshot.wallStarts[i]*zoomFactor + centeredOn;
+        Vect2 end = snapshot.wallEnds[i]*zoomFactor + centeredOn;
+        dc.DrawLine(start.x, start.y, end.x, end.y);
     }
+}
+
+void MyFrame::paintRasterized(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot) {
+    wxSize size = GetClientSize();
+    if (size.GetWidth() <= 0 || size.GetHeight() <= 0) return;
+    blit(dc, rasterizer.render(snapshot, rasterPalette, zoomFactor, centeredOn, size.GetWidth(), size.GetHeight()), size);
+}
 
+void MyFrame::paintHeatmap(wxBufferedPaintDC& dc, const SimulatorSnapshot& snapshot, DensityHeatmap::Quantity quantity) {
+    wxSize size = GetClientSize();
+    if (size.GetWidth() <= 0 || size.GetHeight() <= 0) return;
+    heatmap.quantity = quantity;
+    blit(dc, heatmap.render(snapshot, zoomFactor, centeredOn, size.GetWidth(), size.GetHeight()), size);
 }
 
+void MyFrame::blit(wxBufferedPaintDC& dc, const std::vector<uint32_t>& pixels, wxSize size) {
+    // wxImage holds packed RGB, so drop the alpha on the way in, then blit the frame as one bitmap
+    if (!frameImage.IsOk() || frameImage.GetWidth() != size.GetWidth() || frameImage.GetHeight() != size.GetHeight()) {
+        frameImage.Create(size.GetWidth(), size.GetHeight(), false);
+    }
+    unsigned char* rgb = frameImage.GetData();
+    for (size_t i = 0; i < pixels.size(); i++) {
+        uint32_t pixel = pixels[i];
+        rgb[3*i] = pixel & 0xFF;
+        rgb[3*i + 1] = (pixel >> 8) & 0xFF;
+        rgb[3*i + 2] = (pixel >> 16) & 0xFF;
+    }
+    dc.DrawBitmap(wxBitmap(frameImage), 0, 0);
+}
 void MyFrame::OnTimer(wxTimerEvent& event) {
-    // Update the circle's position
+    // the runner steps the simulation on its own thread; the timer only sets the frame rate
     // wxLogMessage("Mover Position - X: %d, Y: %d", simulator.movers[0]->position.x, simulator.movers[0]->position.y); 
-    commander->update();
     // wxLogMessage("Mover Position - X: %d, Y: %d", simulator.movers[0]->position.x, simulator.movers[0]->position.y); 
     // std::cout << "Mover1: " << simulator.movers[0]->position << std::endl;
     // std::cout << "Mover2: " << simulator.movers[1]->position << std::endl;
@@ -290,8 +369,12 @@ void MyFrame::OnTimer(wxTimerEvent& event) {
     Refresh();
 }
 
-void MyFrame::OnStop(wxCommandEvent& event) { //stop timer and return to setup screen
+void MyFrame::OnStop(wxCommandEvent& event) { //stop timer and runner and return to setup screen
     timer.Stop();
+    // the runner steps on its own thread, so stopping the timer alone would leave it running behind the setup panel
+    if (runner) runner->stop();
+    runner.reset();
+    commander->pauseSimulator();
     simulationPanel->Hide();
     setupPanel->Show();
     Layout();
@@ -342,17 +425,17 @@ bool MyFrame::ValidateInputs() {
   return true;
 }
 
-void MyFrame::draw(const Mover& mover, wxBufferedPaintDC& dc, wxColor color) {
-
-  dc.SetBrush(color);
-//   dc.SetBrush(*wxBLUE_BRUSH);
-  dc.SetPen(*wxTRANSPARENT_PEN);
-  // float x = mover.position.x - centeredOn.x;
-  // float y = mover.position.y - centeredOn.y;
-  dc.DrawCircle(mover.position.x, mover.position.y, mover.radius);
-}
 
 void MyFrame::OnKeyDown(wxKeyEvent& event) {
+  //'v' cycles between drawing movers with wx calls, rasterizing them into one bitmap, and the two heatmaps
+  if (event.GetKeyCode() == 'v' || event.GetKeyCode() == 'V') {
+    if (pressedKeys.count(event.GetKeyCode()) == 0) {
+      pressedKeys.insert(event.GetKeyCode());
+    } else return;
+    renderMode = RenderMode(((int)renderMode + 1) % 4);
+    Refresh();
+    return;
+  }
 
   //up arrow key
   int speed = 10;
@@ -433,14 +516,12 @@ void MyFrame::OnKeyDown(wxKeyEvent& event) {
     }
     else return;
     Vect2 clickedPosition = mouseToSimulatorPosition();
-    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(commander->simulator, clickedPosition);
+    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(*simulator.snapshots.read(), clickedPosition);
     for (auto& id : ids) {
-        //if shift+r, delete group (if it is a group)
-        auto moverPtr = (commander->simulator.find_mover(id));
-        bool isGroup = dynamic_cast<RigidConnectedMover*>(moverPtr->get()) != nullptr;
-        if (event.ShiftDown() && isGroup) {
+        //if shift+r, delete group (or just the mover if it isn't in one)
+        if (event.ShiftDown()) {
                 // wxLogMessage("GroupDeletion");
-                commander->addCommandDeleteGroup(id);
+                commander->addCommandDeleteGroup(id, true);
         }
         else //just delete the one mover
             // wxLogMessage("SingleDeletion");
@@ -471,7 +552,7 @@ void MyFrame::OnKeyDown(wxKeyEvent& event) {
     } else return;
     if (addingToGroup) {
         Vect2 mousePosition = mouseToSimulatorPosition();
-        std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(commander->simulator, mousePosition);
+        std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(*simulator.snapshots.read(), mousePosition);
         for (auto& id : ids) {
             moverIdsForGrouping.push_back(id);
         }
@@ -484,7 +565,7 @@ void MyFrame::OnKeyDown(wxKeyEvent& event) {
      pressedKeys.insert(event.GetKeyCode());
    } else return;
        Vect2 mousePosition = mouseToSimulatorPosition();
-       std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(commander->simulator, mousePosition);
+       std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(*simulator.snapshots.read(), mousePosition);
        for (auto& id : ids) {
            //ungroup associated group
            commander->addCommandUngroup(id);
@@ -497,7 +578,7 @@ void MyFrame::OnKeyDown(wxKeyEvent& event) {
       pressedKeys.insert(event.GetKeyCode());
     } else return;
     Vect2 mousePosition = mouseToSimulatorPosition();
-    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(commander->simulator, mousePosition);
+    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(*simulator.snapshots.read(), mousePosition);
     //define kick lambda
     auto kickLambda = [mousePosition](Mover& mover) {
         Vect2 r = mover.position - mousePosition;
@@ -517,7 +598,7 @@ void MyFrame::OnKeyDown(wxKeyEvent& event) {
       pressedKeys.insert(event.GetKeyCode());
     } else return;
     Vect2 mousePosition = mouseToSimulatorPosition();
-    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(commander->simulator, mousePosition);
+    std::vector<int> ids = SimulatorCommand::getMoverIdsByPosition(*simulator.snapshots.read(), mousePosition);
     for (auto& id : ids) {
       auto it = std::find(moverIdsMoving.begin(), moverIdsMoving.end(), id);
       if (it == moverIdsMoving.end()) { //not found, add
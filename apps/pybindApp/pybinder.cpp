@@ -1,6 +1,8 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/operators.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include "Vect2.h"
 #include "Mover.h"
 #include "RigidMovers.h"
@@ -11,10 +13,22 @@
 #include "SoftCollideInteraction.h"
 #include "LorentzEffect.h"
 #include "Drag.h"
+#include "SampledForceField.h"
+#include "MultiAttractor.h"
 #include "InteractingGroup.h"
+#include "ExpressionInteractingGroup.h"
+#include "ExpressionEffect.h"
+#include "PluginInteractingGroup.h"
+#include "PluginEffect.h"
 #include "launchWidget.h"
 #include "SimulatorCommand.h"
 #include "SimulatorCommander.h"
+#include "SimulationRecorder.h"
+#include "TrajectoryWriter.h"
+#include "TrajectoryReader.h"
+#include "SimulatorCheckpoint.h"
+#include "ReplayRecorder.h"
+#include "StepTask.h"
 
 
 namespace py = pybind11;
@@ -28,14 +42,69 @@ void report_mover_positions(Simulator& sim) {
     }
 };
 
+Mover& mover_by_id(Simulator& sim, int id) {
+    auto it = sim.find_mover(id);
+    if (it == sim.movers.end()) throw std::invalid_argument("no mover with id " + std::to_string(id));
+    return **it;
+};
+
 Vect2 get_mover_position(Simulator& sim, int id) {
-    return sim.movers[id]->position;
+    return mover_by_id(sim, id).position;
 };
 
 Vect2 get_mover_velocity(Simulator& sim, int id) {
-    return sim.movers[id]->velocity;
+    return mover_by_id(sim, id).velocity;
+};
+
+// bulk state as numpy arrays in mover order (ascending id), filled by one call instead of a call per mover.
+// movers are separate objects, so these are copies: edit them and pass them back with the set_ functions
+static_assert(sizeof(Vect2) == 2*sizeof(float), "Vect2 arrays are viewed as (n, 2) float arrays");
+using float_array = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+py::dict get_mover_state(Simulator& sim) {
+    py::ssize_t n = sim.movers.size();
+    py::array_t<int32_t> ids(n);
+    float_array positions({n, (py::ssize_t)2}), velocities({n, (py::ssize_t)2});
+    float_array masses(n), radii(n);
+    sim.get_mover_state(n, ids.mutable_data(), reinterpret_cast<Vect2*>(positions.mutable_data()),
+        reinterpret_cast<Vect2*>(velocities.mutable_data()), masses.mutable_data(), radii.mutable_data());
+    py::dict state;
+    state["ids"] = ids;
+    state["positions"] = positions;
+    state["velocities"] = velocities;
+    state["masses"] = masses;
+    state["radii"] = radii;
+    return state;
+};
+
+float_array get_mover_vects(Simulator& sim, bool velocities) {
+    py::ssize_t n = sim.movers.size();
+    float_array values({n, (py::ssize_t)2});
+    Vect2* out = reinterpret_cast<Vect2*>(values.mutable_data());
+    sim.get_mover_state(n, nullptr, velocities ? nullptr : out, velocities ? out : nullptr, nullptr, nullptr);
+    return values;
 };
 
+const float* checked_column(const std::optional<float_array>& values, size_t n, int width, const char* name) {
+    if (!values) return nullptr;
+    size_t expected = n*width;
+    if (values->size() != expected || (width == 2 && (values->ndim() != 2 || values->shape(1) != 2))) {
+        throw std::invalid_argument(std::string(name) + " must have one " + (width == 2 ? "(x, y) row" : "value")
+            + " per mover, " + std::to_string(n) + " movers");
+    }
+    return values->data();
+};
+
+void set_mover_state(Simulator& sim, std::optional<float_array> positions, std::optional<float_array> velocities,
+    std::optional<float_array> masses, std::optional<float_array> radii) {
+    // checked against this count, which set_mover_state checks again under its lock
+    size_t n = sim.movers.size();
+    sim.set_mover_state(n, reinterpret_cast<const Vect2*>(checked_column(positions, n, 2, "positions")),
+        reinterpret_cast<const Vect2*>(checked_column(velocities, n, 2, "velocities")),
+        checked_column(masses, n, 1, "masses"), checked_column(radii, n, 1, "radii"));
+};
+
+
 
 void add_spring_interaction(Simulator& sim, float k, float x0) {
     sim.add_interaction(new Spring(k, x0));
@@ -53,6 +122,27 @@ void add_drag(Simulator& sim, float dragStrength) {
     sim.add_effect(new Drag(dragStrength), {1.0f});
 };
 
+void add_sampled_force_field(Simulator& sim, std::vector<float> fx, std::vector<float> fy, int nx, int ny,
+    Vect2 origin, Vect2 extent, bool bicubic) {
+    auto interpolation = bicubic ? SampledForceField::Interpolation::Bicubic : SampledForceField::Interpolation::Bilinear;
+    sim.add_effect(new SampledForceField(std::move(fx), std::move(fy), nx, ny, origin, extent, interpolation), {1.0f});
+};
+
+void add_sampled_force_field_from_function(Simulator& sim, std::function<Vect2(Vect2)> field, int nx, int ny,
+    Vect2 origin, Vect2 extent, bool bicubic) {
+    //the python function is only called here, to fill the grid, so update never takes the GIL for it
+    auto interpolation = bicubic ? SampledForceField::Interpolation::Bicubic : SampledForceField::Interpolation::Bilinear;
+    SampledForceField* effect = new SampledForceField(field, origin, extent, nx, ny, interpolation);
+    effect->fieldFunction = nullptr;
+    sim.add_effect(effect, {1.0f});
+};
+
+MultiAttractor* add_multi_attractor(Simulator& sim, float min_distance) {
+    MultiAttractor* effect = new MultiAttractor(min_distance);
+    sim.add_effect(effect);
+    return effect; //owned by the simulator
+};
+
 void add_softCollide_interaction(Simulator& sim, float springStrength, float repulsionStrength) {
     sim.add_interaction(new SoftCollide(springStrength, repulsionStrength), 
     {1.0f,1.0f} //default collssion params for each mover 
@@ -60,15 +150,40 @@ void add_softCollide_interaction(Simulator& sim, float springStrength, float rep
 };
 
 void add_springGroup(Simulator& sim, float k, float x0, std::vector<int> moverIds) {
-    std::function<void(Mover&, Mover&)> interaction = [k, x0](Mover& mover1, Mover& mover2) {
-        Vect2 r = mover1.position - mover2.position;
-        float magnitude = r.mag();
-        float springForceMag = -k*(magnitude - x0);
-        Vect2 springForce = springForceMag * r/magnitude;
-        mover1.apply_force(springForce);
-        mover2.apply_force(-1*springForce);
-    };
-    sim.add_interactingGroup(moverIds, interaction);
+    sim.add_interactingGroup(moverIds, SpringPairKernel{k, x0});
+};
+
+void add_expression_group(Simulator& sim, std::string force, std::vector<int> moverIds,
+    std::unordered_map<std::string, float> constants, std::vector<std::pair<std::string, float>> params) {
+    //compiled here, so update never calls back into python
+    sim.add_interactingGroup(std::make_unique<ExpressionInteractingGroup>(sim, moverIds, force, constants, params));
+};
+
+void add_expression_effect(Simulator& sim, std::string force, std::unordered_map<std::string, float> constants,
+    std::vector<std::pair<std::string, float>> params) {
+    std::vector<std::string> names;
+    std::vector<std::any> defaults;
+    for (auto& [name, value] : params) {
+        names.push_back(name);
+        defaults.push_back(value);
+    }
+    sim.add_effect(new ExpressionEffect(force, constants, names, &sim.current_time), defaults);
+};
+
+void register_kernel(Simulator& sim, uintptr_t address) {
+    //address of a phys_kernel struct, e.g. built with ctypes or cffi around compiled functions
+    if (address == 0) throw std::invalid_argument("register_kernel: null kernel address");
+    sim.kernels.add(*reinterpret_cast<const phys_kernel*>(address));
+};
+
+void add_plugin_group(Simulator& sim, std::string kernel, std::vector<int> moverIds, std::vector<float> constants,
+    std::vector<float> params) {
+    sim.add_interactingGroup(std::make_unique<PluginInteractingGroup>(sim, moverIds, sim.kernels.find(kernel), constants, params));
+};
+
+void add_plugin_effect(Simulator& sim, std::string kernel, std::vector<float> constants, std::vector<float> params) {
+    std::vector<std::any> defaults(params.begin(), params.end());
+    sim.add_effect(new PluginEffect(sim.kernels.find(kernel), constants, &sim.current_time), defaults);
 };
 
 std::unordered_map<std::string, std::type_index> type_map = {
@@ -80,7 +195,12 @@ std::unordered_map<std::string, std::type_index> type_map = {
     {"Coulomb", typeid(Coulomb)},
     {"SoftCollide", typeid(SoftCollide)},
     {"LorentzEffect", typeid(LorentzEffect)},
-    {"DragEffect", typeid(Drag)} 
+    {"DragEffect", typeid(Drag)},
+    {"SampledForceField", typeid(SampledForceField)},
+    {"ExpressionGroup", typeid(ExpressionInteractingGroup)},
+    {"ExpressionEffect", typeid(ExpressionEffect)},
+    {"PluginGroup", typeid(PluginInteractingGroup)},
+    {"PluginEffect", typeid(PluginEffect)}
 };
 
 std::type_index resolve_type_index(const std::string& type_name) {
@@ -134,6 +254,99 @@ int add_mover(Simulator& sim, std::string type, MoverArgs args,
     }
 };
 
+// many movers from numpy arrays (n, 2) for vectors and (n,) for scalars; None uses the type's default.
+// params maps an interaction name to its parameters in order, each a number shared by every mover or an (n,) array.
+// the arrays are held here until the movers are built. returns the range of the new ids
+py::object add_movers(Simulator& sim, std::string type, std::optional<float_array> positions,
+    std::optional<float_array> velocities, std::optional<float_array> accelerations, std::optional<float_array> radii,
+    std::optional<float_array> masses, std::unordered_map<std::string, std::vector<py::object>> params,
+    std::optional<size_t> count) {
+    std::type_index moverType = resolve_type_index(type);
+    std::vector<std::pair<const std::optional<float_array>*, int>> columns = {
+        {&positions, 2}, {&velocities, 2}, {&accelerations, 2}, {&radii, 1}, {&masses, 1}};
+    std::vector<float_array> paramArrays; //keeps converted parameter columns alive
+    std::unordered_map<std::type_index, std::vector<std::any>> shared;
+    MoverArrays arrays;
+    for (auto& [name, values] : params) {
+        std::type_index paramType = resolve_type_index(name);
+        for (auto& value : values) {
+            if (py::isinstance<py::array>(value) || py::isinstance<py::list>(value)) {
+                paramArrays.push_back(value.cast<float_array>());
+                arrays.paramColumns[paramType].push_back(paramArrays.back().data());
+                shared[paramType].push_back(0.0f); //replaced per mover
+            } else {
+                arrays.paramColumns[paramType].push_back(nullptr);
+                shared[paramType].push_back(py_to_any(value));
+            }
+        }
+    }
+    // the count comes from the first array given, and every array has to agree with it
+    auto check = [&](const float_array& array, int width) {
+        bool shaped = width == 2 ? array.ndim() == 2 && array.shape(1) == 2 : array.ndim() == 1;
+        if (!shaped) throw std::invalid_argument(width == 2 ? "add_movers: vector arrays must be (n, 2)" : "add_movers: scalar arrays must be (n,)");
+        size_t rows = array.shape(0);
+        if (!count) count = rows;
+        if (rows != *count) throw std::invalid_argument("add_movers: arrays have different lengths");
+    };
+    for (auto& [column, width] : columns) if (*column) check(**column, width);
+    for (auto& array : paramArrays) check(array, 1);
+    if (!count) throw std::invalid_argument("add_movers: give count, or at least one array");
+    arrays.count = *count;
+    arrays.positions = positions ? reinterpret_cast<const Vect2*>(positions->data()) : nullptr;
+    arrays.velocities = velocities ? reinterpret_cast<const Vect2*>(velocities->data()) : nullptr;
+    arrays.accelerations = accelerations ? reinterpret_cast<const Vect2*>(accelerations->data()) : nullptr;
+    arrays.radii = radii ? radii->data() : nullptr;
+    arrays.masses = masses ? masses->data() : nullptr;
+    int first = sim.add_movers(moverType, arrays, std::move(shared));
+    return py::module_::import("builtins").attr("range")(first, first + (py::ssize_t)*count);
+};
+
+// a recorder chunk as a dict of numpy arrays: ids (movers,), steps and times (samples,), and values, mapping each
+// RecordableData field to a (samples, movers) array. the arrays view the chunk, which they own through a capsule
+py::dict chunk_to_dict(RecordChunk&& source, const std::vector<RECORDABLE_DATA>& fields) {
+    RecordChunk* chunk = new RecordChunk(std::move(source));
+    py::capsule owner(chunk, [](void* data) { delete static_cast<RecordChunk*>(data); });
+    py::ssize_t samples = chunk->samples;
+    py::ssize_t movers = chunk->ids.size();
+    py::dict result;
+    result["ids"] = py::array_t<int>({movers}, chunk->ids.data(), owner);
+    result["steps"] = py::array_t<long long>({samples}, chunk->steps.data(), owner);
+    result["times"] = py::array_t<float>({samples}, chunk->times.data(), owner);
+    py::dict values;
+    for (int f = 0; f < fields.size(); f++) {
+        values[py::cast(fields[f])] = py::array_t<float>({samples, movers}, chunk->columns[f].data(), owner);
+    }
+    result["values"] = values;
+    return result;
+};
+
+// a StepTask's destructor joins its thread, whose steps may call back into Python (e.g. an interacting group with a
+// Python function), so Python's reference to it lets go of the GIL while it is destroyed
+struct ReleaseGilDelete {
+    void operator()(StepTask* task) const {
+        py::gil_scoped_release release;
+        delete task;
+    }
+};
+using StepTaskHolder = std::unique_ptr<StepTask, ReleaseGilDelete>;
+
+// read-only numpy view of memory owned by owner: a trajectory reader's mapped file or decoded chunks, or a snapshot.
+// the array keeps owner, and so the memory, alive
+template <class T>
+py::array_t<T> readonly_view(py::object owner, const T* data, std::vector<py::ssize_t> shape) {
+    py::array_t<T> array(shape, data, owner);
+    array.attr("flags").attr("writeable") = false;
+    return array;
+};
+
+py::array_t<float> trajectory_column(py::object self, int chunk, RECORDABLE_DATA field) {
+    auto& reader = self.cast<TrajectoryReader&>();
+    int f = reader.fieldIndex(field);
+    if (f < 0) throw std::invalid_argument("field was not recorded in this trajectory");
+    auto& view = reader.chunk(chunk);
+    return readonly_view<float>(self, view.columns[f], {view.samples, view.moverCount});
+};
+
 
 // Define the Python module
 PYBIND11_MODULE(phys_engine, m) {
@@ -190,22 +403,216 @@ PYBIND11_MODULE(phys_engine, m) {
         .def(py::init<float, float>())
         .def("interact", &Spring::interact, py::return_value_policy::reference);
     
+    py::class_<SimulatorSnapshot>(m, "SimulatorSnapshot")
+        .def_readonly("time", &SimulatorSnapshot::time)
+        .def_readonly("step", &SimulatorSnapshot::step)
+        .def_readonly("ids", &SimulatorSnapshot::ids)
+        .def_readonly("positions", &SimulatorSnapshot::positions)
+        .def_readonly("velocities", &SimulatorSnapshot::velocities)
+        .def_readonly("radii", &SimulatorSnapshot::radii)
+        .def_readonly("wall_starts", &SimulatorSnapshot::wallStarts)
+        .def_readonly("wall_ends", &SimulatorSnapshot::wallEnds)
+        .def_property_readonly("id_array", [](py::object self) {
+            auto& snapshot = self.cast<SimulatorSnapshot&>();
+            return readonly_view<int32_t>(self, snapshot.ids.data(), {(py::ssize_t)snapshot.ids.size()});
+        })
+        .def_property_readonly("position_array", [](py::object self) {
+            auto& snapshot = self.cast<SimulatorSnapshot&>();
+            return readonly_view<float>(self, reinterpret_cast<const float*>(snapshot.positions.data()), {(py::ssize_t)snapshot.positions.size(), 2});
+        }, "(n, 2) view of positions, without converting each one to a Vect2")
+        .def_property_readonly("velocity_array", [](py::object self) {
+            auto& snapshot = self.cast<SimulatorSnapshot&>();
+            return readonly_view<float>(self, reinterpret_cast<const float*>(snapshot.velocities.data()), {(py::ssize_t)snapshot.velocities.size(), 2});
+        })
+        .def_property_readonly("radius_array", [](py::object self) {
+            auto& snapshot = self.cast<SimulatorSnapshot&>();
+            return readonly_view<float>(self, snapshot.radii.data(), {(py::ssize_t)snapshot.radii.size()});
+        });
+
+    //created with Simulator.add_multi_attractor, which keeps ownership
+    py::class_<MultiAttractor>(m, "MultiAttractor")
+        .def("add_attractor", &MultiAttractor::addAttractor, "returns the attractor index", py::arg("position"), py::arg("strength"))
+        .def("move_attractor", &MultiAttractor::moveAttractor, py::arg("index"), py::arg("position"))
+        .def("set_strength", &MultiAttractor::setStrength, py::arg("index"), py::arg("strength"))
+        .def("remove_attractor", &MultiAttractor::removeAttractor, "the last attractor takes over this index", py::arg("index"))
+        .def("attractor_count", &MultiAttractor::attractorCount)
+        .def_readwrite("theta", &MultiAttractor::theta)
+        .def_readwrite("tree_threshold", &MultiAttractor::treeThreshold);
+
+    py::enum_<RECORDABLE_DATA>(m, "RecordableData")
+        .value("POSITION_X", POSITION_X)
+        .value("POSITION_Y", POSITION_Y)
+        .value("VELOCITY_X", VELOCITY_X)
+        .value("VELOCITY_Y", VELOCITY_Y)
+        .value("ACCELERATION_X", ACCELERATION_X)
+        .value("ACCELERATION_Y", ACCELERATION_Y)
+        .value("MASS", MASS);
+
+    py::class_<SimulationRecorder>(m, "SimulationRecorder")
+        .def(py::init<Simulator&, std::vector<RECORDABLE_DATA>, std::vector<int>, int, int>(), py::keep_alive<1, 2>(),
+        "record fields of the given movers (every mover if mover_ids is empty) every stride steps",
+        py::arg("simulator"), py::arg("fields"), py::arg("mover_ids") = std::vector<int>(), py::arg("stride") = 1,
+        py::arg("chunk_samples") = 256)
+        .def("record", &SimulationRecorder::record, "record the current step if due. Returns true if recorded")
+        .def("run", &SimulationRecorder::run, "update the simulator steps times, recording every due step",
+        py::arg("steps"), py::call_guard<py::gil_scoped_release>())
+        .def("flush", &SimulationRecorder::flush, "complete the current chunk, e.g. before closing a writer")
+        .def("sample_count", &SimulationRecorder::sampleCount)
+        .def("take_chunks", [](SimulationRecorder& recorder) {
+            py::list result;
+            for (auto& chunk : recorder.takeChunks()) result.append(chunk_to_dict(std::move(chunk), recorder.fields));
+            return result;
+        }, "every sample recorded so far, as a list of chunk dicts (ids, steps, times, values[field] of shape "
+        "(samples, movers)), and forget them")
+        .def("take_block", [](SimulationRecorder& recorder) {
+            auto chunks = recorder.takeChunks();
+            return chunk_to_dict(RecordChunk::concatenate(chunks), recorder.fields);
+        }, "every sample recorded so far as one dict, like a chunk, and forget them. "
+        "Raises if the recorded movers changed; use take_chunks then")
+        .def("set_on_chunk", [](SimulationRecorder& recorder, std::function<void(py::dict)> callback) {
+            // the chunk's buffers are reused after the call, so Python gets a copy
+            recorder.keepChunks = false;
+            recorder.onChunk = [&recorder, callback](const RecordChunk& chunk) {
+                py::gil_scoped_acquire acquire;
+                callback(chunk_to_dict(RecordChunk(chunk), recorder.fields));
+            };
+        }, "call callback with every completed chunk (as take_chunks gives them) instead of keeping it", py::arg("callback"));
+
+    py::class_<TrajectoryWriter>(m, "TrajectoryWriter")
+        .def(py::init<const std::string&, std::vector<RECORDABLE_DATA>, std::vector<float>>(),
+        "max_errors: empty to store fields exactly, or an absolute error per field (0 for exact)",
+        py::arg("path"), py::arg("fields"), py::arg("max_errors") = std::vector<float>())
+        .def("attach", &TrajectoryWriter::attach, py::keep_alive<2, 1>(),
+        "write every chunk the recorder completes to this file", py::arg("recorder"))
+        .def("close", &TrajectoryWriter::close, "write the chunk index and close the file")
+        .def("chunk_count", &TrajectoryWriter::chunkCount)
+        .def("bytes_written", &TrajectoryWriter::bytesWritten);
+
+    //arrays returned by the reader are read-only views of the mapped file (or of decoded chunks), not copies
+    py::class_<TrajectoryReader>(m, "TrajectoryReader")
+        .def(py::init<const std::string&>(), py::arg("path"))
+        .def_property_readonly("fields", &TrajectoryReader::fields)
+        .def_property_readonly("complete", &TrajectoryReader::isComplete)
+        .def("chunk_count", &TrajectoryReader::chunkCount)
+        .def("frame_count", &TrajectoryReader::frameCount)
+        .def("find_step", &TrajectoryReader::findStep, "index of the first frame at or after step", py::arg("step"))
+        .def("decode_chunks", [](TrajectoryReader& reader, int first, int last) { reader.decodeChunks(first, last); },
+        "decode compressed chunks [first, last) in parallel ahead of use", py::arg("first"), py::arg("last"))
+        .def("chunk_ids", [](py::object self, int chunk) {
+            auto& view = self.cast<TrajectoryReader&>().chunk(chunk);
+            return readonly_view<int32_t>(self, view.ids, {view.moverCount});
+        }, py::arg("chunk"))
+        .def("chunk_steps", [](py::object self, int chunk) {
+            auto& view = self.cast<TrajectoryReader&>().chunk(chunk);
+            return readonly_view<int64_t>(self, view.steps, {view.samples});
+        }, py::arg("chunk"))
+        .def("chunk_times", [](py::object self, int chunk) {
+            auto& view = self.cast<TrajectoryReader&>().chunk(chunk);
+            return readonly_view<float>(self, view.times, {view.samples});
+        }, py::arg("chunk"))
+        .def("column", &trajectory_column, "(samples, movers) array of one field in one chunk",
+        py::arg("chunk"), py::arg("field"))
+        .def("frame", [](py::object self, long long index, RECORDABLE_DATA field) {
+            auto& reader = self.cast<TrajectoryReader&>();
+            int f = reader.fieldIndex(field);
+            if (f < 0) throw std::invalid_argument("field was not recorded in this trajectory");
+            auto frame = reader.frame(index);
+            return readonly_view<float>(self, frame.values(f), {frame.moverCount()});
+        }, "one field of every mover at one frame", py::arg("index"), py::arg("field"));
+
+    py::class_<ReplayFrame>(m, "ReplayFrame")
+        .def(py::init<>())
+        .def_readonly("step", &ReplayFrame::step)
+        .def_readonly("time", &ReplayFrame::time)
+        .def_readonly("ids", &ReplayFrame::ids)
+        .def("values", [](const ReplayFrame& frame, int field) {
+            auto& column = frame.values.at(field);
+            return py::array_t<float>(column.size(), column.data());
+        }, "copy of one field (by its position in the recorder's fields) for every mover", py::arg("field"));
+
+    //seek and seek_time return None outside the recorded window. next/previous move the frame in place
+    py::class_<ReplayRecorder>(m, "ReplayRecorder")
+        .def(py::init<Simulator&, std::vector<RECORDABLE_DATA>, int, int, int>(), py::keep_alive<1, 2>(),
+        "keep the newest max_segments keyframe intervals of every mover's fields in memory for seeking",
+        py::arg("simulator"), py::arg("fields"), py::arg("keyframe_interval") = 64, py::arg("max_segments") = 64,
+        py::arg("stride") = 1)
+        .def("record", &ReplayRecorder::record, "record the current step if due. Returns true if recorded")
+        .def("run", &ReplayRecorder::run, "update the simulator steps times, recording every due step", py::arg("steps"),
+        py::call_guard<py::gil_scoped_release>())
+        .def("clear", &ReplayRecorder::clear)
+        .def("first_step", &ReplayRecorder::firstStep)
+        .def("last_step", &ReplayRecorder::lastStep)
+        .def("bytes", &ReplayRecorder::bytes)
+        .def("seek", [](const ReplayRecorder& replay, long long step) -> std::optional<ReplayFrame> {
+            ReplayFrame frame;
+            if (!replay.seek(step, frame)) return std::nullopt;
+            return frame;
+        }, "latest recorded sample at or before step", py::arg("step"))
+        .def("seek_time", [](const ReplayRecorder& replay, float time) -> std::optional<ReplayFrame> {
+            ReplayFrame frame;
+            if (!replay.seekTime(time, frame)) return std::nullopt;
+            return frame;
+        }, "latest recorded sample at or before time", py::arg("time"))
+        .def("next", &ReplayRecorder::next, "step frame forward one sample. False at the end", py::arg("frame"))
+        .def("previous", &ReplayRecorder::previous, "step frame back one sample. False at the start", py::arg("frame"));
+
+    //progress is polled rather than called back, so the stepping thread never waits for the GIL
+    py::class_<StepTask, StepTaskHolder>(m, "StepTask")
+        .def_property_readonly("steps", &StepTask::stepsRequested)
+        .def("progress", &StepTask::stepsDone, "steps taken so far")
+        .def("done", &StepTask::isDone)
+        .def("cancel", &StepTask::cancel, "stop after the step in progress")
+        .def("cancelled", &StepTask::isCancelled)
+        .def("wait", [](StepTask& task, std::optional<double> timeout) -> py::object {
+            if (!timeout) {
+                long long steps;
+                {
+                    py::gil_scoped_release release;
+                    steps = task.wait();
+                }
+                return py::int_(steps);
+            }
+            bool finished;
+            {
+                py::gil_scoped_release release;
+                finished = task.waitFor(std::chrono::duration<double>(*timeout));
+            }
+            if (!finished) return py::none();
+            return py::int_(task.wait());
+        }, "block until the task ends and return the steps taken (None if timeout runs out first). "
+        "Raises if a step raised", py::arg("timeout") = py::none())
+        .def("__await__", [](py::object self) {
+            // waits on the event loop's default executor, so the loop keeps running
+            py::object loop = py::module_::import("asyncio").attr("get_running_loop")();
+            return loop.attr("run_in_executor")(py::none(), self.attr("wait")).attr("__await__")();
+        });
+
     py::class_<Simulator>(m, "Simulator")
         .def(py::init<float>())
         .def("add_mover", &add_mover, "add mover to simulator", py::arg("type"), py::arg("args"),
         py::arg("interactionParams") = std::unordered_map<std::string, std::vector<py::object>>()
     )
+        .def("add_movers", &add_movers,
+        "add many movers of one type from numpy arrays, built in parallel. Returns the range of their ids",
+        py::arg("type"), py::arg("positions") = py::none(), py::arg("velocities") = py::none(),
+        py::arg("accelerations") = py::none(), py::arg("radii") = py::none(), py::arg("masses") = py::none(),
+        py::arg("params") = std::unordered_map<std::string, std::vector<py::object>>(), py::arg("count") = py::none())
         .def("create_group", &Simulator::create_group, "create group of movers", py::arg("mover_ids"))
         .def("remove_mover", &Simulator::remove_mover, 
             "remove mover from simulator by id. Returns true/false if found and removed", py::arg("id"))
         .def("replace_mover", 
             py::overload_cast<int, Mover*>(&Simulator::replace_mover),
         "replace mover in simulator with new mover. Returns true/false if found and replaced", py::arg("id"), py::arg("replacement_mover"))
-        //two update methods, use py::overload_cast
+        //two update methods, use py::overload_cast. other Python threads run while the simulator steps
         .def("update", py::overload_cast<int>(&Simulator::update),
-    "update simulator by number of steps", py::arg("steps"))
+    "update simulator by number of steps", py::arg("steps"), py::call_guard<py::gil_scoped_release>())
         .def("update", py::overload_cast<>(&Simulator::update),
-    "update simulator by one step")
+    "update simulator by one step", py::call_guard<py::gil_scoped_release>())
+        .def("step_async", [](Simulator& sim, long long steps) { return StepTaskHolder(new StepTask(sim, steps)); },
+        py::keep_alive<0, 1>(),
+        "take steps on a background thread. Returns a StepTask to poll, cancel, wait for or await. "
+        "Until it is done, read state with get_snapshot or get_mover_state; other calls race with the steps",
+        py::arg("steps"))
         .def("add_interaction", &Simulator::add_interaction)
         .def("add_spring_interaction", &add_spring_interaction, 
         "Add a spring interaction to the simulator", py::arg("k"), py::arg("x0"))
@@ -217,9 +624,83 @@ PYBIND11_MODULE(phys_engine, m) {
         "Add magnetic field and apply lorentz effect", py::arg("magneticStrength"))
         .def("add_drag", &add_drag,
         "Add drag force and apply drag effect", py::arg("dragStrength"))
+        .def("add_sampled_force_field", &add_sampled_force_field,
+        "Add a force field sampled on an nx by ny grid covering origin to origin+extent. fx/fy are row major (y, x)",
+        py::arg("fx"), py::arg("fy"), py::arg("nx"), py::arg("ny"), py::arg("origin"), py::arg("extent"), py::arg("bicubic") = false)
+        .def("add_sampled_force_field", &add_sampled_force_field_from_function,
+        "Add a force field by sampling field(position) once onto an nx by ny grid covering origin to origin+extent",
+        py::arg("field"), py::arg("nx"), py::arg("ny"), py::arg("origin"), py::arg("extent"), py::arg("bicubic") = false)
+        .def("add_multi_attractor", &add_multi_attractor, py::return_value_policy::reference_internal,
+        "Add an effect holding many attractors. Returns it, for add_attractor/move_attractor", py::arg("min_distance") = 10.0f)
         .def("add_springGroup", &add_springGroup, 
         "Add a spring interactionGroup to the simulator", py::arg("k"), py::arg("x0"), py::arg("moverIds"))
+        .def("add_expression_group", &add_expression_group,
+        "Add an interactionGroup whose pair force is an expression, e.g. '-k*(r - x0)*rhat'. params are (name, default) "
+        "per-mover values, read as name1/name2 from the movers' 'ExpressionGroup' params",
+        py::arg("force"), py::arg("moverIds"), py::arg("constants") = std::unordered_map<std::string, float>(),
+        py::arg("params") = std::vector<std::pair<std::string, float>>())
+        .def("add_expression_effect", &add_expression_effect,
+        "Add an effect whose force on each mover is an expression, e.g. '-c*speed*vel'. params are (name, default) "
+        "per-mover values, read from the movers' 'ExpressionEffect' params. t is the simulation time",
+        py::arg("force"), py::arg("constants") = std::unordered_map<std::string, float>(),
+        py::arg("params") = std::vector<std::pair<std::string, float>>())
+        .def("load_kernels", [](Simulator& sim, std::string path) { return sim.kernels.load(path); },
+        "Load a shared library of force kernels (see PhysKernelABI.h). Returns the names of the kernels it adds",
+        py::arg("path"))
+        .def("register_kernel", &register_kernel,
+        "Register a kernel from the address of a phys_kernel struct. The struct's functions must stay alive",
+        py::arg("address"))
+        .def_property_readonly("kernel_names", [](Simulator& sim) { return sim.kernels.names(); })
+        .def("add_plugin_group", &add_plugin_group,
+        "Add an interactionGroup running a loaded pair kernel. params are the defaults of its per-mover values, "
+        "read from the movers' 'PluginGroup' params",
+        py::arg("kernel"), py::arg("moverIds"), py::arg("constants") = std::vector<float>(),
+        py::arg("params") = std::vector<float>())
+        .def("add_plugin_effect", &add_plugin_effect,
+        "Add an effect running a loaded effect kernel. params are the defaults of its per-mover values, "
+        "read from the movers' 'PluginEffect' params",
+        py::arg("kernel"), py::arg("constants") = std::vector<float>(), py::arg("params") = std::vector<float>())
+        .def("add_distance_constraint", &Simulator::add_distance_constraint,
+        "Constrain two movers to a fixed distance (current distance if restLength < 0). compliance 0 is rigid",
+        py::arg("id1"), py::arg("id2"), py::arg("restLength") = -1.0f, py::arg("compliance") = 0.0f)
+        .def("add_angle_constraint", &Simulator::add_angle_constraint,
+        "Constrain the angle A-vertex-C (current angle if restAngle is None). compliance 0 is rigid",
+        py::arg("idA"), py::arg("vertexId"), py::arg("idC"), py::arg("restAngle") = py::none(), py::arg("compliance") = 0.0f)
+        .def("add_pin_constraint", &Simulator::add_pin_constraint,
+        "Pin a mover to a point (current position if pinPosition is None). compliance 0 is rigid",
+        py::arg("id"), py::arg("pinPosition") = py::none(), py::arg("compliance") = 0.0f)
+        .def("add_spring_bond", &Simulator::add_spring_bond,
+        "Bond two movers with a spring (current distance if x0 < 0). Returns false if either mover doesn't exist",
+        py::arg("id1"), py::arg("id2"), py::arg("k"), py::arg("x0") = -1.0f)
+        .def("add_spring_bonds", &Simulator::add_spring_bonds,
+        "Add spring bonds ids1[i]-ids2[i]. k and x0 are one value for all bonds or one per bond. Returns number added",
+        py::arg("ids1"), py::arg("ids2"), py::arg("k"), py::arg("x0") = std::vector<float>{-1.0f})
+        .def("set_constraint_iterations", [](Simulator& sim, int iterations) { sim.constraintSolver.iterations = iterations; },
+        "Set the number of constraint solver iterations per step", py::arg("iterations"))
         .def("get_mover_position", &get_mover_position, "get mover position by id", py::arg("id"))
         .def("get_mover_velocity", &get_mover_velocity, "get mover velocity by id", py::arg("id"))
-        .def("report_mover_positions", &report_mover_positions);
+        .def("get_mover_state", &get_mover_state,
+        "dict of ids, positions (n, 2), velocities (n, 2), masses and radii of every mover, in id order")
+        .def("get_positions", [](Simulator& sim) { return get_mover_vects(sim, false); }, "(n, 2) positions in id order")
+        .def("get_velocities", [](Simulator& sim) { return get_mover_vects(sim, true); }, "(n, 2) velocities in id order")
+        .def("set_mover_state", &set_mover_state,
+        "overwrite the given fields of every mover from arrays in id order (as get_mover_state). None leaves a field",
+        py::arg("positions") = py::none(), py::arg("velocities") = py::none(), py::arg("masses") = py::none(),
+        py::arg("radii") = py::none())
+        .def("report_mover_positions", &report_mover_positions)
+        .def("get_snapshot", [](Simulator& sim) { return SimulatorSnapshot(*sim.snapshots.read()); },
+        "copy of the state published at the end of the last step. safe while another thread is stepping")
+        .def("save_checkpoint", &SimulatorCheckpoint::saveFile,
+        "Write movers, groups, walls, bonds, constraints and time to a binary checkpoint file", py::arg("path"))
+        .def("load_checkpoint", &SimulatorCheckpoint::restoreFile,
+        "Replace the state with a checkpoint's. The simulator needs the same interactions and effects as when it was saved",
+        py::arg("path"), py::arg("check_configuration") = true)
+        .def("checkpoint_bytes", [](Simulator& sim) {
+            std::vector<uint8_t> bytes = SimulatorCheckpoint::save(sim);
+            return py::bytes(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }, "Checkpoint as bytes, to fork a run in memory")
+        .def("restore_bytes", [](Simulator& sim, py::bytes bytes, bool checkConfiguration) {
+            std::string_view data = bytes;
+            SimulatorCheckpoint::restore(sim, reinterpret_cast<const uint8_t*>(data.data()), data.size(), checkConfiguration);
+        }, "Replace the state with a checkpoint from checkpoint_bytes", py::arg("data"), py::arg("check_configuration") = true);
 }
\ No newline at end of file
@@ -349,6 +349,7 @@ void MyFrame::StartSimulation() {
 
     // Bind timer event to update logic
     Bind(wxEVT_TIMER, &MyFrame::OnTimer, this);
+    commander->setCommandBudget({0, std::chrono::milliseconds(4)}); //a burst of script commands can't stall a frame
     commander->runSimulator();
 }
 
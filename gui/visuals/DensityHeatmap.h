@@ -0,0 +1,149 @@
+#pragma once
+#include "Vect2.h"
+#include "SimulatorSnapshot.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <future>
+#include <thread>
+
+// Renders movers as a screen-space histogram instead of as circles, for mover counts where circles
+// are unreadable anyway. Each worker bins its share of the movers into its own histogram, the histograms
+// are summed per bin range, and the result is mapped through a colour ramp. Cost is O(N + pixels),
+// independent of mover radius. Output is packed RGBA like SoftwareRasterizer.
+class DensityHeatmap {
+public:
+  enum class Quantity { Density, Speed }; //movers per bin, or mean speed of the movers in a bin
+  Quantity quantity = Quantity::Density;
+  int cellPixels = 2; //bin size in screen pixels
+  bool logScale = true; //log(1 + value) before normalising, so sparse regions stay visible
+  uint32_t background = 0xFF000000;
+
+  DensityHeatmap(int threads = std::max(1u, std::thread::hardware_concurrency()))
+    : threadCount(threads), pool(threads) {}
+
+  // colour stops from low to high, packed RGBA. at least two
+  void setRamp(const std::vector<uint32_t>& stops) {
+    if (stops.size() < 2) return;
+    for (int i = 0; i < 256; i++) {
+      float t = i/255.0f*(stops.size() - 1);
+      int k = std::min((int)t, (int)stops.size() - 2);
+      float f = t - k;
+      uint32_t packed = 0xFF000000;
+      for (int channel = 0; channel < 3; channel++) {
+        float a = (stops[k] >> (8*channel)) & 0xFF;
+        float b = (stops[k + 1] >> (8*channel)) & 0xFF;
+        packed |= (uint32_t)std::lround(a + f*(b - a)) << (8*channel);
+      }
+      lut[i] = packed;
+    }
+    hasRamp = true;
+  }
+
+  // device = world*zoom + deviceOrigin
+  const std::vector<uint32_t>& render(const SimulatorSnapshot& snapshot, float zoom, Vect2 deviceOrigin,
+    int newWidth, int newHeight) {
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    pixels.resize(width*height);
+    if (width == 0 || height == 0) return pixels;
+    if (!hasRamp) setRamp({0xFF000000, 0xFFFF0000, 0xFF00FFFF, 0xFFFFFFFF}); //black, blue, yellow, white
+    int cell = std::max(1, cellPixels);
+    int binsX = (width + cell - 1)/cell, binsY = (height + cell - 1)/cell;
+    int binCount = binsX*binsY;
+
+    // each worker fills its own histogram; capped since every worker costs a screen-sized buffer
+    int n = snapshot.positions.size();
+    int workers = std::max(1, std::min({threadCount, 4, n/16384}));
+    counts.resize(workers);
+    speedSums.resize(workers);
+    std::vector<std::future<void>> futures;
+    for (int w = 0; w < workers; w++) {
+      int start = (long long)n*w/workers;
+      int end = (long long)n*(w + 1)/workers;
+      futures.push_back(pool.enqueue([&, w, start, end]() {
+        auto& count = counts[w];
+        auto& speedSum = speedSums[w];
+        count.assign(binCount, 0);
+        if (quantity == Quantity::Speed) speedSum.assign(binCount, 0);
+        float scale = zoom/cell;
+        Vect2 offset = deviceOrigin/(float)cell;
+        for (int i = start; i < end; i++) {
+          float bx = snapshot.positions[i].x*scale + offset.x;
+          float by = snapshot.positions[i].y*scale + offset.y;
+          if (!(bx >= 0 && bx < binsX && by >= 0 && by < binsY)) continue; //written so NaN positions fail too
+          int bin = (int)by*binsX + (int)bx;
+          if (quantity == Quantity::Speed) {
+            float speed = snapshot.velocities[i].mag();
+            if (!std::isfinite(speed)) continue; //a diverged mover would poison its bin's average
+            speedSum[bin] += speed;
+          }
+          count[bin]++;
+        }
+      }));
+    }
+    for (auto& future : futures) future.get();
+    futures.clear();
+
+    // reduce into per-bin values, tracking the maximum for normalisation
+    values.resize(binCount);
+    int tasks = std::max(1, std::min(threadCount*4, binCount/4096));
+    std::vector<float> taskMax(tasks, 0);
+    for (int t = 0; t < tasks; t++) {
+      int first = (long long)binCount*t/tasks;
+      int last = (long long)binCount*(t + 1)/tasks;
+      futures.push_back(pool.enqueue([&, t, first, last]() {
+        float localMax = 0;
+        for (int bin = first; bin < last; bin++) {
+          uint32_t count = 0;
+          float speed = 0;
+          for (int w = 0; w < workers; w++) {
+            count += counts[w][bin];
+            if (quantity == Quantity::Speed) speed += speedSums[w][bin];
+          }
+          float value = quantity == Quantity::Speed ? (count ? speed/count : 0) : count;
+          if (logScale) value = std::log1p(value);
+          values[bin] = count ? value : -1; //-1 marks empty bins, drawn as background
+          localMax = std::max(localMax, value);
+        }
+        taskMax[t] = localMax;
+      }));
+    }
+    for (auto& future : futures) future.get();
+    futures.clear();
+    float maxValue = *std::max_element(taskMax.begin(), taskMax.end());
+    float toLut = maxValue > 0 ? 255/maxValue : 0;
+
+    // colour the screen, one band of rows per task
+    int bands = std::max(1, std::min(threadCount*4, height));
+    for (int b = 0; b < bands; b++) {
+      int y0 = (long long)height*b/bands;
+      int y1 = (long long)height*(b + 1)/bands;
+      futures.push_back(pool.enqueue([&, y0, y1]() {
+        for (int y = y0; y < y1; y++) {
+          const float* row = &values[(y/cell)*binsX];
+          uint32_t* out = &pixels[y*width];
+          for (int x = 0; x < width; x++) {
+            float value = row[x/cell];
+            out[x] = value < 0 ? background : lut[std::min(255, (int)(value*toLut))];
+          }
+        }
+      }));
+    }
+    for (auto& future : futures) future.get();
+    return pixels;
+  }
+
+private:
+  int threadCount;
+  ThreadPool pool;
+  int width = 0, height = 0;
+  uint32_t lut[256];
+  bool hasRamp = false;
+  std::vector<uint32_t> pixels;
+  std::vector<std::vector<uint32_t>> counts; //[worker][bin]
+  std::vector<std::vector<float>> speedSums; //[worker][bin]
+  std::vector<float> values;
+};
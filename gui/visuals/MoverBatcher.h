@@ -0,0 +1,143 @@
+#pragma once
+#include "Vect2.h"
+#include "SimulatorSnapshot.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// Uniform grid over the movers of one snapshot, for viewport queries.
+// Rebuilt only when a new snapshot is drawn, so panning and zooming a paused simulation don't rescan every mover.
+class SnapshotGrid {
+public:
+  void build(const SimulatorSnapshot& snapshot) {
+    int n = snapshot.positions.size();
+    builtSequence = snapshot.sequence;
+    cellStart.clear();
+    cellMovers.clear();
+    if (n == 0) return;
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    maxRadius = 0;
+    for (int i = 0; i < n; i++) {
+      minX = std::min(minX, snapshot.positions[i].x); maxX = std::max(maxX, snapshot.positions[i].x);
+      minY = std::min(minY, snapshot.positions[i].y); maxY = std::max(maxY, snapshot.positions[i].y);
+      maxRadius = std::max(maxRadius, snapshot.radii[i]);
+    }
+    // about 4 movers per cell
+    origin = Vect2(minX, minY);
+    float area = std::max((maxX - minX)*(maxY - minY), 1.0f);
+    cellSize = std::max(std::sqrt(4*area/n), 1.0f);
+    columns = std::min((int)((maxX - minX)/cellSize) + 1, 1024);
+    rows = std::min((int)((maxY - minY)/cellSize) + 1, 1024);
+    // counting sort of movers into cells
+    std::vector<int> cellOf(n);
+    cellStart.assign(columns*rows + 1, 0);
+    for (int i = 0; i < n; i++) {
+      cellOf[i] = cellIndex(column(snapshot.positions[i].x), row(snapshot.positions[i].y));
+      cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < columns*rows; c++) cellStart[c + 1] += cellStart[c];
+    cellMovers.resize(n);
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < n; i++) cellMovers[fill[cellOf[i]]++] = i;
+  }
+
+  bool isCurrent(const SimulatorSnapshot& snapshot) const {
+    return builtSequence == snapshot.sequence;
+  }
+
+  // calls visit(index) for every mover whose circle may overlap the world-space rectangle
+  template <class Visitor>
+  void query(Vect2 low, Vect2 high, Visitor visit) const {
+    if (cellMovers.empty()) return;
+    // movers are binned by centre, so widen by the largest radius
+    int c0 = column(low.x - maxRadius), c1 = column(high.x + maxRadius);
+    int r0 = row(low.y - maxRadius), r1 = row(high.y + maxRadius);
+    for (int r = r0; r <= r1; r++) {
+      for (int c = c0; c <= c1; c++) {
+        int cell = cellIndex(c, r);
+        for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) visit(cellMovers[i]);
+      }
+    }
+  }
+
+private:
+  int column(float x) const { return std::clamp((int)std::floor((x - origin.x)/cellSize), 0, columns - 1); }
+  int row(float y) const { return std::clamp((int)std::floor((y - origin.y)/cellSize), 0, rows - 1); }
+  int cellIndex(int c, int r) const { return r*columns + c; }
+
+  long long builtSequence = -1;
+  Vect2 origin;
+  float cellSize = 1;
+  float maxRadius = 0;
+  int columns = 0, rows = 0;
+  std::vector<int> cellStart; //movers of cell c are cellMovers[cellStart[c], cellStart[c+1])
+  std::vector<int> cellMovers;
+};
+
+// Turns a snapshot into per-colour draw lists in device (pixel) coordinates.
+// Movers outside the viewport are culled, and movers are drawn with the cheapest primitive that still looks right:
+// full circles when large, filled squares when a few pixels across, single pixels below that.
+// Sub-pixel movers landing on an already drawn pixel are dropped.
+class MoverBatcher {
+public:
+  struct Circle { float x, y, radius; };
+  struct Square { int x, y, size; };
+  struct Pixel { int x, y; };
+  struct Batch { //everything drawn in one palette colour
+    std::vector<Circle> circles;
+    std::vector<Square> squares;
+    std::vector<Pixel> pixels;
+  };
+
+  float circleMinRadius = 2.0f; //pixel radius below which circles become squares
+  float squareMinRadius = 0.5f; //pixel radius below which squares become single pixels
+
+  // device = world*zoom + deviceOrigin, as set with SetUserScale/SetDeviceOrigin
+  const std::vector<Batch>& batch(const SimulatorSnapshot& snapshot, int paletteSize,
+    float zoom, Vect2 deviceOrigin, int width, int height) {
+    if (batches.size() != paletteSize) batches.assign(paletteSize, Batch());
+    for (auto& b : batches) {
+      b.circles.clear();
+      b.squares.clear();
+      b.pixels.clear();
+    }
+    drawnCount = 0;
+    if (width <= 0 || height <= 0 || paletteSize <= 0) return batches;
+    if (!grid.isCurrent(snapshot)) grid.build(snapshot);
+    pixelTaken.assign(width*height, 0);
+
+    Vect2 low = (Vect2(0, 0) - deviceOrigin)/zoom;
+    Vect2 high = (Vect2(width, height) - deviceOrigin)/zoom;
+    grid.query(low, high, [&](int i) {
+      float x = snapshot.positions[i].x*zoom + deviceOrigin.x;
+      float y = snapshot.positions[i].y*zoom + deviceOrigin.y;
+      float r = snapshot.radii[i]*zoom;
+      if (x + r < 0 || y + r < 0 || x - r >= width || y - r >= height) return; //grid cells overhang the view
+      Batch& b = batches[snapshot.ids[i] % paletteSize];
+      if (r >= circleMinRadius) {
+        b.circles.push_back({x, y, r});
+      } else if (r >= squareMinRadius) {
+        int size = std::max(1, (int)std::lround(2*r));
+        b.squares.push_back({(int)(x - r), (int)(y - r), size});
+      } else {
+        int px = (int)x, py = (int)y;
+        if (px < 0 || py < 0 || px >= width || py >= height) return;
+        uint8_t& taken = pixelTaken[py*width + px];
+        if (taken) return;
+        taken = 1;
+        b.pixels.push_back({px, py});
+      }
+      drawnCount++;
+    });
+    return batches;
+  }
+
+  int lastDrawnCount() const { return drawnCount; };
+
+private:
+  SnapshotGrid grid;
+  std::vector<Batch> batches;
+  std::vector<uint8_t> pixelTaken;
+  int drawnCount = 0;
+};
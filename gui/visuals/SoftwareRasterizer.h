@@ -0,0 +1,158 @@
+#pragma once
+#include "Vect2.h"
+#include "SimulatorSnapshot.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <future>
+#include <thread>
+
+// Draws a snapshot's movers and walls into an RGBA pixel buffer on the CPU, in parallel.
+// The screen is split into square tiles. Movers are first binned into the tiles their circle touches
+// (each worker keeps its own bins, so binning takes no locks), then every tile is rasterized by one task.
+// A tile is only ever written by its own task, so pixels need no synchronisation.
+// Pixels are packed 0xAABBGGRR, i.e. bytes R, G, B, A in memory on little-endian machines.
+class SoftwareRasterizer {
+public:
+  static constexpr int tileSize = 64;
+  uint32_t background = packRGBA(0, 0, 0);
+  uint32_t wallColor = packRGBA(255, 255, 255);
+
+  SoftwareRasterizer(int threads = std::max(1u, std::thread::hardware_concurrency()))
+    : threadCount(threads), pool(threads) {}
+
+  static uint32_t packRGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+  }
+
+  // device = world*zoom + deviceOrigin. palette is packed RGBA, mover colour is palette[id % size]
+  const std::vector<uint32_t>& render(const SimulatorSnapshot& snapshot, const std::vector<uint32_t>& palette,
+    float zoom, Vect2 deviceOrigin, int newWidth, int newHeight) {
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    pixels.resize(width*height);
+    if (width == 0 || height == 0) return pixels;
+    tilesX = (width + tileSize - 1)/tileSize;
+    tilesY = (height + tileSize - 1)/tileSize;
+    int tileCount = tilesX*tilesY;
+
+    // bin movers into tiles, one set of bins per worker
+    int n = snapshot.positions.size();
+    int binners = std::max(1, std::min(threadCount, n/4096));
+    bins.resize(binners);
+    std::vector<std::future<void>> futures;
+    for (int w = 0; w < binners; w++) {
+      int start = (long long)n*w/binners;
+      int end = (long long)n*(w + 1)/binners;
+      futures.push_back(pool.enqueue([this, w, start, end, tileCount, &snapshot, zoom, deviceOrigin]() {
+        auto& workerBins = bins[w];
+        workerBins.resize(tileCount);
+        for (auto& bin : workerBins) bin.clear();
+        for (int i = start; i < end; i++) {
+          float x = snapshot.positions[i].x*zoom + deviceOrigin.x;
+          float y = snapshot.positions[i].y*zoom + deviceOrigin.y;
+          float r = std::max(snapshot.radii[i]*zoom, 0.5f); //everything on screen covers at least its centre pixel
+          // written so NaN and infinite movers fail it too, then clamped to the screen so the casts stay in range
+          if (!(std::isfinite(x) && std::isfinite(y) && std::isfinite(r) && x + r >= 0 && y + r >= 0 && x - r < width
+            && y - r < height)) continue;
+          int tx0 = (int)std::max(x - r, 0.0f)/tileSize, tx1 = (int)std::min(x + r, width - 1.0f)/tileSize;
+          int ty0 = (int)std::max(y - r, 0.0f)/tileSize, ty1 = (int)std::min(y + r, height - 1.0f)/tileSize;
+          for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) workerBins[ty*tilesX + tx].push_back({x, y, r, i});
+          }
+        }
+      }));
+    }
+    for (auto& future : futures) future.get();
+    futures.clear();
+
+    // walls in device coordinates, drawn by every tile they cross
+    walls.clear();
+    for (int i = 0; i < snapshot.wallStarts.size(); i++) {
+      walls.push_back({snapshot.wallStarts[i]*zoom + deviceOrigin, snapshot.wallEnds[i]*zoom + deviceOrigin});
+    }
+
+    // rasterize tiles, a few per task
+    int tilesPerTask = std::max(1, tileCount/(threadCount*4));
+    for (int first = 0; first < tileCount; first += tilesPerTask) {
+      int last = std::min(tileCount, first + tilesPerTask);
+      futures.push_back(pool.enqueue([this, first, last, binners, &snapshot, &palette]() {
+        for (int tile = first; tile < last; tile++) rasterizeTile(tile, binners, snapshot, palette);
+      }));
+    }
+    for (auto& future : futures) future.get();
+    return pixels;
+  }
+
+  int bufferWidth() const { return width; };
+  int bufferHeight() const { return height; };
+
+private:
+  struct BinnedMover { float x, y, r; int index; };
+  struct DeviceWall { Vect2 start, end; };
+
+  void rasterizeTile(int tile, int binners, const SimulatorSnapshot& snapshot, const std::vector<uint32_t>& palette) {
+    int x0 = (tile % tilesX)*tileSize, y0 = (tile / tilesX)*tileSize;
+    int x1 = std::min(x0 + tileSize, width), y1 = std::min(y0 + tileSize, height);
+    for (int y = y0; y < y1; y++) std::fill(&pixels[y*width + x0], &pixels[y*width + x1], background);
+    for (int w = 0; w < binners; w++) {
+      for (const BinnedMover& m : bins[w][tile]) {
+        uint32_t color = palette.empty() ? wallColor : palette[snapshot.ids[m.index] % palette.size()];
+        // pixel centres within r of the mover centre, clipped to the tile (before the casts, r may be huge)
+        auto clipped = [](float v, int low, int high) { return std::clamp(v, (float)low - 1, (float)high + 1); };
+        int px0 = std::max(x0, (int)std::ceil(clipped(m.x - m.r - 0.5f, x0, x1)));
+        int px1 = std::min(x1 - 1, (int)std::floor(clipped(m.x + m.r - 0.5f, x0, x1)));
+        int py0 = std::max(y0, (int)std::ceil(clipped(m.y - m.r - 0.5f, y0, y1)));
+        int py1 = std::min(y1 - 1, (int)std::floor(clipped(m.y + m.r - 0.5f, y0, y1)));
+        float r2 = m.r*m.r;
+        for (int py = py0; py <= py1; py++) {
+          float dy = py + 0.5f - m.y;
+          uint32_t* row = &pixels[py*width];
+          for (int px = px0; px <= px1; px++) {
+            float dx = px + 0.5f - m.x;
+            if (dx*dx + dy*dy <= r2) row[px] = color;
+          }
+        }
+        // tiny movers whose circle misses every pixel centre still get their centre pixel
+        if (px0 > px1 || py0 > py1) {
+          if (m.x >= x0 && m.x < x1 && m.y >= y0 && m.y < y1) pixels[(int)m.y*width + (int)m.x] = color;
+        }
+      }
+    }
+    for (const DeviceWall& wall : walls) drawLineInTile(wall, x0, y0, x1, y1);
+  }
+
+  void drawLineInTile(const DeviceWall& wall, int x0, int y0, int x1, int y1) {
+    // clip the segment to the tile (Liang-Barsky), then take one sample per pixel along its major axis
+    Vect2 d = wall.end - wall.start;
+    float tMin = 0, tMax = 1;
+    float p[4] = {-d.x, d.x, -d.y, d.y};
+    float q[4] = {wall.start.x - x0, x1 - wall.start.x, wall.start.y - y0, y1 - wall.start.y};
+    for (int k = 0; k < 4; k++) {
+      if (p[k] == 0) {
+        if (q[k] < 0) return; //parallel to and outside this edge
+        continue;
+      }
+      float t = q[k]/p[k];
+      if (p[k] < 0) tMin = std::max(tMin, t);
+      else tMax = std::min(tMax, t);
+    }
+    if (tMin > tMax) return;
+    int steps = std::max(1, (int)std::ceil((tMax - tMin)*std::max(std::abs(d.x), std::abs(d.y))));
+    for (int s = 0; s <= steps; s++) {
+      float t = tMin + (tMax - tMin)*s/steps;
+      int px = (int)std::floor(wall.start.x + t*d.x), py = (int)std::floor(wall.start.y + t*d.y);
+      if (px >= x0 && px < x1 && py >= y0 && py < y1) pixels[py*width + px] = wallColor;
+    }
+  }
+
+  int threadCount;
+  ThreadPool pool;
+  int width = 0, height = 0;
+  int tilesX = 0, tilesY = 0;
+  std::vector<uint32_t> pixels;
+  std::vector<std::vector<std::vector<BinnedMover>>> bins; //[worker][tile]
+  std::vector<DeviceWall> walls;
+};
@@ -22,6 +22,15 @@ int Simulator::add_mover(std::type_index type, MoverArgs args,
     return id;
 }
 
+int Simulator::add_movers(std::type_index type, const MoverArrays& arrays,
+    std::unordered_map<std::type_index, std::vector<std::any>> interactionParams) {
+    int firstId = factory.nextMoverId();
+    auto created = factory.createMovers(type, arrays, std::move(interactionParams), &threadPool);
+    movers.reserve(movers.size() + created.size());
+    std::move(created.begin(), created.end(), std::back_inserter(movers)); //ids are above every existing id, so order holds
+    return firstId;
+}
+
 bool Simulator::remove_mover(int id) {
     //assume ids are sorted, do binary search
     //if adding movers is done on multiple threads, will need to make this thread safe
@@ -36,14 +45,27 @@ bool Simulator::remove_mover(int id) {
 }
 
 bool Simulator::remove_movers(std::vector<int>& ids) {
-    bool found_any=false;
-    for (auto& id : ids) {
-        auto it = find_mover(id);
-        if (it != movers.end()) {
-            movers.erase(it); //mover is destroyed. RigidConnectedMover should remove itself from group
-            found_any=true;
+    // one erase-remove pass over movers instead of an erase (and shift) per id.
+    // groups losing members are held in an edit so each is rebuilt once at the end
+    std::unordered_set<int> ids_set(ids.begin(), ids.end());
+    auto toRemove = [&ids_set](const std::unique_ptr<Mover>& mover) {
+        return ids_set.count(mover->id) > 0;
+    };
+    std::unordered_set<RigidConnectedGroup*> editedGroups;
+    for (auto& mover : movers) {
+        if (!toRemove(mover)) continue;
+        auto rigidMover = dynamic_cast<RigidConnectedMover*>(mover.get());
+        if (rigidMover != nullptr && rigidMover->group != nullptr
+            && editedGroups.insert(rigidMover->group).second) {
+            rigidMover->group->beginEdit();
         }
     }
+    auto newEnd = std::remove_if(movers.begin(), movers.end(), toRemove);
+    bool found_any = newEnd != movers.end();
+    movers.erase(newEnd, movers.end()); //movers are destroyed. RigidConnectedMover removes itself from group
+    for (auto group : editedGroups) {
+        group->endEdit();
+    }
     return found_any;
 }
 
@@ -81,20 +103,66 @@ void Simulator::create_group(std::vector<int>& mover_ids) {
 
     std::vector<RigidConnectedMover*> connectedMovers;
     std::unordered_set<int> mover_ids_set(mover_ids.begin(), mover_ids.end());
+    connectedMovers.reserve(mover_ids_set.size());
+    std::unordered_set<RigidConnectedGroup*> editedGroups;
     for (int id : mover_ids_set) {
         auto it = find_mover(id);
         if (it != movers.end()) {
             RigidConnectedMover* mover = new RigidConnectedMover(*(*it), nullptr);
             mover->id = id;
             connectedMovers.push_back(mover);
+            holdGroupForEdit((*it).get(), editedGroups);
             (*it).reset(mover);
         }
     }
+    for (auto group : editedGroups) {
+        group->endEdit();
+    }
     groups.push_back(
         std::make_unique<RigidConnectedGroup>(connectedMovers)
     );
 }
 
+void Simulator::edit_group(RigidConnectedGroup* group, std::vector<int>& add_ids, std::vector<int>& remove_ids) {
+    // applies membership changes to an existing group in one pass.
+    // added movers are converted to RigidConnectedMovers, removed movers are converted back to NewtMovers
+    if (group == nullptr) return;
+    std::unordered_set<RigidConnectedGroup*> editedGroups = {group};
+    group->beginEdit();
+    for (int id : std::unordered_set<int>(remove_ids.begin(), remove_ids.end())) {
+        auto it = find_mover(id);
+        if (it == movers.end()) continue;
+        auto rigidMover = dynamic_cast<RigidConnectedMover*>((*it).get());
+        if (rigidMover == nullptr || rigidMover->group != group) continue;
+        std::unique_ptr<Mover> converted = rigidMover->cloneToNewtMover();
+        (*it).swap(converted); //old mover leaves the group as it is destroyed here
+    }
+    std::vector<RigidConnectedMover*> connectedMovers;
+    for (int id : std::unordered_set<int>(add_ids.begin(), add_ids.end())) {
+        auto it = find_mover(id);
+        if (it == movers.end()) continue;
+        auto rigidMover = dynamic_cast<RigidConnectedMover*>((*it).get());
+        if (rigidMover != nullptr && rigidMover->group == group) continue; //already a member
+        RigidConnectedMover* mover = new RigidConnectedMover(*(*it), nullptr);
+        mover->id = id;
+        connectedMovers.push_back(mover);
+        holdGroupForEdit((*it).get(), editedGroups);
+        (*it).reset(mover);
+    }
+    group->addMovers(connectedMovers);
+    for (auto editedGroup : editedGroups) {
+        editedGroup->endEdit();
+    }
+}
+
+void Simulator::holdGroupForEdit(Mover* mover, std::unordered_set<RigidConnectedGroup*>& editedGroups) {
+    // if mover belongs to a group, begin an edit on that group (once) so that
+    // destroying its members does not rebuild the group every time
+    auto rigidMover = dynamic_cast<RigidConnectedMover*>(mover);
+    if (rigidMover == nullptr || rigidMover->group == nullptr) return;
+    if (editedGroups.insert(rigidMover->group).second) rigidMover->group->beginEdit();
+}
+
 void Simulator::ungroup(RigidConnectedGroup* group) {
     // replace all movers in group with NewtMovers,
     // and remove group from simulator
@@ -129,10 +197,15 @@ void Simulator::delete_group(RigidConnectedGroup* group) {
     //get ids
     std::vector<int> mover_ids;
     if (group == nullptr) return;
+    mover_ids.reserve(group->movers.size());
     for (auto& mover : group->movers) {
         mover_ids.push_back(mover->id);
     }
-    ungroup(group);
+    //drop the group first (detaching its movers), no need to convert movers that are about to be deleted
+    auto predicate = [group](std::unique_ptr<RigidConnectedGroup>& group_to_check) {
+        return group_to_check.get() == group;
+    };
+    groups.erase(std::remove_if(groups.begin(), groups.end(), predicate), groups.end());
     remove_movers(mover_ids);
 };
 
@@ -165,17 +238,83 @@ void Simulator::add_effect(Effect* effect, std::vector<std::any> default_params)
     }
 }
 
+bool Simulator::add_spring_bond(int id1, int id2, float k, float x0) {
+    auto it1 = find_mover(id1);
+    auto it2 = find_mover(id2);
+    if (it1 == movers.end() || it2 == movers.end() || id1 == id2) return false;
+    if (x0 < 0) x0 = ((*it1)->position - (*it2)->position).mag();
+    bondNetwork.addBond(id1, id2, k, x0);
+    return true;
+}
+
+int Simulator::add_spring_bonds(const std::vector<int>& ids1, const std::vector<int>& ids2, const std::vector<float>& k, const std::vector<float>& x0) {
+    int n = ids1.size();
+    if (ids2.size() != n) throw std::invalid_argument("add_spring_bonds: ids1 and ids2 must be the same length");
+    if (k.size() != 1 && k.size() != n) throw std::invalid_argument("add_spring_bonds: k must have 1 or len(ids1) values");
+    if (x0.size() != 1 && x0.size() != n) throw std::invalid_argument("add_spring_bonds: x0 must have 1 or len(ids1) values");
+    int added = 0;
+    for (int i = 0; i < n; i++) {
+        float bondK = k.size() == 1 ? k[0] : k[i];
+        float bondX0 = x0.size() == 1 ? x0[0] : x0[i];
+        if (add_spring_bond(ids1[i], ids2[i], bondK, bondX0)) added++;
+    }
+    return added;
+}
+
+void Simulator::add_constraint(Constraint* constraint) {
+    constraintSolver.addConstraint(constraint);
+}
+
+bool Simulator::add_distance_constraint(int id1, int id2, float restLength, float compliance) {
+    // returns false if either mover doesn't exist
+    auto it1 = find_mover(id1);
+    auto it2 = find_mover(id2);
+    if (it1 == movers.end() || it2 == movers.end()) return false;
+    if (restLength < 0) restLength = ((*it1)->position - (*it2)->position).mag();
+    constraintSolver.addConstraint(new DistanceConstraint(id1, id2, restLength, compliance));
+    return true;
+}
+
+bool Simulator::add_angle_constraint(int idA, int vertexId, int idC, std::optional<float> restAngle, float compliance) {
+    auto itA = find_mover(idA);
+    auto itVertex = find_mover(vertexId);
+    auto itC = find_mover(idC);
+    if (itA == movers.end() || itVertex == movers.end() || itC == movers.end()) return false;
+    if (!restAngle) {
+        Vect2 u = (*itA)->position - (*itVertex)->position;
+        Vect2 v = (*itC)->position - (*itVertex)->position;
+        restAngle = atan2(u.cross(v), u.dot(v));
+    }
+    constraintSolver.addConstraint(new AngleConstraint(idA, vertexId, idC, restAngle.value(), compliance));
+    return true;
+}
+
+bool Simulator::add_pin_constraint(int id, std::optional<Vect2> pinPosition, float compliance) {
+    auto it = find_mover(id);
+    if (it == movers.end()) return false;
+    if (!pinPosition) pinPosition = (*it)->position;
+    constraintSolver.addConstraint(new PinConstraint(id, pinPosition.value(), compliance));
+    return true;
+}
+
 void Simulator::add_interactingGroup(std::vector<int>& mover_ids, std::function<void(Mover&, Mover&)> interaction) {
     auto smartPtr = std::make_unique<InteractingGroup>(*this, mover_ids, interaction);
     interactingGroups.push_back(std::move(smartPtr));
 }
 
+void Simulator::add_interactingGroup(std::unique_ptr<InteractingGroup> group) {
+    interactingGroups.push_back(std::move(group));
+}
+
 void Simulator::update() {
     std::lock_guard<std::mutex> lock(updateLock);
     int item_count = movers.size();
     int thread_count = std::thread::hardware_concurrency(); 
     std::vector<std::future<void>> futures;
     int chunk_size = item_count / thread_count;
+    for (auto& effect : effects) {
+        effect->prepare();
+    }
     for (int i_thread = 0; i_thread < thread_count; i_thread++) {
         int start = i_thread * chunk_size;
         int end = start + chunk_size;
@@ -192,9 +331,9 @@ void Simulator::update() {
                             interaction->interact(&mover1, &mover2); 
                             }
                     }
-                    for (auto& effect : effects) {
-                        effect->apply(&mover1);
-                    }
+                }
+                for (auto& effect : effects) {
+                    effect->applyRange(movers, start, end);
                 }
             })
         );
@@ -206,9 +345,8 @@ void Simulator::update() {
     }
     futures.clear();
     //update interacting groups
-    for (auto& group : interactingGroups) {
-        group->applyInteractions(); //should modify this to run multithreaded
-    }
+    apply_interactingGroups(thread_count);
+    bondNetwork.apply(movers, &threadPool);
 
     //update movers using threadPool
     for (int i_thread = 0; i_thread < thread_count; i_thread++) {
@@ -236,7 +374,54 @@ void Simulator::update() {
     for (auto& future : futures) {
         future.get(); 
     }
+    //project constraints onto the integrated positions
+    constraintSolver.solve(movers, global_dt, &threadPool);
     current_time += global_dt;
+    step_count++;
+    if (publishSnapshots) publish_snapshot();
+}
+
+void Simulator::apply_interactingGroups(int thread_count) {
+    // members are resolved on this thread, then pairs are spread over the pool.
+    // large groups are split into row ranges, small groups are batched so each task has a worthwhile amount of work
+    // apply_force is atomic, so tasks touching the same mover (overlapping groups) are safe
+    const long long minPairsPerTask = 4096;
+    std::vector<std::future<void>> futures;
+    std::vector<InteractingGroup*> batch;
+    long long batchPairs = 0;
+    auto flushBatch = [&]() {
+        if (batch.empty()) return;
+        futures.push_back(threadPool.enqueue([batch]() {
+            for (auto group : batch) group->applyPairs(0, group->moverIds.size());
+        }));
+        batch.clear();
+        batchPairs = 0;
+    };
+    // every group is resolved before any task starts, so a group that throws here leaves no tasks running
+    for (auto& group : interactingGroups) group->resolveMembers();
+    for (auto& group : interactingGroups) {
+        long long pairs = group->pairCount();
+        if (pairs >= 2*minPairsPerTask) {
+            int chunks = std::min<long long>(thread_count, pairs / minPairsPerTask);
+            std::vector<int> splits = group->rowSplits(chunks);
+            for (int i = 0; i + 1 < splits.size(); i++) {
+                InteractingGroup* groupPtr = group.get();
+                int rowStart = splits[i];
+                int rowEnd = splits[i+1];
+                futures.push_back(threadPool.enqueue([groupPtr, rowStart, rowEnd]() {
+                    groupPtr->applyPairs(rowStart, rowEnd);
+                }));
+            }
+            continue;
+        }
+        batch.push_back(group.get());
+        batchPairs += pairs;
+        if (batchPairs >= minPairsPerTask) flushBatch();
+    }
+    flushBatch();
+    for (auto& future : futures) {
+        future.get();
+    }
 }
 
 void Simulator::update(int steps) {
@@ -246,6 +431,10 @@ void Simulator::update(int steps) {
 }
 
 void Simulator::update_unithread() {
+    bondNetwork.apply(movers);
+    for (auto& effect : effects) {
+        effect->prepare();
+    }
     for (int i = 0; i < movers.size(); i++) { 
         Mover& mover1 = *movers[i];
         for (int j = i+1; j < movers.size(); j++){ 
@@ -255,11 +444,81 @@ void Simulator::update_unithread() {
                 } //why pass pointers? maybe just pass refs... would need to change in Interaction
         }
         for (auto& effect : effects) {
-            effect->apply(&mover1);
+            effect->applyRange(movers, i, i + 1);
         }
         mover1.update(global_dt);
     }
-}    
+    constraintSolver.solve(movers, global_dt);
+    step_count++;
+    if (publishSnapshots) publish_snapshot();
+}
+
+void Simulator::publish_snapshot() {
+    // copies into a buffer no reader holds. skipped, rather than waiting, if readers hold them all
+    SimulatorSnapshot* snapshot = snapshots.beginWrite();
+    if (snapshot == nullptr) return;
+    snapshot->time = current_time;
+    snapshot->step = step_count;
+    snapshot->sequence = snapshots.publishCount() + 1;
+    int n = movers.size();
+    snapshot->ids.resize(n);
+    snapshot->positions.resize(n);
+    snapshot->velocities.resize(n);
+    snapshot->radii.resize(n);
+    for (int i = 0; i < n; i++) {
+        const Mover& mover = *movers[i];
+        snapshot->ids[i] = mover.id;
+        snapshot->positions[i] = mover.position;
+        snapshot->velocities[i] = mover.velocity;
+        snapshot->radii[i] = mover.radius;
+    }
+    snapshot->wallStarts.resize(walls.size());
+    snapshot->wallEnds.resize(walls.size());
+    for (int i = 0; i < walls.size(); i++) {
+        snapshot->wallStarts[i] = walls[i]->pointA;
+        snapshot->wallEnds[i] = walls[i]->pointB;
+    }
+    snapshots.publish();
+}
+
+void Simulator::get_mover_state(size_t count, int* ids, Vect2* positions, Vect2* velocities, float* masses, float* radii) {
+    // one pass per requested field, so each output array is written sequentially
+    std::lock_guard<std::mutex> lock(updateLock);
+    check_mover_count(count, "get_mover_state");
+    int n = movers.size();
+    if (ids) for (int i = 0; i < n; i++) ids[i] = movers[i]->id;
+    if (positions) for (int i = 0; i < n; i++) positions[i] = movers[i]->position;
+    if (velocities) for (int i = 0; i < n; i++) velocities[i] = movers[i]->velocity;
+    if (masses) for (int i = 0; i < n; i++) masses[i] = movers[i]->mass;
+    if (radii) for (int i = 0; i < n; i++) radii[i] = movers[i]->radius;
+}
+
+void Simulator::set_mover_state(size_t count, const Vect2* positions, const Vect2* velocities, const float* masses,
+    const float* radii) {
+    std::lock_guard<std::mutex> lock(updateLock);
+    check_mover_count(count, "set_mover_state");
+    int n = movers.size();
+    if (masses) {
+        for (int i = 0; i < n; i++) {
+            if (masses[i] == 0 && dynamic_cast<NewtMover*>(movers[i].get()) != nullptr) {
+                throw std::invalid_argument("set_mover_state: mover " + std::to_string(movers[i]->id) + " takes forces and can't have zero mass");
+            }
+        }
+    }
+    if (positions) for (int i = 0; i < n; i++) movers[i]->position = positions[i];
+    if (velocities) for (int i = 0; i < n; i++) movers[i]->velocity = velocities[i];
+    if (masses) for (int i = 0; i < n; i++) movers[i]->mass = masses[i];
+    if (radii) for (int i = 0; i < n; i++) movers[i]->radius = radii[i];
+    if (publishSnapshots) publish_snapshot();
+}
+
+void Simulator::check_mover_count(size_t count, const char* caller) const {
+    // the arrays were sized by the caller before taking the lock, the movers may have changed since
+    if (count != movers.size()) {
+        throw std::invalid_argument(std::string(caller) + ": arrays are for " + std::to_string(count) + " movers, the simulator has "
+                                    + std::to_string(movers.size()));
+    }
+}
 
 std::vector<std::unique_ptr<Mover>>::iterator Simulator::find_mover(int id) {  
     //returns iterator to mover in movers with given id
@@ -281,7 +540,11 @@ void Simulator::reset() {
     interactions.clear();
     groups.clear();
     interactingGroups.clear();
+    bondNetwork.clear();
+    constraintSolver.clear();
     current_id = 0;
     current_time = 0;
+    step_count = 0;
     factory = MoverFactory();
+    if (publishSnapshots) publish_snapshot(); //readers shouldn't keep seeing the old movers
 }
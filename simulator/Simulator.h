@@ -6,7 +6,13 @@
 #include "Effect.h"
 #include "RigidMovers.h"
 #include "InteractingGroup.h"
+#include "BondNetwork.h"
+#include "KernelRegistry.h"
 #include "Wall.h"
+#include "ConstraintSolver.h"
+#include "DistanceConstraint.h"
+#include "AngleConstraint.h"
+#include "PinConstraint.h"
 #include <vector>
 #include <unordered_set>
 #include <memory>
@@ -16,6 +22,8 @@
 #include <thread>
 #include "ThreadGuard.h"
 #include "ThreadPool.h"
+#include "TripleBuffer.h"
+#include "SimulatorSnapshot.h"
 
 /* 
 Simulator holds the simulation objects with metadata. Facilitates interactions between objects.
@@ -24,45 +32,88 @@ Kinds of interacitons enabled are defined in this object
  */
 //forward declarations
 class InteractingGroup;
+template <class Kernel> class TypedInteractingGroup;
 
 class Simulator {
 public:
     float global_dt;
     int current_id = 0;
     float current_time = 0;
+    long long step_count = 0;
     MoverFactory factory = MoverFactory();
+    KernelRegistry kernels; //plugin force kernels. declared before the groups and effects using them, so it outlives them
     std::vector< std::unique_ptr<Mover>> movers;
     std::vector< std::unique_ptr<Wall>> walls;
     std::vector< std::unique_ptr<Interaction>> interactions;
     std::vector< std::unique_ptr<Effect>> effects;
     std::vector< std::unique_ptr<RigidConnectedGroup> > groups;
     std::vector<std::unique_ptr<InteractingGroup>> interactingGroups;
+    BondNetwork bondNetwork; //explicit spring bonds, evaluated after interacting groups
+    ConstraintSolver constraintSolver; //position-based constraints, solved after movers are integrated
     float interaction_min_distance = 1;
     ThreadPool threadPool = ThreadPool(std::thread::hardware_concurrency());
+    // state published at the end of every step. read from any thread with snapshots.read()
+    TripleBuffer<SimulatorSnapshot> snapshots;
+    bool publishSnapshots = true;
 
     Simulator(float dt);
 
     int add_mover(std::type_index type, MoverArgs args = MoverArgs(), 
         std::unordered_map<std::type_index, std::vector<std::any>> interactionParams
          = std::unordered_map<std::type_index, std::vector<std::any>>()); //returns id of mover
+    // arrays.count movers of one type from arrays (see MoverArrays), built on the thread pool.
+    // returns the first id, the others follow consecutively. throws std::invalid_argument, adding none, on bad input
+    int add_movers(std::type_index type, const MoverArrays& arrays,
+        std::unordered_map<std::type_index, std::vector<std::any>> interactionParams
+         = std::unordered_map<std::type_index, std::vector<std::any>>());
     bool remove_mover(int id);
     bool remove_movers(std::vector<int>& ids);
     bool replace_mover(int id, Mover* mover);
     bool replace_mover(int id, std::unique_ptr<Mover> mover);
     void create_group(std::vector<int>& mover_ids);
+    void edit_group(RigidConnectedGroup* group, std::vector<int>& add_ids, std::vector<int>& remove_ids);
     void ungroup(RigidConnectedGroup* group);
     void delete_group(RigidConnectedGroup* group);
     void add_interactingGroup(std::vector<int>& mover_ids, std::function<void(Mover&, Mover&)> interaction);
+    template <class Kernel>
+    void add_interactingGroup(std::vector<int>& mover_ids, Kernel kernel); //typed kernel, no std::function per pair
+    void add_interactingGroup(std::unique_ptr<InteractingGroup> group); //e.g. an ExpressionInteractingGroup
     void remove_interactingGroup(int id);
     void remove_interactingGroupByMoverId(int moverId); //find group with moverId and remove it
     void add_interaction(Interaction* interaction, std::vector<std::any> default_params = std::vector<std::any>());
     void add_effect(Effect* effect, std::vector<std::any> default_params = std::vector<std::any>());
     void add_wall(const Vect2& pointA, const Vect2& pointB);
+    // x0 < 0 uses the current distance between the movers. returns false if either mover doesn't exist
+    bool add_spring_bond(int id1, int id2, float k, float x0 = -1);
+    // k and x0 hold either one value for every bond or one per bond. returns the number of bonds added
+    int add_spring_bonds(const std::vector<int>& ids1, const std::vector<int>& ids2, const std::vector<float>& k, const std::vector<float>& x0);
+    void add_constraint(Constraint* constraint);
+    //negative restLength / missing restAngle / missing pin position: use the current configuration
+    bool add_distance_constraint(int id1, int id2, float restLength = -1, float compliance = 0);
+    bool add_angle_constraint(int idA, int vertexId, int idC, std::optional<float> restAngle = std::nullopt, float compliance = 0);
+    bool add_pin_constraint(int id, std::optional<Vect2> pinPosition = std::nullopt, float compliance = 0);
     void update();
     void update(int steps);
     void update_unithread();
     std::vector<std::unique_ptr<Mover>>::iterator find_mover(int id); // returns iterator to mover with id
     void reset();
+    void publish_snapshot(); //done after each step, call after changing movers outside a step to show them
+    // bulk state in mover order (ascending id): each array holds count entries, nullptr skips a field.
+    // both wait for a running update to finish, then throw std::invalid_argument, changing nothing, if count isn't
+    // movers.size() by then. set also throws if a mover that takes forces would get zero mass.
+    // members of rigid groups are moved by their group, so set their group instead
+    void get_mover_state(size_t count, int* ids, Vect2* positions, Vect2* velocities, float* masses, float* radii);
+    void set_mover_state(size_t count, const Vect2* positions, const Vect2* velocities, const float* masses,
+        const float* radii);
     private:
     std::mutex updateLock; //ensure only one thread can trigger an update at a time
-};
\ No newline at end of file
+    void check_mover_count(size_t count, const char* caller) const;
+    void holdGroupForEdit(Mover* mover, std::unordered_set<RigidConnectedGroup*>& editedGroups);
+    void apply_interactingGroups(int thread_count);
+};
+
+template <class Kernel>
+void Simulator::add_interactingGroup(std::vector<int>& mover_ids, Kernel kernel) {
+    auto smartPtr = std::make_unique<TypedInteractingGroup<Kernel>>(*this, mover_ids, kernel);
+    interactingGroups.push_back(std::move(smartPtr));
+}
\ No newline at end of file
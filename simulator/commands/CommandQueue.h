@@ -0,0 +1,165 @@
+#pragma once
+#include "SimulatorCommand.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+class CommandQueue
+// Lock-free multi-producer, single-consumer queue of commands, so the GUI and Python threads never wait on the
+// thread applying them. Commands are built in place in pooled records: a record is taken from a free list on push
+// and returned to it on release, so a steady stream of commands doesn't allocate once the pool has grown to fit.
+// The queue is Vyukov's intrusive MPSC queue. The free list is a stack of record indices with a version tag beside
+// the head index, so a record popped and pushed back between another producer's read and swap can't be mistaken
+// for an unchanged head.
+// push may be called from any thread. pop, release and empty only from one consumer at a time.
+{
+public:
+  static constexpr size_t INLINE_BYTES = 192; //commands larger than this are allocated separately
+
+  struct Record {
+    SimulatorCommand* command = nullptr;
+  private:
+    friend class CommandQueue;
+    std::atomic<Record*> next = nullptr; //queue link
+    std::atomic<uint32_t> freeNext = 0; //free list link, an index
+    uint32_t index = 0;
+    bool inlineCommand = false;
+    alignas(std::max_align_t) unsigned char storage[INLINE_BYTES];
+  };
+
+  CommandQueue() : chunks(new std::atomic<Record*>[MAX_CHUNKS]) {
+    for (uint32_t i = 0; i < MAX_CHUNKS; i++) chunks[i].store(nullptr, std::memory_order_relaxed);
+  };
+  ~CommandQueue(); //destroys the commands still queued
+  CommandQueue(const CommandQueue&) = delete;
+  CommandQueue& operator=(const CommandQueue&) = delete;
+
+  // constructs CommandType(args...) in a record and queues it. a throwing constructor queues nothing
+  template <class CommandType, class... Args>
+  void push(Args&&... args);
+  Record* pop(); //oldest queued record, nullptr if none (or the newest push hasn't finished linking yet)
+  void release(Record* record); //destroys the command and returns the record to the pool
+  bool empty() const { return tail == &stub && stub.next.load(std::memory_order_acquire) == nullptr; };
+  size_t pooledRecords() const { return (size_t)std::min(chunkCount.load(), MAX_CHUNKS)*CHUNK; }; //records allocated so far
+
+private:
+  static constexpr uint32_t CHUNK = 256;
+  static constexpr uint32_t MAX_CHUNKS = 1 << 14; //about four million commands in flight
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  std::unique_ptr<std::atomic<Record*>[]> chunks; //records never move, and are freed with the queue
+  std::atomic<uint32_t> chunkCount = 0;
+  std::atomic<uint64_t> freeHead = NONE; //version << 32 | index of the first free record
+  std::atomic<Record*> head = &stub; //newest record, producers swap themselves in here
+  Record* tail = &stub; //consumer side
+  Record stub;
+
+  Record& at(uint32_t index) const { return chunks[index / CHUNK].load(std::memory_order_acquire)[index % CHUNK]; };
+  Record* acquire();
+  Record* grow();
+  void recycle(Record* first, Record* last); //pushes the chain first..last (linked through freeNext)
+  void enqueue(Record* record);
+};
+
+template <class CommandType, class... Args>
+void CommandQueue::push(Args&&... args) {
+  Record* record = acquire();
+  try {
+    if constexpr (sizeof(CommandType) <= INLINE_BYTES && alignof(CommandType) <= alignof(std::max_align_t)) {
+      record->command = new (record->storage) CommandType(std::forward<Args>(args)...);
+      record->inlineCommand = true;
+    } else {
+      record->command = new CommandType(std::forward<Args>(args)...);
+      record->inlineCommand = false;
+    }
+  } catch (...) {
+    record->command = nullptr;
+    recycle(record, record);
+    throw;
+  }
+  enqueue(record);
+}
+
+inline CommandQueue::~CommandQueue() {
+  while (Record* record = pop()) release(record);
+  uint32_t count = std::min(chunkCount.load(), MAX_CHUNKS);
+  for (uint32_t i = 0; i < count; i++) delete[] chunks[i].load();
+}
+
+inline CommandQueue::Record* CommandQueue::acquire() {
+  uint64_t old = freeHead.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t index = (uint32_t)old;
+    if (index == NONE) return grow();
+    // the record may be taken by another producer meanwhile; then the version has moved on and the swap fails
+    uint32_t next = at(index).freeNext.load(std::memory_order_relaxed);
+    uint64_t desired = ((old >> 32) + 1) << 32 | next;
+    if (freeHead.compare_exchange_weak(old, desired, std::memory_order_acquire, std::memory_order_acquire)) {
+      return &at(index);
+    }
+  }
+}
+
+inline CommandQueue::Record* CommandQueue::grow() {
+  uint32_t chunk = chunkCount.fetch_add(1);
+  if (chunk >= MAX_CHUNKS) throw std::length_error("CommandQueue: too many commands waiting");
+  Record* records = new Record[CHUNK];
+  for (uint32_t i = 0; i < CHUNK; i++) {
+    records[i].index = chunk*CHUNK + i;
+    records[i].freeNext.store(chunk*CHUNK + i + 1, std::memory_order_relaxed);
+  }
+  chunks[chunk].store(records, std::memory_order_release);
+  recycle(&records[1], &records[CHUNK - 1]); //keep the first, share the rest
+  return &records[0];
+}
+
+inline void CommandQueue::recycle(Record* first, Record* last) {
+  uint64_t old = freeHead.load(std::memory_order_relaxed);
+  uint64_t desired;
+  do {
+    last->freeNext.store((uint32_t)old, std::memory_order_relaxed);
+    desired = ((old >> 32) + 1) << 32 | first->index;
+  } while (!freeHead.compare_exchange_weak(old, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+inline void CommandQueue::enqueue(Record* record) {
+  record->next.store(nullptr, std::memory_order_relaxed);
+  Record* previous = head.exchange(record, std::memory_order_acq_rel);
+  previous->next.store(record, std::memory_order_release); //until this store the consumer sees the queue end at previous
+}
+
+inline CommandQueue::Record* CommandQueue::pop() {
+  Record* first = tail;
+  Record* next = first->next.load(std::memory_order_acquire);
+  if (first == &stub) {
+    if (next == nullptr) return nullptr;
+    tail = next;
+    first = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail = next;
+    return first;
+  }
+  if (first != head.load(std::memory_order_acquire)) return nullptr; //a producer is between its swap and link
+  // first is the last record: put the stub behind it so it can be handed out
+  enqueue(&stub);
+  next = first->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail = next;
+    return first;
+  }
+  return nullptr;
+}
+
+inline void CommandQueue::release(Record* record) {
+  if (record->inlineCommand) record->command->~SimulatorCommand();
+  else delete record->command;
+  record->command = nullptr;
+  recycle(record, record);
+}
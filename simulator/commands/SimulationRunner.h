@@ -0,0 +1,131 @@
+#pragma once
+#include "SimulatorCommander.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <mutex>
+
+class SimulationRunner
+// Drives a SimulatorCommander on its own thread, so the simulation rate doesn't depend on the GUI timer.
+// Wall time is scaled by timeScale into an accumulator that is spent in fixed steps of the simulator's dt.
+// If a tick owes more than maxCatchUpSteps steps, the rest of the debt is dropped and the simulation runs slow
+// instead of spiralling. Queued commands are applied every tick, paused or not, within the commander's budget.
+// Readers should use simulator.snapshots rather than the live movers.
+// An exception from a command or a step doesn't escape the thread: it is kept for lastError, the commander is
+// paused, and the loop carries on applying commands.
+{
+public:
+  SimulationRunner(std::shared_ptr<SimulatorCommander> commander);
+  ~SimulationRunner(); //stops and joins the thread
+  SimulationRunner(const SimulationRunner&) = delete;
+  SimulationRunner& operator=(const SimulationRunner&) = delete;
+
+  void start();
+  void stop();
+  bool isStarted() const { return thread.joinable(); };
+  long long stepsTaken() const { return steps; };
+  long long droppedSteps() const { return dropped; }; //steps skipped by the catch-up cap
+  std::exception_ptr lastError(); //most recent exception thrown by an update, null if none
+  void clearError();
+
+  std::atomic<float> timeScale = 1; //simulated seconds per wall-clock second
+  std::atomic<int> maxCatchUpSteps = 4; //most steps taken in one tick
+  std::chrono::microseconds maxIdle = std::chrono::milliseconds(5); //longest sleep, bounds command latency
+
+  std::shared_ptr<SimulatorCommander> commander;
+
+private:
+  void loop();
+  bool tryUpdate(bool step = true); //false if the update threw
+  std::thread thread;
+  std::atomic<bool> stopRequested = false;
+  std::atomic<long long> steps = 0;
+  std::atomic<long long> dropped = 0;
+  std::mutex errorMutex;
+  std::exception_ptr error;
+};
+
+inline SimulationRunner::SimulationRunner(std::shared_ptr<SimulatorCommander> commander) : commander(commander) {}
+
+inline SimulationRunner::~SimulationRunner() {
+  stop();
+}
+
+inline void SimulationRunner::start() {
+  if (thread.joinable()) return;
+  stopRequested = false;
+  thread = std::thread(&SimulationRunner::loop, this);
+}
+
+inline void SimulationRunner::stop() {
+  stopRequested = true;
+  if (thread.joinable()) thread.join();
+}
+
+inline std::exception_ptr SimulationRunner::lastError() {
+  std::lock_guard<std::mutex> lock(errorMutex);
+  return error;
+}
+
+inline void SimulationRunner::clearError() {
+  std::lock_guard<std::mutex> lock(errorMutex);
+  error = nullptr;
+}
+
+inline bool SimulationRunner::tryUpdate(bool step) {
+  try {
+    commander->update(step);
+    return true;
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      error = std::current_exception();
+    }
+    commander->pauseSimulator();
+    return false;
+  }
+}
+
+inline void SimulationRunner::loop() {
+  using clock = std::chrono::steady_clock;
+  double accumulator = 0; //simulated seconds owed
+  auto last = clock::now();
+  while (!stopRequested) {
+    auto now = clock::now();
+    double wallElapsed = std::chrono::duration<double>(now - last).count();
+    last = now;
+    double dt = commander->simulator.global_dt;
+    if (!commander->isRunning()) {
+      // paused: apply commands, owe nothing
+      accumulator = 0;
+      tryUpdate();
+      std::this_thread::sleep_for(maxIdle);
+      continue;
+    }
+    accumulator += wallElapsed * timeScale;
+    long long owed = (long long)(accumulator / dt);
+    if (owed == 0) {
+      tryUpdate(false); //commands only
+    }
+    long long take = std::min<long long>(owed, maxCatchUpSteps);
+    bool failed = false;
+    for (long long i = 0; i < take && !stopRequested && !failed; i++) {
+      failed = !tryUpdate();
+      if (!failed) steps++;
+    }
+    if (failed) continue; //paused now, the next tick clears the debt
+    accumulator -= take * dt;
+    if (owed > take) {
+      dropped += owed - take;
+      accumulator = std::fmod(accumulator, dt);
+    }
+    // sleep until the next step is due
+    double untilNext = timeScale > 0 ? (dt - accumulator) / timeScale : 1;
+    auto wait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::duration<double>(untilNext));
+    std::this_thread::sleep_for(std::clamp(wait, std::chrono::microseconds(0), maxIdle));
+  }
+}
@@ -1,133 +1,91 @@
 #pragma once
 #include "Simulator.h"
-#include "SimulatorCommander.h"
 #include <string>
 #include <any>
-#include <deque>
+#include <functional>
+#include <optional>
+#include <tuple>
 #include <memory>
 
-//forward declare SimulatorCommander
-class SimulatorCommander;
-
 //Commands define possible actions that can be taken by the simulator
-//CommandFactory is a factory class that creates commands based on a string name (or typeid)
-//SimulatorCommander will hold a CommandFactory so that it can create commands
+//SimulatorCommander queues them (see CommandQueue) and invokes them between steps
+
+enum class CommandPriority {
+  Interactive, //applied ahead of everything else queued, e.g. kicks from the GUI
+  Normal //setup and editing, applied in the order queued
+};
+
 struct SimulatorCommand {
   // Interface for a command to be executed by the simulator
-  // Implementers will need to define their own invoke function, which needs to be able to cast the args
-  // into their types and call the appropriate function
+  // Implementers take their arguments, typed, in their constructor, checking them there so a bad command
+  // throws on the thread queueing it, and define invoke to call the appropriate function
   //Implementers should also define a name for identification purposes
-  SimulatorCommand(const std::vector<std::any>& args)
-    : args(args) {};
-  
+  virtual ~SimulatorCommand() = default;
   void virtual invoke(Simulator& simulator) = 0;
-  void virtual argParse() = 0; // check that args are valid and store the parsed values 
-  std::string name;
-  // function handle to call
-  // arguments to pass to function
-  std::vector<std::any> args;
+  const char* name = "";
+  CommandPriority priority = CommandPriority::Normal;
 
   //utility functions
   std::vector<int> static getMoverIdsByPosition(Simulator& simulator, Vect2 position);
+  //same, from a published snapshot, for threads other than the one stepping the simulator
+  std::vector<int> static getMoverIdsByPosition(const SimulatorSnapshot& snapshot, Vect2 position);
 };
 
 struct AddMoverCommand : SimulatorCommand {
-  std::type_index type = typeid(Mover); //placeholder. validate will grab the right type
+  std::type_index type;
   MoverArgs moverArgs;
   std::unordered_map<std::type_index, std::vector<std::any>> interactionParams;
 
-  AddMoverCommand(const std::vector<std::any>& args) 
-    : SimulatorCommand(args) { 
+  AddMoverCommand(std::type_index type, MoverArgs moverArgs = MoverArgs(),
+    std::unordered_map<std::type_index, std::vector<std::any>> interactionParams = {})
+    : type(type), moverArgs(moverArgs), interactionParams(std::move(interactionParams)) {
     name = "AddMover";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
     simulator.add_mover(type, moverArgs, interactionParams);
   }
-  void argParse() override {
-    if (args.size() < 1 || args.size() > 3) {
-      throw std::invalid_argument("AddMoverCommand: incorrect number of arguments. should be 1,2,or 3. Got "
-        + std::to_string(args.size()));
-    }
-    //process first arg and declare defaults for others
-    type = std::any_cast<std::type_index>(args[0]);
-    moverArgs = MoverArgs();
-    interactionParams = {};
-
-    if (args.size() > 1) //process second arg if it exists
-      moverArgs = std::any_cast<MoverArgs>(args[1]);
-    
-
-    if (args.size() == 3) //process third arg if it exists
-      interactionParams = std::any_cast<std::unordered_map<std::type_index, std::vector<std::any>>>(args[2]);
-  };
 };
 
 struct StepCommand : SimulatorCommand { //update simulator n times (1 by default)
   int steps = 1;
 
-  StepCommand(const std::vector<std::any>& args) : SimulatorCommand(args) {   
+  StepCommand(int steps = 1) : steps(steps) {
     name = "Step";
-    argParse();
-  } //args are empty or contain a single int
-
+    if (steps < 0) throw std::invalid_argument("StepCommand: steps must not be negative. Got " + std::to_string(steps));
+  }
   void invoke(Simulator& simulator) override {
-    //throw if args < 1 or > 1, telling how many args expected and how many given
     simulator.update(steps);
   }
-  void argParse() override {
-    if (args.size() > 1) {
-      throw std::invalid_argument("stepCommand: incorrect number of arguments. should be 1 or 2. Got "
-        + std::to_string(args.size()));
-    }
-    if (args.size() == 1) steps = std::any_cast<int>(args[0]);
-  }
 };
 
 struct deleteMoverCommand : SimulatorCommand {
   int id;
-  deleteMoverCommand(const std::vector<std::any>& args) : SimulatorCommand(args) {
+  deleteMoverCommand(int id) : id(id) {
     name = "DeleteMover";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
     simulator.remove_mover(id);
   }
-  void argParse() override {
-    if (args.size() != 1) {
-      throw std::invalid_argument("deleteMoverCommand: incorrect number of arguments. should be 1. Got "
-        + std::to_string(args.size()));
-    }
-    id = std::any_cast<int>(args[0]);
-  }
 };
 
 struct CreateGroup : SimulatorCommand {
   std::vector<int> moverIds;
-  CreateGroup(const std::vector<std::any>& args) : SimulatorCommand(args) {
+  CreateGroup(std::vector<int> moverIds) : moverIds(std::move(moverIds)) {
     name = "CreateGroup";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
     simulator.create_group(moverIds);
   }
-  void argParse() override {
-    if (args.size() != 1) {
-      throw std::invalid_argument("CreateGroup: incorrect number of arguments. should be 1. Got "
-        + std::to_string(args.size()));
-    }
-    moverIds = std::any_cast<std::vector<int>>(args[0]);
-  }
 };
 
 struct Ungroup : SimulatorCommand {
   int id;
-  Ungroup(const std::vector<std::any>& args) : SimulatorCommand(args) {
+  Ungroup(int id) : id(id) {
     name = "Ungroup";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
     auto it = simulator.find_mover(id);
+    if (it == simulator.movers.end()) return; //exit early if mover not found
     auto& moverPtr = (*it);
     if (typeid(*moverPtr) == typeid(RigidConnectedMover)) {
       RigidConnectedMover* mover = dynamic_cast<RigidConnectedMover*>(moverPtr.get());
@@ -135,21 +93,14 @@ struct Ungroup : SimulatorCommand {
       simulator.ungroup(group);
     }
   }
-
-  void argParse() override {
-    if (args.size() != 1) {
-      throw std::invalid_argument("Ungroup: incorrect number of arguments. should be 1. Got "
-        + std::to_string(args.size()));
-    }
-    id = std::any_cast<int>(args[0]);
-  }
 };
 
 struct DeleteGroup : public SimulatorCommand {
+  //deleteUngrouped: also delete the mover if it isn't in a group
   int id;
-  DeleteGroup(const std::vector<std::any>& args) : SimulatorCommand(args) {
+  bool deleteUngrouped = false;
+  DeleteGroup(int id, bool deleteUngrouped = false) : id(id), deleteUngrouped(deleteUngrouped) {
     name = "DeleteGroup";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
     auto it = simulator.find_mover(id);
@@ -161,97 +112,115 @@ struct DeleteGroup : public SimulatorCommand {
       RigidConnectedGroup* group = mover->group;
       simulator.delete_group(group);
     }
+    else if (deleteUngrouped) simulator.remove_mover(id); //a lone mover is its own group
   }
+};
 
-  void argParse() override {
-    if (args.size() != 1) {
-      throw std::invalid_argument("DeleteGroup: incorrect number of arguments. should be 1. Got "
-        + std::to_string(args.size()));
-    }
-    id = std::any_cast<int>(args[0]);
+struct EditGroup : public SimulatorCommand {
+  //adds and removes movers from the group that mover "id" belongs to, in one pass
+  int id;
+  std::vector<int> addIds;
+  std::vector<int> removeIds;
+  EditGroup(int id, std::vector<int> addIds, std::vector<int> removeIds = {})
+    : id(id), addIds(std::move(addIds)), removeIds(std::move(removeIds)) {
+    name = "EditGroup";
+  }
+  void invoke(Simulator& simulator) override {
+    auto it = simulator.find_mover(id);
+    if (it == simulator.movers.end()) return; //exit early if mover not found
+    RigidConnectedMover* mover = dynamic_cast<RigidConnectedMover*>((*it).get());
+    if (mover == nullptr) return; //exit early if not a rigid connected mover
+    simulator.edit_group(mover->group, addIds, removeIds);
   }
 };
 
-template <std::size_t Index, typename... Args>
-using NthType = typename std::tuple_element<Index, std::tuple<Args...>>::type;
+struct AddDistanceConstraint : public SimulatorCommand {
+  //restLength negative for current distance
+  int id1, id2;
+  float restLength = -1;
+  float compliance = 0;
+  AddDistanceConstraint(int id1, int id2, float restLength = -1, float compliance = 0)
+    : id1(id1), id2(id2), restLength(restLength), compliance(compliance) {
+    name = "AddDistanceConstraint";
+  }
+  void invoke(Simulator& simulator) override {
+    simulator.add_distance_constraint(id1, id2, restLength, compliance);
+  }
+};
 
-template <typename... Args, std::size_t... I>
-auto castArgs(std::vector<std::any>& args, std::index_sequence<I...>) {
-    return std::make_tuple(std::any_cast<NthType<I, Args...>>(args[I])...);
-}
+struct AddPinConstraint : public SimulatorCommand {
+  //pins at the current position if pinPosition isn't given
+  int id;
+  std::optional<Vect2> pinPosition;
+  float compliance = 0;
+  AddPinConstraint(int id, std::optional<Vect2> pinPosition = std::nullopt, float compliance = 0)
+    : id(id), pinPosition(pinPosition), compliance(compliance) {
+    name = "AddPinConstraint";
+  }
+  void invoke(Simulator& simulator) override {
+    simulator.add_pin_constraint(id, pinPosition, compliance);
+  }
+};
 
-template <typename... Args>
-auto castArgs(std::vector<std::any>& args) {
-    return castArgs<Args...>(args, std::index_sequence_for<Args...>{});
-}
+struct AddAngleConstraint : public SimulatorCommand {
+  //keeps the current angle if restAngle isn't given
+  int idA, vertexId, idC;
+  std::optional<float> restAngle;
+  float compliance = 0;
+  AddAngleConstraint(int idA, int vertexId, int idC, std::optional<float> restAngle = std::nullopt, float compliance = 0)
+    : idA(idA), vertexId(vertexId), idC(idC), restAngle(restAngle), compliance(compliance) {
+    name = "AddAngleConstraint";
+  }
+  void invoke(Simulator& simulator) override {
+    simulator.add_angle_constraint(idA, vertexId, idC, restAngle, compliance);
+  }
+};
 
-template <typename T, typename... Args>
-T* make_instance_raw(std::tuple<Args...> args) {
-    return std::apply([](auto&&... unpackedArgs) {
-        return new T(std::forward<decltype(unpackedArgs)>(unpackedArgs)...);
-    }, args);
-}
+struct AddSpringBonds : public SimulatorCommand {
+  //k and x0 hold one value for all bonds or one per bond, x0 < 0 for current distance
+  std::vector<int> ids1, ids2;
+  std::vector<float> k, x0;
+  AddSpringBonds(std::vector<int> ids1, std::vector<int> ids2, std::vector<float> k, std::vector<float> x0)
+    : ids1(std::move(ids1)), ids2(std::move(ids2)), k(std::move(k)), x0(std::move(x0)) {
+    name = "AddSpringBonds";
+    if (this->ids1.size() != this->ids2.size()) {
+      throw std::invalid_argument("AddSpringBonds: ids1 and ids2 must be the same length");
+    }
+  }
+  void invoke(Simulator& simulator) override {
+    simulator.add_spring_bonds(ids1, ids2, k, x0);
+  }
+};
 
 template <class InteractionType, typename... InteractionArgs>
 struct addInteraction : SimulatorCommand {
-  std::vector<std::any> interaction_args;
-  std::vector<std::any> default_params;
+  //the interaction is constructed from interactionArgs when invoked
+  std::tuple<InteractionArgs...> interactionArgs;
+  std::vector<std::any> defaultParams; //per-mover parameters, as Simulator::add_interaction takes them
 
-  addInteraction(const std::vector<std::any>& args) 
-    : SimulatorCommand(args) { 
+  addInteraction(std::tuple<InteractionArgs...> interactionArgs, std::vector<std::any> defaultParams = {})
+    : interactionArgs(std::move(interactionArgs)), defaultParams(std::move(defaultParams)) {
     name = "AddInteraction";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
-    auto interaction_args_tuple = castArgs<InteractionArgs...>(interaction_args);
-    InteractionType* interaction = make_instance_raw<InteractionType>(interaction_args_tuple);
-    simulator.add_interaction(interaction, default_params);
+    InteractionType* interaction = std::apply([](auto&... args) { return new InteractionType(args...); }, interactionArgs);
+    simulator.add_interaction(interaction, defaultParams);
   }
-  void argParse() override {
-    if (args.size()==1) {
-      interaction_args = std::any_cast<std::vector<std::any>>(args[0]);
-      default_params = {};
-    }
-    else if (args.size()==2) {
-      interaction_args = std::any_cast<std::vector<std::any>>(args[0]);
-      default_params = std::any_cast<std::vector<std::any>>(args[1]);
-    }
-    else {
-      throw std::invalid_argument("AddInteraction: incorrect number of arguments. should be 1 or 2. Got "
-        + std::to_string(args.size()) + ". args should be vector<any> or vector<any>, vector<any>");
-    }
-  };
 };
 
 template <class EffectType, typename... EffectArgs>
 struct addEffect : SimulatorCommand {
-  std::vector<std::any> effect_args;
-  std::vector<std::any> default_params;
+  std::tuple<EffectArgs...> effectArgs;
+  std::vector<std::any> defaultParams;
 
-  addEffect(const std::vector<std::any>& args) 
-    : SimulatorCommand(args) { 
+  addEffect(std::tuple<EffectArgs...> effectArgs, std::vector<std::any> defaultParams = {})
+    : effectArgs(std::move(effectArgs)), defaultParams(std::move(defaultParams)) {
     name = "AddEffect";
-    argParse();
   }
   void invoke(Simulator& simulator) override {
-    auto effect_args_tuple = castArgs<EffectArgs...>(effect_args); 
-    EffectType* effect = make_instance_raw<EffectType>(effect_args_tuple);
-    simulator.add_effect(effect, default_params); 
+    EffectType* effect = std::apply([](auto&... args) { return new EffectType(args...); }, effectArgs);
+    simulator.add_effect(effect, defaultParams);
   }
-  void argParse() override {
-    if (args.size()==1) {
-      effect_args = std::any_cast<std::vector<std::any>>(args[0]);
-      default_params = {};
-    }
-    else if (args.size()==2) {
-      effect_args = std::any_cast<std::vector<std::any>>(args[0]);
-      default_params = std::any_cast<std::vector<std::any>>(args[1]);
-    }
-    else {
-      throw std::invalid_argument("AddEffect: incorrect number of arguments. should be 1 or 2. Got "
-        + std::to_string(args.size()) + ". args should be vector<any> or vector<any>, vector<any>");
-    }
-  };
 };
 
 struct AffectMover : public SimulatorCommand { 
@@ -260,13 +229,20 @@ struct AffectMover : public SimulatorCommand {
   etc. Takes a function handle and a mover id as args
   The function will have to fully contain all the details, no args other than mover will be passed to it
   A lambda capturing the parameters should be the usual solution
+  SimulatorCommander coalesces runs of these: each mover is looked up once for all of its functions, and
+  replacePending drops the ones queued for the same mover before it (e.g. set-velocity while dragging)
+  These are Interactive, so they overtake queued setup commands: a mover added by a command still waiting
+  isn't there for them yet
   */
   std::function<void(Mover&)> funcToApply;
   int mover_id;
+  bool replacePending = false;
 
-  AffectMover(const std::vector<std::any>& args) : SimulatorCommand(args) {
+  AffectMover(std::function<void(Mover&)> funcToApply, int mover_id, bool replacePending = false)
+    : funcToApply(std::move(funcToApply)), mover_id(mover_id), replacePending(replacePending) {
     name = "AffectMover";
-    argParse();
+    priority = CommandPriority::Interactive;
+    if (!this->funcToApply) throw std::invalid_argument("AffectMover: empty function");
   }
 
   void invoke(Simulator& simulator) override{
@@ -275,18 +251,10 @@ struct AffectMover : public SimulatorCommand {
     auto& mover = *(*it);
     funcToApply(mover);
   }
-  void argParse() override {
-    if (args.size() != 2) {
-      throw std::invalid_argument("AffectMover: incorrect number of arguments. should be 2. Got "
-        + std::to_string(args.size()));
-    }
-    funcToApply = std::any_cast<std::function<void(Mover&)>>(args[0]);
-    mover_id = std::any_cast<int>(args[1]);
-  };
 };
 
 //utility func implementations
-std::vector<int> SimulatorCommand::getMoverIdsByPosition(Simulator& simulator, Vect2 position) {
+inline std::vector<int> SimulatorCommand::getMoverIdsByPosition(Simulator& simulator, Vect2 position) {
   std::vector<int> moverIds;
   for (auto& mover : simulator.movers) {
     float distance = (mover->position - position).mag();
@@ -295,4 +263,15 @@ std::vector<int> SimulatorCommand::getMoverIdsByPosition(Simulator& simulator, V
     }
   }
   return moverIds;
+}
+
+inline std::vector<int> SimulatorCommand::getMoverIdsByPosition(const SimulatorSnapshot& snapshot, Vect2 position) {
+  std::vector<int> moverIds;
+  for (int i = 0; i < snapshot.ids.size(); i++) {
+    float distance = (snapshot.positions[i] - position).mag();
+    if (distance < snapshot.radii[i]) {
+      moverIds.push_back(snapshot.ids[i]);
+    }
+  }
+  return moverIds;
 }
\ No newline at end of file
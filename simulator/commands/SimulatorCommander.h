@@ -1,6 +1,7 @@
 #pragma once
 #include "Simulator.h"
 #include "SimulatorCommand.h"
+#include "CommandQueue.h"
 #include "SpringInteraction.h"
 #include "CoulombInteraction.h"
 #include "Gravity.h"
@@ -10,152 +11,298 @@
 
 #include <string>
 #include <any>
-#include <deque>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <deque>
+#include <chrono>
 
-//forward declare SimulatorCommand
-class SimulatorCommand;
+struct CommandBudget {
+  // limits on the commands one update applies, 0 for no limit. the rest wait for the next update
+  size_t maxCommands = 0;
+  std::chrono::microseconds maxTime{0}; //checked between commands, so one slow command can overrun it
+};
 
 class SimulatorCommander
 // Handles commands to control the simulator using a command queue
+// Commands can be added from any thread without waiting: the queue is lock-free, so producers don't block while
+// update applies commands or steps. update is the only consumer and is serialized by updateMutex.
+// update moves queued commands into a lane per CommandPriority and applies Interactive ones first, each lane in
+// order, until the budget runs out.
 {
 public:
 	SimulatorCommander(Simulator& simulator);
-  template <typename CommandType>
-  void addCommand(const std::vector<std::any>& args); //could also take typeid instead of name
+  ~SimulatorCommander();
+  template <typename CommandType, typename... Args>
+  void addCommand(Args&&... args); //constructs CommandType(args...), which may throw std::invalid_argument here
   void addCommandAddMover(std::type_index type, MoverArgs args = MoverArgs(), 
     std::unordered_map<std::type_index, std::vector<std::any>> interactionParams = {});
   void addCommandDeleteMover(int id);
   void addCommandStep(int steps = 1);
   void addCommandCreateGroup(std::vector<int> moverIds);
   void addCommandUngroup(int id);
-  void addCommandDeleteGroup(int id);
+  void addCommandDeleteGroup(int id, bool deleteUngrouped = false);
+  void addCommandEditGroup(int id, std::vector<int> addIds, std::vector<int> removeIds = {});
   template <class InteractionType, typename... InteractionArgs>
-  void addCommandAddInteraction(std::vector<std::any> interaction_args, std::vector<std::any> default_params = {});
+  void addCommandAddInteraction(std::tuple<InteractionArgs...> interaction_args, std::vector<std::any> default_params = {});
   void addCommandAddSpring(float k = 1, float x0 = 100);
   void addCommandAddCoulomb(float k = 1, float charge = 0);
   void addCommandAddSoftCollide(float globalSpringStrength = 1, float globalRepulsionStrength = 1,
     float defaultMoverSpringStrength = 1, float defaultMoverRepulsionStrength = 1); //"default" params are for mover properties 
   void addCommandAddGravity(float G = 1);
   template <class EffectType, typename... EffectArgs>
-  void addCommandAddEffect(std::vector<std::any> effect_args, std::vector<std::any> default_params = {});
+  void addCommandAddEffect(std::tuple<EffectArgs...> effect_args, std::vector<std::any> default_params = {});
   void addCommandAddLorentzEffect(float magneticStrength=1, float defaultCharge = 0);
   void addCommandAddDragEffect(float strength=1, float default_coeff = 1);
-  void addCommandAffectMover(std::function<void(Mover&)> funcToApply, int mover_id);
-  void invokeCommand();
-  void update();
+  // replacePending drops AffectMover commands for the same mover still waiting ahead of this one
+  void addCommandAffectMover(std::function<void(Mover&)> funcToApply, int mover_id, bool replacePending = false);
+  void addCommandAddDistanceConstraint(int id1, int id2, float restLength = -1, float compliance = 0);
+  void addCommandAddPinConstraint(int id, std::optional<Vect2> pinPosition = std::nullopt, float compliance = 0);
+  void addCommandAddAngleConstraint(int idA, int vertexId, int idC,
+    std::optional<float> restAngle = std::nullopt, float compliance = 0);
+  void addCommandAddSpringBonds(std::vector<int> ids1, std::vector<int> ids2,
+    std::vector<float> k, std::vector<float> x0 = {-1});
+  bool invokeCommand(); //applies the next command by priority, false if there was none
+  void update(bool step = true); //applies queued commands within the budget, then steps if running and step is true
+  void setCommandBudget(CommandBudget budget);
+  CommandBudget commandBudget(); //waits for a running update
   void runSimulator();
   void pauseSimulator();
   void togglePause();
+  bool isRunning() const { return running; };
   
   Simulator& simulator; //perhaps this should own the simulator with shared ptr
 
+  bool hasPendingCommands(); //waits for a running update
+  size_t pendingCommands(); //queued and carried over, waits for a running update
+  size_t pooledCommandRecords() const { return commandQueue.pooledRecords(); };
+
 private:
-  std::deque<std::unique_ptr<SimulatorCommand>> commandQueue;
-  //lock for the queue
-  std::mutex commandQueueMutex;
-  std::mutex updateMutex;
-	bool running = false; //possibly should be atomic for thread saftey?
+  CommandQueue commandQueue;
+  std::mutex updateMutex; //one consumer of the queue at a time, also guards everything below
+  CommandBudget budget;
+  std::deque<CommandQueue::Record*> lanes[2]; //taken off the queue but not applied yet, indexed by CommandPriority
+  std::vector<CommandQueue::Record*> affectRun; //consecutive AffectMover commands, applied together
+  static constexpr size_t MAX_AFFECT_RUN = 16; //longest run held back under a time budget
+  void takeQueued();
+  size_t applyLanes(CommandBudget limits);
+  void applyRecord(CommandQueue::Record* record);
+  void applyAffectRun();
+	std::atomic<bool> running = false; //set from GUI/python threads, read by whichever thread updates
 };
 
 SimulatorCommander::SimulatorCommander(Simulator& simulator) : simulator(simulator) {};
 
+SimulatorCommander::~SimulatorCommander() {
+  // commands left in the queue are destroyed with it, the ones taken off it are ours
+  for (auto& lane : lanes) {
+    for (auto record : lane) commandQueue.release(record);
+  }
+};
+
 
-template <typename CommandType>
-void SimulatorCommander::addCommand(const std::vector<std::any>& args) {
-  //acquire lock on queue so only one command is added at a time, and it will wait until update call is finished
-  std::lock_guard<std::mutex> lock(commandQueueMutex);
-  auto commandPtr = std::make_unique<CommandType>(args);
-  commandQueue.push_back(std::move(commandPtr));
+template <typename CommandType, typename... Args>
+void SimulatorCommander::addCommand(Args&&... args) {
+  commandQueue.push<CommandType>(std::forward<Args>(args)...);
 };
 
 void SimulatorCommander::addCommandAddMover(std::type_index type, MoverArgs args, 
   std::unordered_map<std::type_index, std::vector<std::any>> interactionParams) {
-  addCommand<AddMoverCommand>({type, args, interactionParams});
+  addCommand<AddMoverCommand>(type, args, std::move(interactionParams));
 };
 
 void SimulatorCommander::addCommandDeleteMover(int id) {
-  addCommand<deleteMoverCommand>({id});
+  addCommand<deleteMoverCommand>(id);
 };
 
 void SimulatorCommander::addCommandStep(int steps) {
-  addCommand<StepCommand>({steps});
+  addCommand<StepCommand>(steps);
 };
 
 void SimulatorCommander::addCommandCreateGroup(std::vector<int> moverIds) {
-  addCommand<CreateGroup>({moverIds});
+  addCommand<CreateGroup>(std::move(moverIds));
 };
 
 void SimulatorCommander::addCommandUngroup(int id) {
-  addCommand<Ungroup>({id});
+  addCommand<Ungroup>(id);
+};
+
+void SimulatorCommander::addCommandDeleteGroup(int id, bool deleteUngrouped) {
+  addCommand<DeleteGroup>(id, deleteUngrouped);
 };
 
-void SimulatorCommander::addCommandDeleteGroup(int id) {
-  addCommand<DeleteGroup>({id});
+void SimulatorCommander::addCommandEditGroup(int id, std::vector<int> addIds, std::vector<int> removeIds) {
+  addCommand<EditGroup>(id, std::move(addIds), std::move(removeIds));
 };
 
 template <class InteractionType, typename... InteractionArgs>
-void SimulatorCommander::addCommandAddInteraction(std::vector<std::any> interaction_args, std::vector<std::any> default_params) {
-  addCommand<addInteraction<InteractionType, InteractionArgs...>>({interaction_args, default_params});
+void SimulatorCommander::addCommandAddInteraction(std::tuple<InteractionArgs...> interaction_args, std::vector<std::any> default_params) {
+  addCommand<addInteraction<InteractionType, InteractionArgs...>>(std::move(interaction_args), std::move(default_params));
 }
 
 void SimulatorCommander::addCommandAddSpring(float k, float x0) {
-  addCommandAddInteraction<Spring, float, float>({k, x0}, {});
+  addCommandAddInteraction<Spring>(std::make_tuple(k, x0));
 }
 
 void SimulatorCommander::addCommandAddCoulomb(float k, float charge) {
-  addCommandAddInteraction<Coulomb, float>({k}, {charge});
+  addCommandAddInteraction<Coulomb>(std::make_tuple(k), {charge});
 }
 
 void SimulatorCommander::addCommandAddSoftCollide(float globalSpringStrength, float globalRepulsionStrength,
   float defaultMoverSpringStrength, float defaultMoverRepulsionStrength) {
-  addCommandAddInteraction<SoftCollide, float, float>({globalSpringStrength, globalRepulsionStrength},
+  addCommandAddInteraction<SoftCollide>(std::make_tuple(globalSpringStrength, globalRepulsionStrength),
      {defaultMoverSpringStrength, defaultMoverRepulsionStrength});
 }
 
 void SimulatorCommander::addCommandAddGravity(float G) {
-  addCommandAddInteraction<Gravity, float>({G}, {});
+  addCommandAddInteraction<Gravity>(std::make_tuple(G));
 }
 
 template<typename EffectType, typename... EffectArgs>
-void SimulatorCommander::addCommandAddEffect(std::vector<std::any> effect_args, std::vector<std::any> default_params) {
-  addCommand<addEffect<EffectType, EffectArgs...>>({effect_args, default_params});
+void SimulatorCommander::addCommandAddEffect(std::tuple<EffectArgs...> effect_args, std::vector<std::any> default_params) {
+  addCommand<addEffect<EffectType, EffectArgs...>>(std::move(effect_args), std::move(default_params));
 }
 
 void SimulatorCommander::addCommandAddDragEffect(float strength, float default_coeff) {
-  addCommandAddEffect<Drag, float>({strength}, {default_coeff});
+  addCommandAddEffect<Drag>(std::make_tuple(strength), {default_coeff});
 }
 
 void SimulatorCommander::addCommandAddLorentzEffect(float magneticStrength, float defaultCharge) {
-  addCommandAddEffect<LorentzEffect, float>({magneticStrength}, {defaultCharge});
+  addCommandAddEffect<LorentzEffect>(std::make_tuple(magneticStrength), {defaultCharge});
 }
 
-void SimulatorCommander::addCommandAffectMover(std::function<void(Mover&)> funcToApply, int mover_id) {
-  addCommand<AffectMover>({funcToApply, mover_id});
+void SimulatorCommander::addCommandAffectMover(std::function<void(Mover&)> funcToApply, int mover_id, bool replacePending) {
+  addCommand<AffectMover>(std::move(funcToApply), mover_id, replacePending);
 }
 
+void SimulatorCommander::addCommandAddDistanceConstraint(int id1, int id2, float restLength, float compliance) {
+  addCommand<AddDistanceConstraint>(id1, id2, restLength, compliance);
+}
+
+void SimulatorCommander::addCommandAddPinConstraint(int id, std::optional<Vect2> pinPosition, float compliance) {
+  addCommand<AddPinConstraint>(id, pinPosition, compliance);
+}
 
-void SimulatorCommander::invokeCommand() {
-  if (commandQueue.empty()) {
+void SimulatorCommander::addCommandAddAngleConstraint(int idA, int vertexId, int idC,
+  std::optional<float> restAngle, float compliance) {
+  addCommand<AddAngleConstraint>(idA, vertexId, idC, restAngle, compliance);
+}
+
+void SimulatorCommander::addCommandAddSpringBonds(std::vector<int> ids1, std::vector<int> ids2,
+  std::vector<float> k, std::vector<float> x0) {
+  addCommand<AddSpringBonds>(std::move(ids1), std::move(ids2), std::move(k), std::move(x0));
+}
+
+bool SimulatorCommander::invokeCommand() {
+  std::lock_guard<std::mutex> lock(updateMutex);
+  takeQueued();
+  return applyLanes(CommandBudget{1}) > 0;
+};
+
+bool SimulatorCommander::hasPendingCommands() {
+  std::lock_guard<std::mutex> lock(updateMutex);
+  return !commandQueue.empty() || !lanes[0].empty() || !lanes[1].empty();
+};
+
+size_t SimulatorCommander::pendingCommands() {
+  std::lock_guard<std::mutex> lock(updateMutex);
+  takeQueued();
+  return lanes[0].size() + lanes[1].size();
+};
+
+void SimulatorCommander::setCommandBudget(CommandBudget budget) {
+  std::lock_guard<std::mutex> lock(updateMutex);
+  this->budget = budget;
+};
+
+CommandBudget SimulatorCommander::commandBudget() {
+  std::lock_guard<std::mutex> lock(updateMutex);
+  return budget;
+};
+
+void SimulatorCommander::takeQueued() {
+  // producers keep adding meanwhile; commands that arrive after this are left for the next update
+  while (CommandQueue::Record* record = commandQueue.pop()) {
+    lanes[(int)record->command->priority].push_back(record);
+  }
+};
+
+size_t SimulatorCommander::applyLanes(CommandBudget limits) {
+  auto start = std::chrono::steady_clock::now();
+  size_t applied = 0;
+  auto withinBudget = [&] {
+    if (limits.maxCommands > 0 && applied >= limits.maxCommands) return false;
+    if (limits.maxTime.count() > 0 && applied > 0) {
+      // held back AffectMover functions haven't taken their time yet, so the clock is read once they've run
+      if (affectRun.size() >= MAX_AFFECT_RUN) applyAffectRun();
+      if (affectRun.empty() && std::chrono::steady_clock::now() - start >= limits.maxTime) return false;
+    }
+    return true;
+  };
+  for (auto& lane : lanes) {
+    while (!lane.empty() && withinBudget()) {
+      CommandQueue::Record* record = lane.front();
+      lane.pop_front();
+      applied++;
+      applyRecord(record);
+    }
+    applyAffectRun();
+  }
+  return applied;
+};
+
+void SimulatorCommander::applyRecord(CommandQueue::Record* record) {
+  // AffectMover commands are held back while they come one after another, everything else runs in order
+  if (dynamic_cast<AffectMover*>(record->command) != nullptr) {
+    affectRun.push_back(record);
     return;
   }
-  auto& commandPtr = commandQueue.front();
-  commandPtr->invoke(simulator);
-  commandQueue.pop_front();
+  struct Release { //the record goes back to the pool even if this throws
+    CommandQueue& queue;
+    CommandQueue::Record* record;
+    ~Release() { queue.release(record); }
+  } release{commandQueue, record};
+  applyAffectRun();
+  record->command->invoke(simulator);
 };
 
-void SimulatorCommander::update() { 
-  std::lock_guard<std::mutex> lock(updateMutex);
-  {//acquire lock on queue during invokes
-    std::lock_guard<std::mutex> lock(commandQueueMutex);
-    while (!commandQueue.empty()) {
-      //may need to limit this to a certain number of times per update, or it could drop the frames
-      invokeCommand();
+void SimulatorCommander::applyAffectRun() {
+  // within a run, functions for different movers are independent, so the run is grouped by mover (keeping each
+  // mover's order) and every mover is looked up once. a replacePending command starts its mover's group afresh
+  if (affectRun.empty()) return;
+  std::vector<CommandQueue::Record*> run;
+  run.swap(affectRun);
+  auto moverOf = [](CommandQueue::Record* record) { return static_cast<AffectMover*>(record->command)->mover_id; };
+  std::stable_sort(run.begin(), run.end(), [&](auto a, auto b) { return moverOf(a) < moverOf(b); });
+  struct ReleaseAll {
+    CommandQueue& queue;
+    std::vector<CommandQueue::Record*>& records;
+    ~ReleaseAll() { for (auto record : records) queue.release(record); }
+  } release{commandQueue, run};
+  for (size_t start = 0; start < run.size();) {
+    int id = moverOf(run[start]);
+    size_t end = start;
+    size_t first = start;
+    while (end < run.size() && moverOf(run[end]) == id) {
+      if (static_cast<AffectMover*>(run[end]->command)->replacePending) first = end;
+      end++;
     }
-  }//release lock during simulator update so commands can be queued
+    auto it = simulator.find_mover(id);
+    if (it != simulator.movers.end()) {
+      for (size_t i = first; i < end; i++) static_cast<AffectMover*>(run[i]->command)->funcToApply(**it);
+    }
+    start = end;
+  }
+};
+
+void SimulatorCommander::update(bool step) { 
+  std::lock_guard<std::mutex> lock(updateMutex);
+  takeQueued();
+  size_t applied = applyLanes(budget);
 
-  if (running) simulator.update();
+  if (running && step) simulator.update();
+  else if (applied > 0 && simulator.publishSnapshots) simulator.publish_snapshot(); //paused, show what the commands changed
 };
 
 void SimulatorCommander::runSimulator() {
@@ -0,0 +1,91 @@
+#pragma once
+#include "Simulator.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <exception>
+
+class StepTask
+// Takes a fixed number of steps on its own thread, so the caller can work on the previous batch meanwhile.
+// Progress and cancellation are checked between steps: cancel() stops after the step in progress.
+// onProgress runs on the task's thread every progressEvery steps and once at the end.
+// While it runs, read the simulator through snapshots or calls that take the update lock.
+{
+public:
+  StepTask(Simulator& simulator, long long steps, std::function<void(long long)> onProgress = nullptr,
+    long long progressEvery = 0);
+  ~StepTask(); //cancels and joins the thread
+  StepTask(const StepTask&) = delete;
+  StepTask& operator=(const StepTask&) = delete;
+
+  long long stepsRequested() const { return requested; };
+  long long stepsDone() const { return done; };
+  bool isDone() const { return finished; };
+  bool isCancelled() const { return cancelRequested; };
+  void cancel() { cancelRequested = true; };
+  template <class Rep, class Period>
+  bool waitFor(std::chrono::duration<Rep, Period> timeout); //true if the task finished in time
+  long long wait(); //blocks until the task ends, rethrows an exception from a step. returns the steps taken
+
+  Simulator& simulator;
+
+private:
+  void run();
+  long long requested;
+  std::function<void(long long)> onProgress;
+  long long progressEvery;
+  std::atomic<long long> done = 0;
+  std::atomic<bool> cancelRequested = false;
+  std::atomic<bool> finished = false;
+  std::mutex finishLock;
+  std::condition_variable finishedChanged;
+  std::exception_ptr error;
+  std::thread thread; //started last, once everything it reads is set up
+};
+
+inline StepTask::StepTask(Simulator& simulator, long long steps, std::function<void(long long)> onProgress,
+  long long progressEvery)
+  : simulator(simulator), requested(steps), onProgress(onProgress), progressEvery(progressEvery) {
+  thread = std::thread(&StepTask::run, this);
+}
+
+inline StepTask::~StepTask() {
+  cancel();
+  if (thread.joinable()) thread.join();
+}
+
+inline void StepTask::run() {
+  try {
+    while (done < requested && !cancelRequested) {
+      simulator.update();
+      done++;
+      if (onProgress && progressEvery > 0 && done % progressEvery == 0 && done < requested) onProgress(done);
+    }
+    if (onProgress) onProgress(done);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(finishLock);
+    finished = true;
+  }
+  finishedChanged.notify_all();
+}
+
+template <class Rep, class Period>
+bool StepTask::waitFor(std::chrono::duration<Rep, Period> timeout) {
+  std::unique_lock<std::mutex> lock(finishLock);
+  return finishedChanged.wait_for(lock, timeout, [this]() { return finished.load(); });
+}
+
+inline long long StepTask::wait() {
+  {
+    std::unique_lock<std::mutex> lock(finishLock);
+    finishedChanged.wait(lock, [this]() { return finished.load(); });
+  }
+  if (error) std::rethrow_exception(error);
+  return done;
+}
@@ -0,0 +1,268 @@
+#include <gtest/gtest.h>
+#include "SimulatorCommander.h"
+#include "SimulationRunner.h"
+#include "StepTask.h"
+#include <chrono>
+#include <thread>
+
+class CommanderFixture : public ::testing::Test {
+  protected:
+  Simulator sim = Simulator(0.01);
+  std::shared_ptr<SimulatorCommander> commander = std::make_shared<SimulatorCommander>(sim);
+};
+
+TEST_F(CommanderFixture, UpdateAppliesCommandsThenSteps) {
+  commander->addCommandAddMover(typeid(NewtMover), MoverArgs(Vect2(0, 0), Vect2(1, 0), Vect2(), 1, 1));
+  commander->update(); //not running, only the command
+  ASSERT_EQ(sim.movers.size(), 1);
+  EXPECT_EQ(sim.step_count, 0);
+  commander->runSimulator();
+  commander->update(false);
+  EXPECT_EQ(sim.step_count, 0);
+  commander->update();
+  EXPECT_EQ(sim.step_count, 1);
+}
+
+TEST_F(CommanderFixture, PausedUpdatePublishesCommandChanges) {
+  commander->addCommandAddMover(typeid(NewtMover), MoverArgs(Vect2(3, 4), Vect2(), Vect2(), 1, 1));
+  commander->update(); //not running
+  auto snapshot = sim.snapshots.read();
+  ASSERT_EQ(snapshot->ids.size(), 1);
+  EXPECT_FLOAT_EQ(snapshot->positions[0].x, 3);
+  commander->addCommandAffectMover([](Mover& mover) { mover.position = Vect2(5, 6); }, sim.movers[0]->id);
+  commander->update(false);
+  EXPECT_FLOAT_EQ(sim.snapshots.read()->positions[0].x, 5);
+}
+
+TEST_F(CommanderFixture, DeleteGroupCanDeleteUngroupedMover) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  commander->addCommandDeleteGroup(0);
+  commander->update();
+  EXPECT_EQ(sim.movers.size(), 1); //not in a group, left alone
+  commander->addCommandDeleteGroup(0, true);
+  commander->update();
+  EXPECT_TRUE(sim.movers.empty());
+}
+
+TEST_F(CommanderFixture, RunnerFollowsTimeScale) {
+  SimulationRunner runner(commander);
+  runner.timeScale = 2; //0.01 sim seconds per step, so 200 steps per wall second
+  commander->runSimulator();
+  runner.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  runner.stop();
+  EXPECT_FALSE(runner.isStarted());
+  EXPECT_GT(runner.stepsTaken(), 20); //60 at exactly 2x
+  EXPECT_LE(runner.stepsTaken(), 61); //never ahead of wall time
+  EXPECT_EQ(runner.stepsTaken(), sim.step_count);
+  EXPECT_NEAR(sim.current_time, runner.stepsTaken() * 0.01f, 1e-3);
+}
+
+TEST_F(CommanderFixture, RunnerCapsCatchUpSteps) {
+  // each queued command takes 5ms of wall time, during which 5 steps become due, so the runner can't keep up
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  auto slow = [](Mover&) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); };
+  SimulationRunner runner(commander);
+  runner.timeScale = 10;
+  runner.maxCatchUpSteps = 2;
+  commander->runSimulator();
+  runner.start();
+  for (int i = 0; i < 20; i++) {
+    commander->addCommandAffectMover(slow, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  runner.stop();
+  EXPECT_GT(runner.droppedSteps(), 0);
+}
+
+TEST_F(CommanderFixture, PausedRunnerStillAppliesCommands) {
+  SimulationRunner runner(commander);
+  runner.start();
+  commander->addCommandAddMover(typeid(NewtMover));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  runner.stop();
+  EXPECT_EQ(sim.movers.size(), 1);
+  EXPECT_EQ(sim.step_count, 0);
+}
+
+TEST_F(CommanderFixture, StepTaskRunsInTheBackground) {
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(0, 0), Vect2(1, 0), Vect2(), 1, 1));
+  std::vector<long long> progress;
+  StepTask task(sim, 100, [&progress](long long done) { progress.push_back(done); }, 25);
+  EXPECT_EQ(task.wait(), 100);
+  EXPECT_TRUE(task.isDone());
+  EXPECT_EQ(sim.step_count, 100);
+  EXPECT_EQ(progress, std::vector<long long>({25, 50, 75, 100}));
+  EXPECT_TRUE(task.waitFor(std::chrono::milliseconds(0)));
+}
+
+TEST_F(CommanderFixture, StepTaskCancelsBetweenSteps) {
+  std::vector<int> ids = {sim.add_mover(typeid(NewtMover)), sim.add_mover(typeid(NewtMover))};
+  sim.add_interactingGroup(ids, [](Mover&, Mover&) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }); //slow steps
+  StepTask task(sim, 1000000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(task.isDone());
+  task.cancel();
+  long long taken = task.wait();
+  EXPECT_GT(taken, 0);
+  EXPECT_LT(taken, 1000000);
+  EXPECT_EQ(sim.step_count, taken);
+}
+
+class ThrowingMover : public Mover {
+  public:
+  using Mover::Mover;
+  void update(float dt) override { throw std::runtime_error("step failed"); };
+};
+
+TEST_F(CommanderFixture, StepTaskRethrowsFromWait) {
+  sim.movers.push_back(std::make_unique<ThrowingMover>(MoverArgs(Vect2(), Vect2(), Vect2(), 1, 1)));
+  StepTask task(sim, 10);
+  EXPECT_THROW(task.wait(), std::runtime_error);
+  EXPECT_TRUE(task.isDone());
+}
+
+TEST_F(CommanderFixture, ConcurrentProducersDontLoseCommands) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  const int producers = 4, perProducer = 2000;
+  std::atomic<int> applied = 0;
+  std::atomic<bool> producing = true;
+  std::thread consumer([&] { while (producing) commander->update(false); });
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < perProducer; i++) commander->addCommandAffectMover([&applied](Mover&) { applied++; }, 0);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  producing = false;
+  consumer.join();
+  commander->update(false);
+  EXPECT_EQ(applied, producers*perProducer);
+  EXPECT_FALSE(commander->hasPendingCommands());
+}
+
+TEST_F(CommanderFixture, AffectMoverRunsKeepOrderPerMover) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  std::vector<std::pair<int, int>> calls;
+  auto record = [&calls](int tag) { return [&calls, tag](Mover& mover) { calls.push_back({mover.id, tag}); }; };
+  commander->addCommandAffectMover(record(1), 1);
+  commander->addCommandAffectMover(record(2), 0);
+  commander->addCommandAffectMover(record(3), 1);
+  commander->addCommandAffectMover(record(4), 0, true); //replaces 2
+  commander->addCommandAffectMover(record(5), 0);
+  commander->addCommandAffectMover(record(6), 7); //no such mover
+  commander->update();
+  EXPECT_EQ(calls, (std::vector<std::pair<int, int>>{{0, 4}, {0, 5}, {1, 1}, {1, 3}}));
+
+  // a run is whatever one update applies: the second one doesn't replace the kick applied by the first
+  calls.clear();
+  commander->addCommandAffectMover(record(1), 0);
+  commander->update();
+  commander->addCommandAffectMover(record(2), 0, true);
+  commander->update();
+  EXPECT_EQ(calls, (std::vector<std::pair<int, int>>{{0, 1}, {0, 2}}));
+}
+
+TEST_F(CommanderFixture, CommandRecordsAreReused) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  auto nothing = [](Mover&) {};
+  for (int i = 0; i < 100; i++) commander->addCommandAffectMover(nothing, 0);
+  commander->update();
+  size_t pooled = commander->pooledCommandRecords();
+  EXPECT_GT(pooled, 0);
+  for (int round = 0; round < 50; round++) {
+    for (int i = 0; i < 100; i++) commander->addCommandAffectMover(nothing, 0);
+    commander->addCommandStep();
+    commander->update();
+  }
+  EXPECT_EQ(commander->pooledCommandRecords(), pooled);
+}
+
+TEST_F(CommanderFixture, InvalidCommandsThrowWhenAdded) {
+  EXPECT_THROW(commander->addCommandAddSpringBonds({0, 1}, {2}, {1}), std::invalid_argument);
+  EXPECT_THROW(commander->addCommandStep(-1), std::invalid_argument);
+  EXPECT_THROW(commander->addCommandAffectMover(nullptr, 0), std::invalid_argument);
+  EXPECT_FALSE(commander->hasPendingCommands());
+  commander->addCommandAddMover(typeid(NewtMover));
+  EXPECT_TRUE(commander->invokeCommand());
+  EXPECT_FALSE(commander->invokeCommand());
+  EXPECT_EQ(sim.movers.size(), 1);
+}
+
+TEST_F(CommanderFixture, ThrowingCommandDoesntBlockTheQueue) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  commander->addCommandAffectMover([](Mover&) { throw std::runtime_error("bad kick"); }, 0);
+  EXPECT_THROW(commander->update(), std::runtime_error);
+  commander->addCommandDeleteMover(0);
+  commander->update();
+  EXPECT_TRUE(sim.movers.empty());
+}
+
+TEST_F(CommanderFixture, CommandBudgetCarriesWorkOver) {
+  commander->setCommandBudget({10});
+  for (int i = 0; i < 25; i++) commander->addCommandAddMover(typeid(NewtMover));
+  commander->runSimulator();
+  commander->update();
+  EXPECT_EQ(sim.movers.size(), 10);
+  EXPECT_EQ(sim.step_count, 1); //steps while commands wait
+  EXPECT_EQ(commander->pendingCommands(), 15);
+  commander->update();
+  commander->update();
+  EXPECT_EQ(sim.movers.size(), 25);
+  EXPECT_FALSE(commander->hasPendingCommands());
+}
+
+TEST_F(CommanderFixture, InteractiveCommandsJumpAhead) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  commander->setCommandBudget({5});
+  for (int i = 0; i < 20; i++) commander->addCommandAddMover(typeid(NewtMover));
+  bool kicked = false;
+  commander->addCommandAffectMover([&kicked](Mover&) { kicked = true; }, 0);
+  commander->update();
+  EXPECT_TRUE(kicked);
+  EXPECT_EQ(sim.movers.size(), 1 + 4); //the kick used one of the five
+  EXPECT_TRUE(commander->invokeCommand());
+  EXPECT_EQ(sim.movers.size(), 6);
+}
+
+TEST_F(CommanderFixture, CommandTimeBudgetStopsBetweenCommands) {
+  std::vector<int> ids = {sim.add_mover(typeid(NewtMover)), sim.add_mover(typeid(NewtMover))};
+  sim.add_interactingGroup(ids, [](Mover&, Mover&) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+  commander->setCommandBudget({0, std::chrono::milliseconds(5)});
+  for (int i = 0; i < 20; i++) commander->addCommandStep();
+  commander->update(false);
+  EXPECT_GE(sim.step_count, 1);
+  EXPECT_LT(sim.step_count, 20);
+  EXPECT_EQ(commander->pendingCommands(), 20 - sim.step_count);
+  while (commander->hasPendingCommands()) commander->update(false);
+  EXPECT_EQ(sim.step_count, 20);
+}
+
+TEST_F(CommanderFixture, RunnerKeepsCommandErrors) {
+  commander->addCommandAddMover(typeid(NewtMover));
+  commander->update();
+  SimulationRunner runner(commander);
+  commander->runSimulator();
+  runner.start();
+  commander->addCommandAffectMover([](Mover&) { throw std::runtime_error("bad kick"); }, 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(runner.isStarted()); //the thread survived
+  EXPECT_FALSE(commander->isRunning());
+  ASSERT_TRUE(runner.lastError());
+  EXPECT_THROW(std::rethrow_exception(runner.lastError()), std::runtime_error);
+  commander->addCommandAddMover(typeid(NewtMover)); //still applied while paused
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  runner.stop();
+  EXPECT_EQ(sim.movers.size(), 2);
+  runner.clearError();
+  EXPECT_FALSE(runner.lastError());
+}
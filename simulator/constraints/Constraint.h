@@ -0,0 +1,35 @@
+#pragma once
+#include "Mover.h"
+#include "Vect2.h"
+#include <vector>
+
+/*
+Position-based (XPBD) constraint between movers, referenced by mover id.
+Constraints are not forces: after movers are integrated, the ConstraintSolver moves
+positions directly until the constraint is satisfied and corrects velocities to match.
+This keeps stiff structures (rods, cloth, pins) stable at timesteps where an equally
+stiff Spring would blow up.
+*/
+
+class Constraint {
+  public:
+    std::vector<int> moverIds; //movers this constraint acts on. The solver resolves them each step
+    float compliance = 0; //inverse stiffness. 0 is perfectly rigid, larger values are softer
+    float lambda = 0; //accumulated lagrange multiplier, reset by the solver every step
+
+    Constraint(std::vector<int> moverIds, float compliance = 0) : moverIds(moverIds), compliance(compliance) {};
+    virtual ~Constraint() = default;
+    // movers and inverseMasses are aligned with moverIds. alphaTilde is compliance/dt^2.
+    // an inverse mass of zero means the mover is not moved by the constraint
+    void virtual project(Mover* const* movers, const float* inverseMasses, float alphaTilde) = 0;
+
+  protected:
+    // shared XPBD multiplier update. weightedGradientSum is sum(w_i * |grad C_i|^2)
+    float deltaLambda(float C, float weightedGradientSum, float alphaTilde) {
+      float denominator = weightedGradientSum + alphaTilde;
+      if (denominator <= 0) return 0; //every mover is fixed
+      float dLambda = (-C - alphaTilde*lambda) / denominator;
+      lambda += dLambda;
+      return dLambda;
+    }
+};
@@ -0,0 +1,159 @@
+#include "ConstraintSolver.h"
+#include "RigidMovers.h"
+#include <algorithm>
+#include <unordered_set>
+#include <future>
+
+void ConstraintSolver::addConstraint(Constraint* constraint) {
+  constraints.push_back(std::unique_ptr<Constraint>(constraint));
+  colorsDirty = true;
+}
+
+int ConstraintSolver::removeConstraintsByMoverId(int moverId) {
+  auto predicate = [moverId](std::unique_ptr<Constraint>& constraint) {
+    auto& ids = constraint->moverIds;
+    return std::find(ids.begin(), ids.end(), moverId) != ids.end();
+  };
+  auto newEnd = std::remove_if(constraints.begin(), constraints.end(), predicate);
+  int removed = constraints.end() - newEnd;
+  constraints.erase(newEnd, constraints.end());
+  if (removed > 0) colorsDirty = true;
+  return removed;
+}
+
+void ConstraintSolver::clear() {
+  constraints.clear();
+  colorsDirty = true;
+}
+
+float ConstraintSolver::inverseMass(Mover* mover) {
+  // zero-mass movers are treated as immovable anchors.
+  // grouped rigid movers are placed by their group every step, so the constraint can't move them either
+  if (mover->mass == 0) return 0;
+  auto rigidMover = dynamic_cast<RigidConnectedMover*>(mover);
+  if (rigidMover != nullptr && rigidMover->group != nullptr && rigidMover->group->movers.size() > 1) return 0;
+  return 1 / mover->mass;
+}
+
+bool ConstraintSolver::resolveMovers(std::vector<std::unique_ptr<Mover>>& movers) {
+  // look each referenced id up once per step (movers are sorted by id)
+  auto compare = [](const std::unique_ptr<Mover>& mover, int id) { return mover->id < id; };
+  std::unordered_map<Mover*, int> touchedIdx;
+  slotOffsets.assign(1, 0);
+  slotMovers.clear();
+  slotInverseMasses.clear();
+  touchedMovers.clear();
+  for (auto& constraint : constraints) {
+    for (int id : constraint->moverIds) {
+      auto it = std::lower_bound(movers.begin(), movers.end(), id, compare);
+      if (it == movers.end() || (*it)->id != id) return false;
+      Mover* mover = it->get();
+      slotMovers.push_back(mover);
+      slotInverseMasses.push_back(inverseMass(mover));
+      if (touchedIdx.emplace(mover, touchedMovers.size()).second) touchedMovers.push_back(mover);
+    }
+    slotOffsets.push_back(slotMovers.size());
+  }
+  return true;
+}
+
+void ConstraintSolver::colorConstraints() {
+  // greedy colouring: each constraint takes the lowest colour none of its movers is already using
+  std::unordered_map<int, std::vector<bool>> moverColors; //moverId -> colours in use
+  std::vector<int> constraintColor(constraints.size());
+  int numColors = 0;
+  for (int i = 0; i < constraints.size(); i++) {
+    std::vector<bool> used(numColors + 1, false);
+    for (int id : constraints[i]->moverIds) {
+      auto& colors = moverColors[id];
+      for (int c = 0; c < colors.size(); c++) {
+        if (colors[c]) used[c] = true;
+      }
+    }
+    int color = std::find(used.begin(), used.end(), false) - used.begin();
+    numColors = std::max(numColors, color + 1);
+    for (int id : constraints[i]->moverIds) {
+      auto& colors = moverColors[id];
+      if (colors.size() <= color) colors.resize(color + 1, false);
+      colors[color] = true;
+    }
+    constraintColor[i] = color;
+  }
+  // bucket constraint indices by colour
+  colorOffsets.assign(numColors + 1, 0);
+  for (int color : constraintColor) colorOffsets[color + 1]++;
+  for (int c = 0; c < numColors; c++) colorOffsets[c + 1] += colorOffsets[c];
+  colorOrder.resize(constraints.size());
+  std::vector<int> fill(colorOffsets.begin(), colorOffsets.end() - 1);
+  for (int i = 0; i < constraints.size(); i++) {
+    colorOrder[fill[constraintColor[i]]++] = i;
+  }
+  colorsDirty = false;
+}
+
+void ConstraintSolver::projectRange(int start, int end, float alphaScale) {
+  for (int k = start; k < end; k++) {
+    int i = colorOrder[k];
+    auto& constraint = constraints[i];
+    int offset = slotOffsets[i];
+    constraint->project(&slotMovers[offset], &slotInverseMasses[offset], constraint->compliance*alphaScale);
+  }
+}
+
+void ConstraintSolver::solve(std::vector<std::unique_ptr<Mover>>& movers, float dt, ThreadPool* pool) {
+  if (constraints.empty() || dt <= 0) return;
+  while (!resolveMovers(movers)) {
+    // a referenced mover was removed from the simulator. drop its constraints and try again
+    auto compare = [](const std::unique_ptr<Mover>& mover, int id) { return mover->id < id; };
+    std::unordered_set<int> missing;
+    for (auto& constraint : constraints) {
+      for (int id : constraint->moverIds) {
+        auto it = std::lower_bound(movers.begin(), movers.end(), id, compare);
+        if (it == movers.end() || (*it)->id != id) missing.insert(id);
+      }
+    }
+    for (int id : missing) removeConstraintsByMoverId(id);
+    if (constraints.empty()) return;
+  }
+  if (colorsDirty) colorConstraints();
+
+  predictedPositions.resize(touchedMovers.size());
+  for (int i = 0; i < touchedMovers.size(); i++) {
+    predictedPositions[i] = touchedMovers[i]->position;
+  }
+  for (auto& constraint : constraints) {
+    constraint->lambda = 0;
+  }
+
+  float alphaScale = 1 / (dt*dt);
+  unsigned int thread_count = pool == nullptr ? 1 : std::thread::hardware_concurrency();
+  const int minChunk = 256; //below this a colour is cheaper to solve on this thread
+  std::vector<std::future<void>> futures;
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    for (int c = 0; c < colorCount(); c++) {
+      int start = colorOffsets[c];
+      int end = colorOffsets[c + 1];
+      int count = end - start;
+      if (thread_count <= 1 || count < 2*minChunk) {
+        projectRange(start, end, alphaScale);
+        continue;
+      }
+      int chunk_size = std::max(minChunk, (int)((count + thread_count - 1) / thread_count));
+      for (int chunkStart = start; chunkStart < end; chunkStart += chunk_size) {
+        int chunkEnd = std::min(end, chunkStart + chunk_size);
+        futures.push_back(pool->enqueue([this, chunkStart, chunkEnd, alphaScale]() {
+          projectRange(chunkStart, chunkEnd, alphaScale);
+        }));
+      }
+      // colours must finish before the next one reads the positions they wrote
+      for (auto& future : futures) future.get();
+      futures.clear();
+    }
+  }
+
+  // velocity picks up the correction made to the integrated position
+  for (int i = 0; i < touchedMovers.size(); i++) {
+    Mover* mover = touchedMovers[i];
+    mover->velocity += (mover->position - predictedPositions[i]) / dt;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Constraint.h"
+#include "Mover.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+/*
+Runs the constraint phase of a step (XPBD). Called after movers have been integrated:
+positions are projected onto the constraints for a number of iterations, then velocities are
+corrected by the distance each mover was moved, divided by dt.
+Constraints are graph-coloured so that no two constraints of the same colour share a mover.
+Colours are solved one after another (Gauss-Seidel), the constraints inside a colour in parallel.
+*/
+
+class ConstraintSolver {
+  public:
+    int iterations = 4;
+    std::vector<std::unique_ptr<Constraint>> constraints;
+
+    void addConstraint(Constraint* constraint);
+    int removeConstraintsByMoverId(int moverId); //returns number of constraints removed
+    void clear();
+    // movers must be sorted by id, as Simulator keeps them. pool may be nullptr to solve on this thread
+    void solve(std::vector<std::unique_ptr<Mover>>& movers, float dt, ThreadPool* pool = nullptr);
+    int colorCount() const { return colorOffsets.empty() ? 0 : colorOffsets.size() - 1; };
+
+  private:
+    bool resolveMovers(std::vector<std::unique_ptr<Mover>>& movers); //false if a constraint lost a mover
+    void colorConstraints();
+    void projectRange(int start, int end, float alphaScale);
+    float inverseMass(Mover* mover);
+
+    bool colorsDirty = true;
+    // constraint indices grouped by colour: colorOrder[colorOffsets[c]..colorOffsets[c+1])
+    std::vector<int> colorOrder;
+    std::vector<int> colorOffsets;
+    // per constraint slice of the resolved mover pointers and inverse masses (CSR layout)
+    std::vector<int> slotOffsets;
+    std::vector<Mover*> slotMovers;
+    std::vector<float> slotInverseMasses;
+    // every constrained mover once, with its position right after integration
+    std::vector<Mover*> touchedMovers;
+    std::vector<Vect2> predictedPositions;
+};
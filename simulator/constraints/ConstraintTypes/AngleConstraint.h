@@ -0,0 +1,39 @@
+#pragma once
+#include "Constraint.h"
+#include <cmath>
+
+class AngleConstraint : public Constraint {
+  //holds the angle at vertex mover (a-vertex-c) at restAngle, in radians, measured from a to c
+  // counter-clockwise. Combined with two distance constraints this makes a bending-resistant joint
+  public:
+    float restAngle;
+    AngleConstraint(int moverIdA, int vertexMoverId, int moverIdC, float restAngle, float compliance = 0)
+      : Constraint({moverIdA, vertexMoverId, moverIdC}, compliance), restAngle(restAngle) {};
+
+    void project(Mover* const* movers, const float* inverseMasses, float alphaTilde) override {
+      Vect2 u = movers[0]->position - movers[1]->position;
+      Vect2 v = movers[2]->position - movers[1]->position;
+      float uMag2 = u.dot(u);
+      float vMag2 = v.dot(v);
+      if (uMag2 == 0 || vMag2 == 0) return; //angle undefined
+      float angle = atan2(u.cross(v), u.dot(v));
+      float C = wrapAngle(angle - restAngle);
+      // d(angle)/du = -perp(u)/|u|^2 and d(angle)/dv = perp(v)/|v|^2, perp rotates by +90 degrees
+      Vect2 gradA = Vect2(u.y, -u.x) / uMag2;
+      Vect2 gradC = Vect2(-v.y, v.x) / vMag2;
+      Vect2 gradVertex = -1*(gradA + gradC);
+      float weightedGradientSum = inverseMasses[0]*gradA.dot(gradA) + inverseMasses[1]*gradVertex.dot(gradVertex)
+        + inverseMasses[2]*gradC.dot(gradC);
+      float dLambda = deltaLambda(C, weightedGradientSum, alphaTilde);
+      movers[0]->position += (inverseMasses[0]*dLambda) * gradA;
+      movers[1]->position += (inverseMasses[1]*dLambda) * gradVertex;
+      movers[2]->position += (inverseMasses[2]*dLambda) * gradC;
+    }
+
+  private:
+    static float wrapAngle(float angle) { //map to (-pi, pi] so the joint takes the short way round
+      while (angle > pi) angle -= 2*pi;
+      while (angle <= -pi) angle += 2*pi;
+      return angle;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include "Constraint.h"
+
+class DistanceConstraint : public Constraint {
+  //keeps two movers restLength apart, like a rod (or a stiff spring when compliance > 0)
+  public:
+    float restLength;
+    DistanceConstraint(int moverId1, int moverId2, float restLength, float compliance = 0)
+      : Constraint({moverId1, moverId2}, compliance), restLength(restLength) {};
+
+    void project(Mover* const* movers, const float* inverseMasses, float alphaTilde) override {
+      Vect2 r = movers[0]->position - movers[1]->position;
+      float magnitude = r.mag();
+      if (magnitude == 0) return; //direction undefined
+      Vect2 n = r / magnitude;
+      float C = magnitude - restLength;
+      float dLambda = deltaLambda(C, inverseMasses[0] + inverseMasses[1], alphaTilde);
+      movers[0]->position += (inverseMasses[0]*dLambda) * n;
+      movers[1]->position += (-inverseMasses[1]*dLambda) * n;
+    }
+};
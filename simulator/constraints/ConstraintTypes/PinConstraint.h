@@ -0,0 +1,19 @@
+#pragma once
+#include "Constraint.h"
+
+class PinConstraint : public Constraint {
+  //holds a mover at a fixed point in space. With compliance > 0 the pin is elastic
+  public:
+    Vect2 pinPosition;
+    PinConstraint(int moverId, Vect2 pinPosition, float compliance = 0)
+      : Constraint({moverId}, compliance), pinPosition(pinPosition) {};
+
+    void project(Mover* const* movers, const float* inverseMasses, float alphaTilde) override {
+      Vect2 r = movers[0]->position - pinPosition;
+      float magnitude = r.mag();
+      if (magnitude == 0) return; //already pinned
+      Vect2 n = r / magnitude;
+      float dLambda = deltaLambda(magnitude, inverseMasses[0], alphaTilde);
+      movers[0]->position += (inverseMasses[0]*dLambda) * n;
+    }
+};
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "ConstraintSolver.h"
+#include "ConstraintTypes/DistanceConstraint.h"
+#include "ConstraintTypes/PinConstraint.h"
+#include "ConstraintTypes/AngleConstraint.h"
+#include "Mover.h"
+#include <cmath>
+
+class ConstraintFixture : public ::testing::Test {
+  protected:
+  std::vector<std::unique_ptr<Mover>> movers;
+  ConstraintSolver solver;
+  float dt = 0.1f;
+
+  int addMover(Vect2 position, float mass = 1.0f, Vect2 velocity = Vect2()) {
+    auto mover = std::make_unique<NewtMover>(MoverArgs(position, velocity, Vect2(), 1.0f, mass));
+    mover->id = movers.size();
+    movers.push_back(std::move(mover));
+    return movers.size() - 1;
+  }
+};
+
+TEST_F(ConstraintFixture, RigidDistanceIsRestoredSymmetrically) {
+  addMover(Vect2(0, 0));
+  addMover(Vect2(12, 0));
+  solver.iterations = 1;
+  solver.addConstraint(new DistanceConstraint(0, 1, 10));
+  solver.solve(movers, dt);
+  EXPECT_NEAR(movers[0]->position.x, 1, 1e-5);
+  EXPECT_NEAR(movers[1]->position.x, 11, 1e-5);
+  // velocity picks up the correction
+  EXPECT_NEAR(movers[0]->velocity.x, 1/dt, 1e-3);
+  EXPECT_NEAR(movers[1]->velocity.x, -1/dt, 1e-3);
+}
+
+TEST_F(ConstraintFixture, HeavierMoverMovesLess) {
+  addMover(Vect2(0, 0), 3.0f);
+  addMover(Vect2(14, 0), 1.0f);
+  solver.iterations = 1;
+  solver.addConstraint(new DistanceConstraint(0, 1, 10));
+  solver.solve(movers, dt);
+  EXPECT_NEAR(movers[0]->position.x, 1, 1e-5);
+  EXPECT_NEAR(movers[1]->position.x, 11, 1e-5);
+}
+
+TEST_F(ConstraintFixture, ZeroMassMoverIsAnAnchor) {
+  movers.push_back(std::make_unique<Mover>(MoverArgs(Vect2(0, 0), Vect2(), Vect2(), 1, 0)));
+  movers[0]->id = 0;
+  addMover(Vect2(12, 0));
+  solver.addConstraint(new DistanceConstraint(0, 1, 10));
+  solver.solve(movers, dt);
+  EXPECT_EQ(movers[0]->position, Vect2(0, 0));
+  EXPECT_NEAR(movers[1]->position.x, 10, 1e-5);
+}
+
+TEST_F(ConstraintFixture, CompliantDistanceOnlyPartlyCorrects) {
+  addMover(Vect2(0, 0));
+  addMover(Vect2(12, 0));
+  solver.iterations = 1;
+  solver.addConstraint(new DistanceConstraint(0, 1, 10, 0.01f));
+  solver.solve(movers, dt);
+  float distance = (movers[1]->position - movers[0]->position).mag();
+  EXPECT_GT(distance, 10.0f);
+  EXPECT_LT(distance, 12.0f);
+}
+
+TEST_F(ConstraintFixture, PinHoldsMover) {
+  addMover(Vect2(3, 4));
+  solver.addConstraint(new PinConstraint(0, Vect2(0, 0)));
+  solver.solve(movers, dt);
+  EXPECT_NEAR(movers[0]->position.x, 0, 1e-5);
+  EXPECT_NEAR(movers[0]->position.y, 0, 1e-5);
+}
+
+TEST_F(ConstraintFixture, AngleIsRestored) {
+  addMover(Vect2(10, 0));
+  addMover(Vect2(0, 0), 1000.0f);
+  addMover(Vect2(10, 10));
+  solver.iterations = 20;
+  solver.addConstraint(new AngleConstraint(0, 1, 2, pi/2));
+  solver.solve(movers, dt);
+  Vect2 u = movers[0]->position - movers[1]->position;
+  Vect2 v = movers[2]->position - movers[1]->position;
+  EXPECT_NEAR(atan2(u.cross(v), u.dot(v)), pi/2, 1e-3);
+}
+
+TEST_F(ConstraintFixture, ChainUsesTwoColors) {
+  for (int i = 0; i < 10; i++) addMover(Vect2(i*2.0f, 0));
+  for (int i = 0; i < 9; i++) solver.addConstraint(new DistanceConstraint(i, i+1, 1));
+  solver.solve(movers, dt);
+  EXPECT_EQ(solver.colorCount(), 2);
+}
+
+TEST_F(ConstraintFixture, ParallelSolveMatchesSerial) {
+  std::vector<std::unique_ptr<Mover>> serialMovers;
+  ConstraintSolver serialSolver;
+  for (int i = 0; i < 2000; i++) {
+    addMover(Vect2(i*1.5f, (i % 3)*0.5f));
+    serialMovers.push_back(std::make_unique<NewtMover>(*dynamic_cast<NewtMover*>(movers.back().get())));
+    serialMovers.back()->id = i;
+  }
+  for (int i = 0; i < 1999; i++) {
+    solver.addConstraint(new DistanceConstraint(i, i+1, 1));
+    serialSolver.addConstraint(new DistanceConstraint(i, i+1, 1));
+  }
+  ThreadPool pool(4);
+  solver.solve(movers, dt, &pool);
+  serialSolver.solve(serialMovers, dt);
+  for (int i = 0; i < 2000; i++) {
+    EXPECT_FLOAT_EQ(movers[i]->position.x, serialMovers[i]->position.x);
+    EXPECT_FLOAT_EQ(movers[i]->position.y, serialMovers[i]->position.y);
+  }
+}
+
+TEST_F(ConstraintFixture, RemovedMoverDropsItsConstraints) {
+  addMover(Vect2(0, 0));
+  addMover(Vect2(12, 0));
+  addMover(Vect2(24, 0));
+  solver.addConstraint(new DistanceConstraint(0, 1, 10));
+  solver.addConstraint(new DistanceConstraint(1, 2, 10));
+  movers.erase(movers.begin() + 2);
+  EXPECT_NO_THROW(solver.solve(movers, dt));
+  EXPECT_EQ(solver.constraints.size(), 1);
+}
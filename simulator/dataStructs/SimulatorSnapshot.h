@@ -0,0 +1,17 @@
+#pragma once
+#include "Vect2.h"
+#include <vector>
+
+// copy of the simulator state that readers (GUI, python, recorders) need, taken at the end of a step.
+// mover arrays are parallel and in the simulator's order (ascending id)
+struct SimulatorSnapshot {
+  float time = 0;
+  long long step = 0; //number of steps taken when the snapshot was published
+  long long sequence = 0; //increases with every publish, including ones between steps
+  std::vector<int> ids;
+  std::vector<Vect2> positions;
+  std::vector<Vect2> velocities;
+  std::vector<float> radii;
+  std::vector<Vect2> wallStarts; //wall i runs from wallStarts[i] to wallEnds[i]
+  std::vector<Vect2> wallEnds;
+};
@@ -1,11 +1,22 @@
 #pragma once
 #include "Mover.h"
+#include <vector>
+#include <memory>
 class Effect {
   //represents effects that apply to all movers, such as planetary gravity, damping, etc.
   public:
   int paramCount = 0;
+  virtual ~Effect() = default; //effects are owned and deleted through Effect pointers
   void virtual apply(Mover* mover) {
   }
+  // called once per step on the stepping thread, before any applyRange.
+  // effects cache anything that doesn't depend on the mover here (time-dependent values, constants)
+  void virtual prepare() {
+  }
+  // applies to movers[start, end). override together with prepare to use the cached per-step values
+  void virtual applyRange(std::vector<std::unique_ptr<Mover>>& movers, int start, int end) {
+    for (int i = start; i < end; i++) apply(movers[i].get());
+  }
   std::any virtual interpretParams(std::vector<std::any> params);
 };
 
@@ -0,0 +1,77 @@
+#pragma once
+#include "Mover.h"
+#include "TiledEffect.h"
+#include "Expression.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+class ExpressionEffect : public TiledEffect {
+  // Applies the force given by an Expression to every mover, e.g. "-c*speed*vel" for quadratic drag.
+  //   pos vel     position and velocity, x y vx vy their components, speed the velocity's magnitude
+  //   mass radius
+  //   t           the time, when constructed with a currentTime to read it from
+  // plus the named constants and the per-mover parameters, read as floats from the mover's interactionParams
+  // under typeid(ExpressionEffect) in the order of paramNames. Every ExpressionEffect in a simulator shares that
+  // entry, so they should agree on paramNames.
+  public:
+    std::vector<std::string> paramNames;
+    const float* currentTime; //may be nullptr, then t is unavailable
+
+    // throws std::invalid_argument if force doesn't compile or isn't a vector
+    ExpressionEffect(const std::string& force, const std::unordered_map<std::string, float>& constants = {},
+      const std::vector<std::string>& paramNames = {}, const float* currentTime = nullptr)
+      : TiledEffect(typeid(ExpressionEffect)), paramNames(paramNames), currentTime(currentTime),
+      force(force, variables(paramNames, currentTime), constants) {
+        if (!this->force.isVector()) {
+          throw std::invalid_argument("ExpressionEffect: the force \"" + force + "\" must be a vector");
+        }
+        paramCount = paramNames.size();
+        speed = this->force.uses(SPEED);
+    };
+
+    const Expression& expression() const { return force; };
+
+    void prepare() override {
+      if (currentTime) std::fill_n(time, TILE, *currentTime);
+    }
+
+  protected:
+    void forces(const phys_tile& movers, float* fx, float* fy) override {
+      float speeds[TILE];
+      const float* inputs[PARAMS + MAX_PARAMS] = {movers.x, movers.y, movers.vx, movers.vy, movers.mass, movers.radius,
+        speeds, time};
+      for (int k = 0; k < movers.paramCount; k++) inputs[PARAMS + k] = movers.params[k];
+      if (speed) {
+        for (int l = 0; l < movers.count; l++) speeds[l] = std::sqrt(movers.vx[l]*movers.vx[l] + movers.vy[l]*movers.vy[l]);
+      }
+      force.evaluate(inputs, movers.count, fx, fy);
+    }
+
+  private:
+    enum Slot { X, Y, VX, VY, MASS, RADIUS, SPEED, TIME, PARAMS };
+    static constexpr int MAX_PARAMS = 32;
+    float time[TILE] = {}; //currentTime as of prepare, repeated across the lanes
+    Expression force;
+    bool speed;
+
+    static std::vector<ExpressionVariable> variables(const std::vector<std::string>& paramNames, const float* currentTime) {
+      std::vector<ExpressionVariable> variables = {
+        {"pos", X, Y}, {"vel", VX, VY}, {"x", X}, {"y", Y}, {"vx", VX}, {"vy", VY},
+        {"mass", MASS}, {"radius", RADIUS}, {"speed", SPEED},
+      };
+      if (currentTime) variables.push_back({"t", TIME});
+      if (paramNames.size() > MAX_PARAMS) {
+        throw std::invalid_argument("ExpressionEffect: at most " + std::to_string(MAX_PARAMS) + " parameters");
+      }
+      for (int k = 0; k < paramNames.size(); k++) {
+        for (auto& variable : variables) {
+          if (variable.name == paramNames[k]) throw std::invalid_argument("ExpressionEffect: parameter name " + paramNames[k] + " is taken");
+        }
+        variables.push_back({paramNames[k], PARAMS + k});
+      }
+      return variables;
+    }
+};
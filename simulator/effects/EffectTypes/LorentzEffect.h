@@ -13,9 +13,9 @@ class LorentzEffect : public Effect {
 };
 
 void LorentzEffect::apply(Mover* mover) {
-  float PI = 3.14159265359;
-  Vect2 force = magneticStrength * paramsFromMover(mover) * mover->velocity.rotate(PI/2);
-  // Vect2 force = magneticStrength * 1 * mover->velocity.rotate(PI/2);
+  //velocity rotated a quarter turn counterclockwise, without going through sin/cos
+  Vect2 perpendicular(-mover->velocity.y, mover->velocity.x);
+  Vect2 force = magneticStrength * paramsFromMover(mover) * perpendicular;
   mover->apply_force(force);
 }
 
@@ -0,0 +1,168 @@
+#pragma once
+#include "Mover.h"
+#include "Effect.h"
+#include "Vect2.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <stdexcept>
+
+class MultiAttractor : public Effect {
+    //Many gravity-like attractors as one effect, same force law as Attractor.
+    //attractors are stored as struct of arrays, so each mover runs one tight loop over them instead of
+    //one virtual apply per attractor. Above treeThreshold attractors a k-d tree is built in prepare() and
+    //distant clusters are approximated by their total strength at their strength-weighted centre (Barnes-Hut)
+    public:
+    float min_distance; //within this distance of an attractor, that attractor has no effect
+    float theta = 0.5; //opening angle for the tree, smaller is more exact
+    int treeThreshold = 256; //attractor count at which the tree is used
+    std::vector<float> xs, ys, strengths;
+
+    MultiAttractor(float min_distance = 10) : min_distance(min_distance) {paramCount = 0;};
+
+    int addAttractor(Vect2 position, float strength) { //returns attractor index
+        xs.push_back(position.x);
+        ys.push_back(position.y);
+        strengths.push_back(strength);
+        return xs.size() - 1;
+    }
+    void moveAttractor(int index, Vect2 position) {
+        checkIndex(index);
+        xs[index] = position.x;
+        ys[index] = position.y;
+    }
+    void setStrength(int index, float strength) {
+        checkIndex(index);
+        strengths[index] = strength;
+    }
+    void removeAttractor(int index) { //the last attractor takes this index
+        checkIndex(index);
+        xs[index] = xs.back(); xs.pop_back();
+        ys[index] = ys.back(); ys.pop_back();
+        strengths[index] = strengths.back(); strengths.pop_back();
+    }
+    int attractorCount() const { return xs.size(); };
+
+    void prepare() override {
+        // attractors may have moved since the last step, so the tree is rebuilt every step. O(M log M)
+        nodes.clear();
+        useTree = attractorCount() >= treeThreshold;
+        if (!useTree) return;
+        order.resize(attractorCount());
+        std::iota(order.begin(), order.end(), 0);
+        buildNode(0, attractorCount());
+        // leaves read attractors in tree order
+        sortedXs.resize(order.size());
+        sortedYs.resize(order.size());
+        sortedStrengths.resize(order.size());
+        for (int i = 0; i < order.size(); i++) {
+            sortedXs[i] = xs[order[i]];
+            sortedYs[i] = ys[order[i]];
+            sortedStrengths[i] = strengths[order[i]];
+        }
+    }
+
+    void apply(Mover* mover) override {
+        Vect2 acceleration = useTree ? treeAcceleration(mover->position)
+                                     : directAcceleration(mover->position, xs.data(), ys.data(), strengths.data(), 0, attractorCount());
+        mover->apply_force(mover->mass*acceleration);
+    }
+
+    private:
+    struct Node {
+        float minX, minY, maxX, maxY; //bounding box of the attractors in the node
+        float centreX, centreY; //centre weighted by |strength|
+        float strength; //sum of strengths
+        int start, end; //range in order
+        int left = -1, right = -1; //children, -1 for leaves
+    };
+    static constexpr int leafSize = 8;
+    std::vector<Node> nodes;
+    std::vector<int> order;
+    std::vector<float> sortedXs, sortedYs, sortedStrengths;
+    bool useTree = false;
+
+    void checkIndex(int index) const {
+        if (index < 0 || index >= attractorCount()) {
+            throw std::invalid_argument("MultiAttractor: no attractor at index " + std::to_string(index));
+        }
+    }
+
+    Vect2 directAcceleration(Vect2 position, const float* x, const float* y, const float* s, int start, int end) const {
+        // plain loop over contiguous arrays so the compiler can vectorise it
+        float min2 = min_distance*min_distance;
+        float ax = 0, ay = 0;
+        for (int i = start; i < end; i++) {
+            float dx = x[i] - position.x;
+            float dy = y[i] - position.y;
+            float r2 = dx*dx + dy*dy;
+            float scale = r2 < min2 ? 0 : s[i]/(r2*std::sqrt(r2));
+            ax += scale*dx;
+            ay += scale*dy;
+        }
+        return Vect2(ax, ay);
+    }
+
+    int buildNode(int start, int end) {
+        int index = nodes.size();
+        nodes.push_back(Node());
+        Node node;
+        node.start = start;
+        node.end = end;
+        node.minX = node.minY = INFINITY;
+        node.maxX = node.maxY = -INFINITY;
+        float weight = 0, wx = 0, wy = 0;
+        node.strength = 0;
+        for (int i = start; i < end; i++) {
+            int a = order[i];
+            node.minX = std::min(node.minX, xs[a]); node.maxX = std::max(node.maxX, xs[a]);
+            node.minY = std::min(node.minY, ys[a]); node.maxY = std::max(node.maxY, ys[a]);
+            float w = std::abs(strengths[a]);
+            weight += w;
+            wx += w*xs[a];
+            wy += w*ys[a];
+            node.strength += strengths[a];
+        }
+        node.centreX = weight > 0 ? wx/weight : 0.5f*(node.minX + node.maxX);
+        node.centreY = weight > 0 ? wy/weight : 0.5f*(node.minY + node.maxY);
+        if (end - start > leafSize) {
+            // split at the median of the wider axis
+            bool splitX = node.maxX - node.minX >= node.maxY - node.minY;
+            int mid = (start + end)/2;
+            std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](int a, int b) {
+                return splitX ? xs[a] < xs[b] : ys[a] < ys[b];
+            });
+            node.left = buildNode(start, mid);
+            node.right = buildNode(mid, end);
+        }
+        nodes[index] = node;
+        return index;
+    }
+
+    Vect2 treeAcceleration(Vect2 position) const {
+        Vect2 acceleration;
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (node.left < 0) {
+                acceleration += directAcceleration(position, sortedXs.data(), sortedYs.data(), sortedStrengths.data(), node.start, node.end);
+                continue;
+            }
+            float size = std::hypot(node.maxX - node.minX, node.maxY - node.minY); //bounds the centre to attractor distance
+            float dx = node.centreX - position.x;
+            float dy = node.centreY - position.y;
+            float distance = std::sqrt(dx*dx + dy*dy);
+            // far enough that the node looks like a point, and no attractor in it can be within min_distance
+            if (size < theta*distance && distance - size > min_distance) {
+                acceleration += (node.strength/(distance*distance*distance))*Vect2(dx, dy);
+                continue;
+            }
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+        return acceleration;
+    }
+};
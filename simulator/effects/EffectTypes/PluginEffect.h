@@ -0,0 +1,39 @@
+#pragma once
+#include "Mover.h"
+#include "TiledEffect.h"
+#include "PhysKernelABI.h"
+#include <string>
+#include <vector>
+
+class PluginEffect : public TiledEffect {
+  // Runs an effect kernel from a KernelRegistry (e.g. simulator.kernels.find(name)) on every mover.
+  // Per-mover parameters are read from the movers' interactionParams under typeid(PluginEffect), so add it
+  // with kernel.paramCount default parameters
+  public:
+    const phys_kernel& kernel;
+    std::vector<float> constants;
+    const float* currentTime; //passed to the kernel as time, 0 if nullptr
+
+    // throws std::invalid_argument if kernel isn't an effect kernel or takes a different number of constants
+    PluginEffect(const phys_kernel& kernel, std::vector<float> constants = {}, const float* currentTime = nullptr)
+      : TiledEffect(typeid(PluginEffect)), kernel(kernel), constants(constants), currentTime(currentTime) {
+        std::string name = kernel.name;
+        if (kernel.kind != PHYS_EFFECT_KERNEL) throw std::invalid_argument("PluginEffect: " + name + " is not an effect kernel");
+        if (this->constants.size() != kernel.constantCount) {
+          throw std::invalid_argument("PluginEffect: " + name + " takes " + std::to_string(kernel.constantCount) + " constant(s)");
+        }
+        paramCount = kernel.paramCount;
+    };
+
+    void prepare() override {
+      time = currentTime ? *currentTime : 0;
+    }
+
+  protected:
+    void forces(const phys_tile& movers, float* fx, float* fy) override {
+      kernel.effect(&movers, time, constants.data(), fx, fy);
+    }
+
+  private:
+    float time = 0;
+};
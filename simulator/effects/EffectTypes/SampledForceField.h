@@ -0,0 +1,133 @@
+#pragma once
+#include "Effect.h"
+#include <functional>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "Vect2.h"
+
+class SampledForceField : public Effect {
+    // force field stored on a regular grid and interpolated per mover.
+    // the field is either sampled from a function (once, or again on resample()) or loaded from arrays,
+    // so apply() is a few memory lookups instead of a call into the field function.
+    // grid node (i, j) sits at origin + (i*spacing.x, j*spacing.y). fx/fy are row major, index j*nx + i.
+    // positions outside the grid take the value at the nearest edge.
+public:
+    enum class Interpolation { Bilinear, Bicubic };
+
+    std::function<Vect2(Vect2)> fieldFunction; //empty when loaded from arrays
+    Interpolation interpolation;
+    Vect2 origin;
+    Vect2 spacing;
+    int nx, ny;
+    std::vector<float> fx, fy;
+
+    // samples func on an nx by ny grid covering origin to origin + extent
+    SampledForceField(std::function<Vect2(Vect2)> func, Vect2 origin, Vect2 extent, int nx, int ny,
+        Interpolation interpolation = Interpolation::Bilinear)
+        : fieldFunction(func), interpolation(interpolation), origin(origin) {
+        setGrid(extent, nx, ny);
+        resample();
+        paramCount = 1; // scale factor, as for ForceField
+    }
+
+    // takes an already sampled field
+    SampledForceField(std::vector<float> fx, std::vector<float> fy, int nx, int ny, Vect2 origin, Vect2 extent,
+        Interpolation interpolation = Interpolation::Bilinear)
+        : interpolation(interpolation), origin(origin) {
+        setGrid(extent, nx, ny);
+        load(std::move(fx), std::move(fy));
+        paramCount = 1;
+    }
+
+    void resample() {
+        // re-evaluates fieldFunction at every node, e.g. after the function's captured state changed
+        if (!fieldFunction) throw std::invalid_argument("SampledForceField::resample: no field function to sample");
+        fx.resize(nx*ny);
+        fy.resize(nx*ny);
+        for (int j = 0; j < ny; j++) {
+            for (int i = 0; i < nx; i++) {
+                Vect2 force = fieldFunction(origin + Vect2(i*spacing.x, j*spacing.y));
+                fx[j*nx + i] = force.x;
+                fy[j*nx + i] = force.y;
+            }
+        }
+    }
+
+    void resample(std::function<Vect2(Vect2)> func) {
+        fieldFunction = func;
+        resample();
+    }
+
+    void load(std::vector<float> newFx, std::vector<float> newFy) {
+        if (newFx.size() != nx*ny || newFy.size() != nx*ny) {
+            throw std::invalid_argument("SampledForceField::load: expected " + std::to_string(nx*ny) + " values per component");
+        }
+        fx = std::move(newFx);
+        fy = std::move(newFy);
+    }
+
+    Vect2 sample(Vect2 position) const {
+        // grid coordinates, clamped to the grid
+        float gx = std::clamp((position.x - origin.x)/spacing.x, 0.0f, (float)(nx - 1));
+        float gy = std::clamp((position.y - origin.y)/spacing.y, 0.0f, (float)(ny - 1));
+        int i = std::min((int)gx, nx - 2);
+        int j = std::min((int)gy, ny - 2);
+        float tx = gx - i;
+        float ty = gy - j;
+        if (interpolation == Interpolation::Bicubic) {
+            return Vect2(bicubic(fx, i, j, tx, ty), bicubic(fy, i, j, tx, ty));
+        }
+        int n00 = j*nx + i;
+        int n10 = n00 + 1;
+        int n01 = n00 + nx;
+        int n11 = n01 + 1;
+        float w00 = (1 - tx)*(1 - ty), w10 = tx*(1 - ty), w01 = (1 - tx)*ty, w11 = tx*ty;
+        return Vect2(w00*fx[n00] + w10*fx[n10] + w01*fx[n01] + w11*fx[n11],
+                     w00*fy[n00] + w10*fy[n10] + w01*fy[n01] + w11*fy[n11]);
+    }
+
+    void apply(Mover* mover) override {
+        float scale = paramsFromMover(mover);
+        mover->apply_force(sample(mover->position) * scale);
+    }
+
+    std::any interpretParams(std::vector<std::any> params) override {
+        if (params.size() != paramCount) {
+            throw std::invalid_argument("SampledForceField expects exactly 1 parameter (scale factor).");
+        }
+        return std::any_cast<float>(params[0]);
+    }
+
+    float paramsFromMover(Mover* mover) {
+        auto it = mover->interactionParams.find(typeid(SampledForceField));
+        if (it == mover->interactionParams.end()) {
+            throw std::invalid_argument("SampledForceField::paramsFromMover: missing interaction parameters for SampledForceField.");
+        }
+        return std::any_cast<float>(interpretParams(it->second));
+    }
+
+private:
+    void setGrid(Vect2 extent, int newNx, int newNy) {
+        if (newNx < 2 || newNy < 2) throw std::invalid_argument("SampledForceField: grid needs at least 2 nodes per axis");
+        if (extent.x <= 0 || extent.y <= 0) throw std::invalid_argument("SampledForceField: extent must be positive");
+        nx = newNx;
+        ny = newNy;
+        spacing = Vect2(extent.x/(nx - 1), extent.y/(ny - 1));
+    }
+
+    static float cubic(float p0, float p1, float p2, float p3, float t) {
+        //catmull-rom through p1 (t=0) and p2 (t=1)
+        return p1 + 0.5f*t*(p2 - p0 + t*(2*p0 - 5*p1 + 4*p2 - p3 + t*(3*(p1 - p2) + p3 - p0)));
+    }
+
+    float bicubic(const std::vector<float>& f, int i, int j, float tx, float ty) const {
+        float rows[4];
+        for (int r = 0; r < 4; r++) {
+            int row = std::clamp(j - 1 + r, 0, ny - 1)*nx;
+            rows[r] = cubic(f[row + std::max(i - 1, 0)], f[row + i], f[row + i + 1], f[row + std::min(i + 2, nx - 1)], tx);
+        }
+        return cubic(rows[0], rows[1], rows[2], rows[3], ty);
+    }
+};
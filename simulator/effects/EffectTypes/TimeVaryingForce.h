@@ -14,6 +14,7 @@ class TimeVaryingForce : public Effect {
   public:
     std::function<Vect2(float)> forceFunction;
     float& currentTime;
+    Vect2 preparedForce; //forceFunction(currentTime) as of the last prepare()
     TimeVaryingForce(std::function<Vect2(float)> forceFunction,
      float& currentTime) // reference to current time in simulator, 
      // or some other time variable that outlives the effect
@@ -30,7 +31,18 @@ class TimeVaryingForce : public Effect {
       Vect2 scaledForce = currentForce * scaleFactor;
       mover->apply_force(scaledForce);
     }
-    
+
+    void prepare() override {
+      // the force only depends on time, so forceFunction runs once per step rather than once per mover
+      preparedForce = forceFunction(currentTime);
+    }
+
+    void applyRange(std::vector<std::unique_ptr<Mover>>& movers, int start, int end) override {
+      for (int i = start; i < end; i++) {
+        Mover* mover = movers[i].get();
+        mover->apply_force(preparedForce * paramsFromMover(mover));
+      }
+    }
 
     
     std::any interpretParams(std::vector<std::any> params) override {
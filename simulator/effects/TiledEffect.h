@@ -0,0 +1,72 @@
+#pragma once
+#include "Mover.h"
+#include "Effect.h"
+#include "Expression.h"
+#include "PhysKernelABI.h"
+#include <typeindex>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+class TiledEffect : public Effect {
+  // Effect whose forces are computed a tile at a time, for expression and plugin kernels.
+  // applyRange copies up to TILE movers' state, and their per-mover parameters from interactionParams[paramKey],
+  // into arrays, hands them to forces, and applies the forces it writes.
+  public:
+    static constexpr int TILE = 64;
+
+    void apply(Mover* mover) override {
+      prepare();
+      applyTiles(1, [mover](int) { return mover; });
+    }
+
+    void applyRange(std::vector<std::unique_ptr<Mover>>& movers, int start, int end) override {
+      applyTiles(end - start, [&movers, start](int i) { return movers[start + i].get(); });
+    }
+
+  protected:
+    TiledEffect(std::type_index paramKey) : paramKey(paramKey) {};
+    void virtual forces(const phys_tile& movers, float* fx, float* fy) = 0;
+
+  private:
+    std::type_index paramKey;
+
+    template <class MoverAt>
+    void applyTiles(int count, MoverAt moverAt) {
+      int ids[TILE];
+      float columns[6][TILE], fx[TILE], fy[TILE];
+      std::vector<float> paramColumns(paramCount*TILE);
+      std::vector<const float*> params(paramCount);
+      for (int k = 0; k < paramCount; k++) params[k] = &paramColumns[k*TILE];
+      phys_tile tile = {0, ids, columns[0], columns[1], columns[2], columns[3], columns[4], columns[5],
+        paramCount, params.data()};
+      for (int tileStart = 0; tileStart < count; tileStart += TILE) {
+        int lanes = std::min(TILE, count - tileStart);
+        for (int l = 0; l < lanes; l++) {
+          Mover& mover = *moverAt(tileStart + l);
+          ids[l] = mover.id;
+          columns[0][l] = mover.position.x;
+          columns[1][l] = mover.position.y;
+          columns[2][l] = mover.velocity.x;
+          columns[3][l] = mover.velocity.y;
+          columns[4][l] = mover.mass;
+          columns[5][l] = mover.radius;
+          if (paramCount == 0) continue;
+          // checked in place, the same as interpretParams, so a step doesn't copy every mover's parameters
+          auto found = mover.interactionParams.find(paramKey);
+          if (found == mover.interactionParams.end() || found->second.size() != paramCount) {
+            throw std::invalid_argument("Effect::interpretParams: incorrect number of parameters. Expected " +
+                                        std::to_string(paramCount) + " parameter(s).");
+          }
+          const std::vector<std::any>& moverParams = found->second;
+          for (int k = 0; k < paramCount; k++) paramColumns[k*TILE + l] = Expression::toFloat(moverParams[k]);
+        }
+        tile.count = lanes;
+        std::fill_n(fx, lanes, 0.0f);
+        std::fill_n(fy, lanes, 0.0f);
+        forces(tile, fx, fy);
+        for (int l = 0; l < lanes; l++) moverAt(tileStart + l)->apply_force(Vect2(fx[l], fy[l]));
+      }
+    }
+};
@@ -3,10 +3,12 @@
 #include "EffectTypes/Drag.h"
 #include "EffectTypes/LorentzEffect.h"
 #include "EffectTypes/Attractor.h"
+#include "EffectTypes/MultiAttractor.h"
 #include "EffectTypes/ConstantAcceleration.h"
 #include "EffectTypes/ConstantForce.h"
 #include "EffectTypes/TimeVaryingForce.h"
 #include "EffectTypes/ForceField.h"
+#include "EffectTypes/SampledForceField.h"
 #include "Mover.h"
 #include <cmath>
 
@@ -195,6 +197,54 @@ TEST_F(AttractorFixture, ApplyEffectWithinMinDistance) {
   EXPECT_EQ(actualForce, Vect2(0, 0));
 }
 
+TEST_F(AttractorFixture, MultiAttractorMatchesSeparateAttractors) {
+  MultiAttractor multi(2.0f);
+  std::vector<Attractor> singles;
+  for (int i = 0; i < 20; i++) {
+    Vect2 position(std::cos(i)*30, std::sin(2*i)*30);
+    float strength = i % 3 == 0 ? -5.0f : 10.0f;
+    multi.addAttractor(position, strength);
+    singles.push_back(Attractor(strength, position, 2.0f));
+  }
+  multi.moveAttractor(4, Vect2(1, 1)); //within min_distance of the mover, so it's skipped
+  singles[4].position = Vect2(1, 1);
+  auto mover = createMover(Vect2(0.5f, 0.5f), Vect2(0, 0), 2.0f);
+  auto reference = createMover(Vect2(0.5f, 0.5f), Vect2(0, 0), 2.0f);
+  multi.prepare();
+  multi.apply(mover.get());
+  for (auto& attractor : singles) attractor.apply(reference.get());
+  Vect2 force = dynamic_cast<NewtMover*>(mover.get())->force_sum.load();
+  Vect2 expected = dynamic_cast<NewtMover*>(reference.get())->force_sum.load();
+  EXPECT_NEAR(force.x, expected.x, 1e-4);
+  EXPECT_NEAR(force.y, expected.y, 1e-4);
+}
+
+TEST_F(AttractorFixture, MultiAttractorTreeApproximatesDirectSum) {
+  MultiAttractor direct(1.0f);
+  MultiAttractor tree(1.0f);
+  direct.treeThreshold = 1000000;
+  tree.treeThreshold = 16;
+  tree.theta = 0.3f;
+  for (int i = 0; i < 2000; i++) { //a cluster far from the movers
+    Vect2 position(200 + (i % 50), 300 + (i / 50));
+    direct.addAttractor(position, 1.0f);
+    tree.addAttractor(position, 1.0f);
+  }
+  direct.prepare();
+  tree.prepare();
+  for (Vect2 position : {Vect2(0, 0), Vect2(-100, 50), Vect2(220, 280)}) {
+    auto exact = createMover(position, Vect2(0, 0));
+    auto approx = createMover(position, Vect2(0, 0));
+    direct.apply(exact.get());
+    tree.apply(approx.get());
+    Vect2 expected = dynamic_cast<NewtMover*>(exact.get())->force_sum.load();
+    Vect2 force = dynamic_cast<NewtMover*>(approx.get())->force_sum.load();
+    EXPECT_NEAR(force.x, expected.x, 0.01f*expected.mag());
+    EXPECT_NEAR(force.y, expected.y, 0.01f*expected.mag());
+  }
+  EXPECT_THROW(tree.moveAttractor(2000, Vect2()), std::invalid_argument);
+}
+
 // ConstantAcceleration Tests
 class ConstantAccelerationFixture : public EffectFixture {};
 
@@ -349,6 +399,24 @@ TEST_F(TimeVaryingForceFixture, TimeSourceReference) {
   EXPECT_NEAR(laterTimeForce.y, 4.0f, 0.04f); // Use 0.01 * expected = 0.04
 }
 
+TEST_F(TimeVaryingForceFixture, PrepareEvaluatesOncePerStep) {
+  float timeSource = 1.0f;
+  int calls = 0;
+  TimeVaryingForce force([&calls](float t) { calls++; return Vect2(t, -t); }, timeSource);
+  std::vector<std::unique_ptr<Mover>> movers;
+  for (int i = 0; i < 10; i++) {
+    movers.push_back(createTestMover());
+    setupMoverParams<TimeVaryingForce>(movers.back().get(), {(float)i});
+  }
+  force.prepare();
+  force.applyRange(movers, 0, 5);
+  force.applyRange(movers, 5, 10);
+  EXPECT_EQ(calls, 1);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(dynamic_cast<NewtMover*>(movers[i].get())->force_sum.load(), Vect2(i, -i));
+  }
+}
+
 // ForceField Tests
 class ForceFieldFixture : public EffectFixture {};
 
@@ -379,3 +447,43 @@ TEST_F(ForceFieldFixture, ApplyEffect) {
     EXPECT_NEAR(actualForce.y, expectedForce.y, tolY);
 }
 
+// SampledForceField Tests
+class SampledForceFieldFixture : public EffectFixture {};
+
+TEST_F(SampledForceFieldFixture, BilinearExactForLinearField) {
+    // bilinear interpolation reproduces a linear field everywhere inside the grid
+    auto linear = [](Vect2 pos) { return Vect2(2*pos.x + pos.y, -pos.y + 3); };
+    SampledForceField field(linear, Vect2(-10, -10), Vect2(20, 20), 11, 21);
+    EXPECT_EQ(field.paramCount, 1);
+    for (Vect2 pos : {Vect2(0.3f, -4.7f), Vect2(9.9f, 9.9f), Vect2(-10, 3.14f)}) {
+        Vect2 sampled = field.sample(pos);
+        EXPECT_NEAR(sampled.x, linear(pos).x, 1e-4);
+        EXPECT_NEAR(sampled.y, linear(pos).y, 1e-4);
+    }
+    // outside the grid the edge value is used
+    EXPECT_NEAR(field.sample(Vect2(50, 0)).x, linear(Vect2(10, 0)).x, 1e-4);
+}
+
+TEST_F(SampledForceFieldFixture, BicubicCloserThanBilinearForCurvedField) {
+    auto curved = [](Vect2 pos) { return Vect2(std::sin(pos.x), std::cos(pos.y)); };
+    SampledForceField bilinear(curved, Vect2(0, 0), Vect2(6, 6), 13, 13);
+    SampledForceField bicubic(curved, Vect2(0, 0), Vect2(6, 6), 13, 13, SampledForceField::Interpolation::Bicubic);
+    Vect2 pos(2.2f, 3.7f);
+    float bilinearError = std::abs(bilinear.sample(pos).x - curved(pos).x) + std::abs(bilinear.sample(pos).y - curved(pos).y);
+    float bicubicError = std::abs(bicubic.sample(pos).x - curved(pos).x) + std::abs(bicubic.sample(pos).y - curved(pos).y);
+    EXPECT_LT(bicubicError, bilinearError);
+    EXPECT_LT(bicubicError, 1e-2);
+}
+
+TEST_F(SampledForceFieldFixture, LoadFromArraysAndResample) {
+    // 2x2 grid over [0,1]x[0,1], fx is 0 on the left and 4 on the right
+    SampledForceField field({0, 4, 0, 4}, {1, 1, 1, 1}, 2, 2, Vect2(0, 0), Vect2(1, 1));
+    auto mover = createMover(Vect2(0.25f, 0.5f), Vect2(0, 0));
+    setupMoverParams<SampledForceField>(mover.get(), {2.0f});
+    field.apply(mover.get());
+    EXPECT_EQ(dynamic_cast<NewtMover*>(mover.get())->force_sum.load(), Vect2(2, 2));
+    EXPECT_THROW(field.resample(), std::invalid_argument); //no function to sample
+    EXPECT_THROW(field.load({1, 2, 3}, {1, 2, 3}), std::invalid_argument);
+    field.resample([](Vect2 pos) { return Vect2(0, pos.y); });
+    EXPECT_EQ(field.sample(Vect2(0.25f, 0.5f)), Vect2(0, 0.5f));
+}
@@ -0,0 +1,224 @@
+#include "BondNetwork.h"
+#include <algorithm>
+#include <unordered_set>
+#include <future>
+
+int BondNetwork::nodeFor(int moverId) {
+  auto it = nodeIndex.find(moverId);
+  if (it != nodeIndex.end()) return it->second;
+  int node = nodeMoverIds.size();
+  nodeMoverIds.push_back(moverId);
+  nodeIndex[moverId] = node;
+  return node;
+}
+
+int BondNetwork::addBond(int moverId1, int moverId2, float k, float x0) {
+  if (moverId1 == moverId2) throw std::invalid_argument("BondNetwork::addBond: a mover can't be bonded to itself");
+  bondNode1.push_back(nodeFor(moverId1));
+  bondNode2.push_back(nodeFor(moverId2));
+  bondK.push_back(k);
+  bondX0.push_back(x0);
+  dirty = true;
+  return bondNode1.size() - 1;
+}
+
+int BondNetwork::removeBondsByMoverId(int moverId) {
+  return removeMovers({moverId});
+}
+
+int BondNetwork::removeMovers(const std::vector<int>& moverIds) {
+  std::vector<char> removedNode(nodeMoverIds.size(), 0);
+  bool any = false;
+  for (int id : moverIds) {
+    auto it = nodeIndex.find(id);
+    if (it == nodeIndex.end()) continue;
+    removedNode[it->second] = 1;
+    any = true;
+  }
+  if (!any) return 0;
+  // renumber the remaining nodes, keeping their order
+  std::vector<int> remap(nodeMoverIds.size(), -1);
+  int keptNodes = 0;
+  for (int n = 0; n < nodeMoverIds.size(); n++) {
+    if (removedNode[n]) {
+      nodeIndex.erase(nodeMoverIds[n]);
+      continue;
+    }
+    remap[n] = keptNodes;
+    nodeMoverIds[keptNodes] = nodeMoverIds[n];
+    nodeIndex[nodeMoverIds[n]] = keptNodes;
+    keptNodes++;
+  }
+  nodeMoverIds.resize(keptNodes);
+  int kept = 0;
+  for (int b = 0; b < bondCount(); b++) {
+    if (removedNode[bondNode1[b]] || removedNode[bondNode2[b]]) continue;
+    bondNode1[kept] = remap[bondNode1[b]];
+    bondNode2[kept] = remap[bondNode2[b]];
+    bondK[kept] = bondK[b];
+    bondX0[kept] = bondX0[b];
+    kept++;
+  }
+  int removed = bondCount() - kept;
+  bondNode1.resize(kept);
+  bondNode2.resize(kept);
+  bondK.resize(kept);
+  bondX0.resize(kept);
+  dirty = true;
+  return removed;
+}
+
+void BondNetwork::clear() {
+  nodeMoverIds.clear();
+  nodeIndex.clear();
+  nodeMovers.clear();
+  bondNode1.clear();
+  bondNode2.clear();
+  bondK.clear();
+  bondX0.clear();
+  dirty = true;
+}
+
+std::vector<int> BondNetwork::bondedMoverIds(int moverId) {
+  std::vector<int> ids;
+  auto it = nodeIndex.find(moverId);
+  if (it == nodeIndex.end()) return ids;
+  if (dirty) rebuild();
+  int node = it->second;
+  for (int i = adjacencyOffsets[node]; i < adjacencyOffsets[node + 1]; i++) {
+    int b = adjacencyBonds[i];
+    int other = bondNode1[b] == node ? bondNode2[b] : bondNode1[b];
+    ids.push_back(nodeMoverIds[other]);
+  }
+  return ids;
+}
+
+void BondNetwork::getBonds(std::vector<int>& moverIds1, std::vector<int>& moverIds2, std::vector<float>& k, std::vector<float>& x0) const {
+  moverIds1.resize(bondCount());
+  moverIds2.resize(bondCount());
+  for (int b = 0; b < bondCount(); b++) {
+    moverIds1[b] = nodeMoverIds[bondNode1[b]];
+    moverIds2[b] = nodeMoverIds[bondNode2[b]];
+  }
+  k = bondK;
+  x0 = bondX0;
+}
+
+void BondNetwork::rebuild() {
+  int nodeCount = nodeMoverIds.size();
+  // CSR adjacency by counting sort over both endpoints
+  adjacencyOffsets.assign(nodeCount + 1, 0);
+  for (int b = 0; b < bondCount(); b++) {
+    adjacencyOffsets[bondNode1[b] + 1]++;
+    adjacencyOffsets[bondNode2[b] + 1]++;
+  }
+  for (int n = 0; n < nodeCount; n++) adjacencyOffsets[n + 1] += adjacencyOffsets[n];
+  adjacencyBonds.resize(adjacencyOffsets[nodeCount]);
+  std::vector<int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+  for (int b = 0; b < bondCount(); b++) {
+    adjacencyBonds[fill[bondNode1[b]]++] = b;
+    adjacencyBonds[fill[bondNode2[b]]++] = b;
+  }
+
+  // greedy edge colouring: each bond takes the lowest colour not used by a bond at either end.
+  // at most 2*maxDegree - 1 colours
+  std::vector<int> bondColor(bondCount(), -1);
+  std::vector<int> usedBy; //usedBy[c] == b marks colour c as taken while colouring bond b
+  int numColors = 0;
+  for (int b = 0; b < bondCount(); b++) {
+    for (int node : {bondNode1[b], bondNode2[b]}) {
+      for (int i = adjacencyOffsets[node]; i < adjacencyOffsets[node + 1]; i++) {
+        int color = bondColor[adjacencyBonds[i]];
+        if (color < 0) continue;
+        if (color >= usedBy.size()) usedBy.resize(color + 1, -1);
+        usedBy[color] = b;
+      }
+    }
+    int color = 0;
+    while (color < usedBy.size() && usedBy[color] == b) color++;
+    bondColor[b] = color;
+    numColors = std::max(numColors, color + 1);
+  }
+  colorOffsets.assign(numColors + 1, 0);
+  for (int color : bondColor) colorOffsets[color + 1]++;
+  for (int c = 0; c < numColors; c++) colorOffsets[c + 1] += colorOffsets[c];
+  colorOrder.resize(bondCount());
+  std::vector<int> colorFill(colorOffsets.begin(), colorOffsets.end() - 1);
+  for (int b = 0; b < bondCount(); b++) {
+    colorOrder[colorFill[bondColor[b]]++] = b;
+  }
+  dirty = false;
+}
+
+std::vector<int> BondNetwork::resolveNodes(std::vector<std::unique_ptr<Mover>>& movers) {
+  auto compare = [](const std::unique_ptr<Mover>& mover, int id) { return mover->id < id; };
+  std::vector<int> missing;
+  nodeMovers.resize(nodeMoverIds.size());
+  nodeForceTargets.resize(nodeMoverIds.size());
+  for (int n = 0; n < nodeMoverIds.size(); n++) {
+    int id = nodeMoverIds[n];
+    auto it = std::lower_bound(movers.begin(), movers.end(), id, compare);
+    if (it == movers.end() || (*it)->id != id) {
+      nodeMovers[n] = nullptr;
+      nodeForceTargets[n] = nullptr;
+      missing.push_back(id);
+      continue;
+    }
+    nodeMovers[n] = it->get();
+    nodeForceTargets[n] = dynamic_cast<NewtMover*>(it->get()); //base Movers ignore forces
+  }
+  return missing;
+}
+
+void BondNetwork::applyRange(int start, int end) {
+  // bonds in [start, end) of colorOrder share no mover with any other bond of their colour,
+  // so force_sum can be updated with a plain load/store instead of apply_force's compare-exchange loop
+  auto addForce = [](NewtMover* mover, Vect2 force) {
+    if (mover == nullptr) return;
+    mover->force_sum.store(mover->force_sum.load(std::memory_order_relaxed) + force, std::memory_order_relaxed);
+  };
+  for (int i = start; i < end; i++) {
+    int b = colorOrder[i];
+    Vect2 r = nodeMovers[bondNode1[b]]->position - nodeMovers[bondNode2[b]]->position;
+    float magnitude = r.mag();
+    if (magnitude == 0) continue; //direction undefined
+    Vect2 springForce = (-bondK[b]*(magnitude - bondX0[b])/magnitude) * r;
+    addForce(nodeForceTargets[bondNode1[b]], springForce);
+    addForce(nodeForceTargets[bondNode2[b]], -1*springForce);
+  }
+}
+
+void BondNetwork::apply(std::vector<std::unique_ptr<Mover>>& movers, ThreadPool* pool) {
+  if (bondCount() == 0) return;
+  std::vector<int> missing = resolveNodes(movers);
+  if (!missing.empty()) {
+    // bonded movers were removed from the simulator. drop them and their bonds
+    removeMovers(missing);
+    if (bondCount() == 0) return;
+    resolveNodes(movers);
+  }
+  if (dirty) rebuild();
+
+  unsigned int thread_count = pool == nullptr ? 1 : std::thread::hardware_concurrency();
+  const int minChunk = 1024; //below this a colour is cheaper to evaluate on this thread
+  std::vector<std::future<void>> futures;
+  for (int c = 0; c < colorCount(); c++) {
+    int start = colorOffsets[c];
+    int end = colorOffsets[c + 1];
+    int count = end - start;
+    if (thread_count <= 1 || count < 2*minChunk) {
+      applyRange(start, end);
+      continue;
+    }
+    int chunk_size = std::max(minChunk, (int)((count + thread_count - 1) / thread_count));
+    for (int chunkStart = start; chunkStart < end; chunkStart += chunk_size) {
+      int chunkEnd = std::min(end, chunkStart + chunk_size);
+      futures.push_back(pool->enqueue([this, chunkStart, chunkEnd]() {
+        applyRange(chunkStart, chunkEnd);
+      }));
+    }
+    // a mover appears at most once per colour, but may appear in the next one
+    for (auto& future : futures) future.get();
+    futures.clear();
+  }
+}
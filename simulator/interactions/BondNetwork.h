@@ -0,0 +1,57 @@
+#pragma once
+#include "Mover.h"
+#include "Vect2.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+/*
+Explicit pairwise bonds between movers (harmonic springs with their own k and x0 per bond).
+Unlike an InteractingGroup, which interacts every pair of its members, only the listed bonds are
+evaluated, so chains, meshes and lattices cost O(bonds) per step.
+
+Bonds are kept as an edge list (struct of arrays) over network nodes, where a node is one bonded mover.
+A CSR adjacency (node -> bonds) is built from it for colouring and neighbour queries.
+Bonds are edge-coloured so that no two bonds of the same colour share a mover: each colour can then be
+evaluated in parallel with forces written straight into the movers, without atomic read-modify-writes.
+*/
+
+class BondNetwork {
+  public:
+    int addBond(int moverId1, int moverId2, float k, float x0); //returns bond index
+    int removeBondsByMoverId(int moverId); //returns number of bonds removed
+    int removeMovers(const std::vector<int>& moverIds); //removes all bonds of these movers
+    void clear();
+    int bondCount() const { return bondNode1.size(); };
+    int colorCount() const { return colorOffsets.empty() ? 0 : colorOffsets.size() - 1; };
+    std::vector<int> bondedMoverIds(int moverId); //movers sharing a bond with moverId
+    // every bond as mover ids and parameters, in bond index order
+    void getBonds(std::vector<int>& moverIds1, std::vector<int>& moverIds2, std::vector<float>& k, std::vector<float>& x0) const;
+    // adds bond forces to the movers. movers must be sorted by id, as Simulator keeps them.
+    // pool may be nullptr to evaluate on this thread
+    void apply(std::vector<std::unique_ptr<Mover>>& movers, ThreadPool* pool = nullptr);
+
+  private:
+    int nodeFor(int moverId);
+    void rebuild(); //CSR adjacency and edge colouring, after bonds change
+    std::vector<int> resolveNodes(std::vector<std::unique_ptr<Mover>>& movers); //returns ids of bonded movers that are gone
+    void applyRange(int start, int end);
+
+    // nodes
+    std::vector<int> nodeMoverIds;
+    std::unordered_map<int, int> nodeIndex; //moverId -> node
+    // resolved each step
+    std::vector<Mover*> nodeMovers;
+    std::vector<NewtMover*> nodeForceTargets; //nullptr for movers that don't take forces
+    // bonds, struct of arrays
+    std::vector<int> bondNode1, bondNode2;
+    std::vector<float> bondK, bondX0;
+    // CSR adjacency: bonds of node n are adjacencyBonds[adjacencyOffsets[n]..adjacencyOffsets[n+1])
+    std::vector<int> adjacencyOffsets;
+    std::vector<int> adjacencyBonds;
+    // bond indices grouped by colour: colorOrder[colorOffsets[c]..colorOffsets[c+1])
+    std::vector<int> colorOrder;
+    std::vector<int> colorOffsets;
+    bool dirty = true;
+};
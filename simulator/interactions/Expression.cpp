@@ -0,0 +1,321 @@
+#include "Expression.h"
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+
+struct Expression::Node {
+  Op op;
+  bool vector = false;
+  float value = 0; //PUSH
+  int a = 0, b = 0; //LOAD, LOAD_VEC slots
+  std::vector<Node> children;
+};
+
+class Expression::Parser {
+  // recursive descent, one method per precedence level. nodes are type checked (and folded) as they are built
+  public:
+    Parser(const std::string& text, const std::vector<ExpressionVariable>& variables,
+      const std::unordered_map<std::string, float>& constants)
+      : text(text), variables(variables), constants(constants) {};
+
+    Node parse() {
+      Node node = sum();
+      skipSpace();
+      if (at < text.size()) fail("unexpected '" + std::string(1, text[at]) + "'");
+      return node;
+    }
+
+  private:
+    const std::string& text;
+    const std::vector<ExpressionVariable>& variables;
+    const std::unordered_map<std::string, float>& constants;
+    size_t at = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+      throw std::invalid_argument("Expression: " + message + " at position " + std::to_string(at) + " in \"" + text + "\"");
+    }
+    void skipSpace() {
+      while (at < text.size() && std::isspace((unsigned char)text[at])) at++;
+    }
+    bool accept(char c) {
+      skipSpace();
+      if (at < text.size() && text[at] == c) {
+        at++;
+        return true;
+      }
+      return false;
+    }
+    void expect(char c) {
+      if (!accept(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    Node sum() {
+      Node node = product();
+      while (true) {
+        if (accept('+')) node = combine('+', std::move(node), product());
+        else if (accept('-')) node = combine('-', std::move(node), product());
+        else return node;
+      }
+    }
+    Node product() {
+      Node node = unary();
+      while (true) {
+        if (accept('*')) node = combine('*', std::move(node), unary());
+        else if (accept('/')) node = combine('/', std::move(node), unary());
+        else return node;
+      }
+    }
+    Node unary() {
+      if (accept('-')) {
+        Node operand = unary();
+        bool vector = operand.vector;
+        return make(vector ? NEG_VEC : NEG, vector, {std::move(operand)});
+      }
+      if (accept('+')) return unary();
+      return power();
+    }
+    Node power() {
+      Node base = primary();
+      if (!accept('^')) return base;
+      return combine('^', std::move(base), unary()); //right associative, and binds tighter than a leading minus
+    }
+    Node primary() {
+      skipSpace();
+      if (at >= text.size()) fail("unexpected end");
+      if (accept('(')) {
+        Node node = sum();
+        expect(')');
+        return node;
+      }
+      char c = text[at];
+      if (std::isdigit((unsigned char)c) || c == '.') {
+        const char* start = text.c_str() + at;
+        char* end;
+        float value = std::strtof(start, &end);
+        if (end == start) fail("bad number");
+        at += end - start;
+        return number(value);
+      }
+      if (std::isalpha((unsigned char)c) || c == '_') {
+        size_t start = at;
+        while (at < text.size() && (std::isalnum((unsigned char)text[at]) || text[at] == '_')) at++;
+        std::string name = text.substr(start, at - start);
+        if (accept('(')) return call(name);
+        for (auto& variable : variables) {
+          if (variable.name != name) continue;
+          Node node;
+          node.op = variable.isVector() ? LOAD_VEC : LOAD;
+          node.vector = variable.isVector();
+          node.a = variable.slot;
+          node.b = variable.ySlot;
+          return node;
+        }
+        auto constant = constants.find(name);
+        if (constant != constants.end()) return number(constant->second);
+        at = start;
+        fail("unknown name '" + name + "'");
+      }
+      fail("unexpected '" + std::string(1, c) + "'");
+    }
+
+    Node call(const std::string& name) {
+      std::vector<Node> args;
+      if (!accept(')')) {
+        do args.push_back(sum()); while (accept(','));
+        expect(')');
+      }
+      struct Function { const char* name; Op op; int argCount; bool vectorArgs; bool vectorResult; };
+      static const Function functions[] = {
+        {"sqrt", SQRT, 1, false, false}, {"exp", EXP, 1, false, false}, {"log", LOG, 1, false, false},
+        {"abs", ABS, 1, false, false}, {"sin", SIN, 1, false, false}, {"cos", COS, 1, false, false},
+        {"tanh", TANH, 1, false, false}, {"step", STEP, 1, false, false}, {"min", MIN, 2, false, false},
+        {"max", MAX, 2, false, false}, {"pow", POW, 2, false, false}, {"vec", MAKE_VEC, 2, false, true},
+        {"dot", DOT, 2, true, false}, {"mag", MAG, 1, true, false}, {"x", X_OF, 1, true, false},
+        {"y", Y_OF, 1, true, false},
+      };
+      for (auto& function : functions) {
+        if (name != function.name) continue;
+        if (args.size() != function.argCount) {
+          fail(name + " takes " + std::to_string(function.argCount) + " argument(s)");
+        }
+        for (auto& arg : args) {
+          if (arg.vector != function.vectorArgs) fail(name + " takes " + (function.vectorArgs ? "vector" : "scalar") + " arguments");
+        }
+        return make(function.op, function.vectorResult, std::move(args));
+      }
+      fail("unknown function '" + name + "'");
+    }
+
+    Node combine(char op, Node left, Node right) {
+      bool l = left.vector, r = right.vector;
+      std::vector<Node> args;
+      args.push_back(std::move(left));
+      args.push_back(std::move(right));
+      switch (op) {
+        case '+':
+          if (l == r) return make(l ? ADD_VEC : ADD, l, std::move(args));
+          break;
+        case '-':
+          if (l == r) return make(l ? SUB_VEC : SUB, l, std::move(args));
+          break;
+        case '*':
+          if (!l && !r) return make(MUL, false, std::move(args));
+          if (!l && r) return make(SCALE, true, std::move(args));
+          if (l && !r) return make(SCALE_RIGHT, true, std::move(args));
+          fail("vectors can't be multiplied, use dot()");
+        case '/':
+          if (!r) return make(l ? DIV_VEC : DIV, l, std::move(args));
+          break;
+        case '^':
+          if (!l && !r) return make(POW, false, std::move(args));
+          break;
+      }
+      fail(std::string("'") + op + "' can't combine " + (l ? "a vector" : "a scalar") + " with " + (r ? "a vector" : "a scalar"));
+    }
+
+    static Node number(float value) {
+      Node node;
+      node.op = PUSH;
+      node.value = value;
+      return node;
+    }
+
+    static Node make(Op op, bool vector, std::vector<Node> args) {
+      bool constant = !vector;
+      for (auto& arg : args) constant = constant && arg.op == PUSH;
+      if (constant) {
+        // fold by running the instruction on a single lane
+        float stack[MAX_DEPTH][2][TILE];
+        int top = 0;
+        for (auto& arg : args) stack[top++][0][0] = arg.value;
+        Instruction instruction;
+        instruction.op = op;
+        run(instruction, stack, top, nullptr, 1);
+        return number(stack[0][0][0]);
+      }
+      Node node;
+      node.op = op;
+      node.vector = vector;
+      node.children = std::move(args);
+      return node;
+    }
+};
+
+Expression::Expression(const std::string& source, const std::vector<ExpressionVariable>& variables,
+  const std::unordered_map<std::string, float>& constants) : text(source) {
+    Node root = Parser(text, variables, constants).parse();
+    int maxDepth = 0;
+    emit(root, 0, maxDepth);
+    if (maxDepth > MAX_DEPTH) {
+      throw std::invalid_argument("Expression: \"" + text + "\" nests too deeply, it needs " + std::to_string(maxDepth)
+        + " stack entries and at most " + std::to_string(MAX_DEPTH) + " are available");
+    }
+    vectorResult = root.vector;
+};
+
+void Expression::emit(const Node& node, int depth, int& maxDepth) {
+  // post order: the node's value ends up in stack entry depth, its children's in depth, depth + 1, ...
+  for (int i = 0; i < node.children.size(); i++) emit(node.children[i], depth + i, maxDepth);
+  maxDepth = std::max(maxDepth, depth + 1);
+  Instruction instruction;
+  instruction.op = node.op;
+  instruction.a = node.a;
+  instruction.b = node.b;
+  instruction.value = node.value;
+  program.push_back(instruction);
+  if (node.op == LOAD || node.op == LOAD_VEC) {
+    usedSlots.push_back(node.a);
+    if (node.op == LOAD_VEC) usedSlots.push_back(node.b);
+  }
+};
+
+bool Expression::uses(int slot) const {
+  return std::find(usedSlots.begin(), usedSlots.end(), slot) != usedSlots.end();
+};
+
+float Expression::toFloat(const std::any& value) {
+  if (value.type() == typeid(float)) return std::any_cast<float>(value);
+  if (value.type() == typeid(double)) return std::any_cast<double>(value);
+  if (value.type() == typeid(int)) return std::any_cast<int>(value);
+  throw std::invalid_argument("Expression: parameters must be numbers");
+};
+
+void Expression::evaluate(const float* const* inputs, int lanes, float* outX, float* outY) const {
+  float stack[MAX_DEPTH][2][TILE];
+  int top = 0;
+  for (auto& instruction : program) run(instruction, stack, top, inputs, lanes);
+  std::copy(stack[0][0], stack[0][0] + lanes, outX);
+  if (vectorResult) std::copy(stack[0][1], stack[0][1] + lanes, outY);
+};
+
+void Expression::run(const Instruction& instruction, float (*stack)[2][TILE], int& top, const float* const* inputs, int lanes) {
+  // each case is one loop over the lanes. binary ops leave their result in the left operand's entry
+  float* x = top >= 1 ? stack[top - 1][0] : nullptr; //top entry, the operand of unary ops
+  float* y = top >= 1 ? stack[top - 1][1] : nullptr;
+  float* ax = top >= 2 ? stack[top - 2][0] : nullptr; //left operand of binary ops
+  float* ay = top >= 2 ? stack[top - 2][1] : nullptr;
+  switch (instruction.op) {
+    case PUSH: {
+      float* out = stack[top++][0];
+      for (int i = 0; i < lanes; i++) out[i] = instruction.value;
+      return;
+    }
+    case LOAD: {
+      std::copy(inputs[instruction.a], inputs[instruction.a] + lanes, stack[top++][0]);
+      return;
+    }
+    case LOAD_VEC: {
+      std::copy(inputs[instruction.a], inputs[instruction.a] + lanes, stack[top][0]);
+      std::copy(inputs[instruction.b], inputs[instruction.b] + lanes, stack[top][1]);
+      top++;
+      return;
+    }
+    case ADD: for (int i = 0; i < lanes; i++) ax[i] += x[i]; top--; return;
+    case SUB: for (int i = 0; i < lanes; i++) ax[i] -= x[i]; top--; return;
+    case MUL: for (int i = 0; i < lanes; i++) ax[i] *= x[i]; top--; return;
+    case DIV: for (int i = 0; i < lanes; i++) ax[i] /= x[i]; top--; return;
+    case POW: for (int i = 0; i < lanes; i++) ax[i] = std::pow(ax[i], x[i]); top--; return;
+    case MIN: for (int i = 0; i < lanes; i++) ax[i] = std::min(ax[i], x[i]); top--; return;
+    case MAX: for (int i = 0; i < lanes; i++) ax[i] = std::max(ax[i], x[i]); top--; return;
+    case NEG: for (int i = 0; i < lanes; i++) x[i] = -x[i]; return;
+    case ADD_VEC:
+      for (int i = 0; i < lanes; i++) { ax[i] += x[i]; ay[i] += y[i]; }
+      top--;
+      return;
+    case SUB_VEC:
+      for (int i = 0; i < lanes; i++) { ax[i] -= x[i]; ay[i] -= y[i]; }
+      top--;
+      return;
+    case NEG_VEC: for (int i = 0; i < lanes; i++) { x[i] = -x[i]; y[i] = -y[i]; } return;
+    case SCALE: //scalar (left) times vector (top), the result takes the left entry
+      for (int i = 0; i < lanes; i++) { ay[i] = ax[i]*y[i]; ax[i] = ax[i]*x[i]; }
+      top--;
+      return;
+    case SCALE_RIGHT:
+      for (int i = 0; i < lanes; i++) { ax[i] *= x[i]; ay[i] *= x[i]; }
+      top--;
+      return;
+    case DIV_VEC:
+      for (int i = 0; i < lanes; i++) { ax[i] /= x[i]; ay[i] /= x[i]; }
+      top--;
+      return;
+    case SQRT: for (int i = 0; i < lanes; i++) x[i] = std::sqrt(x[i]); return;
+    case EXP: for (int i = 0; i < lanes; i++) x[i] = std::exp(x[i]); return;
+    case LOG: for (int i = 0; i < lanes; i++) x[i] = std::log(x[i]); return;
+    case ABS: for (int i = 0; i < lanes; i++) x[i] = std::abs(x[i]); return;
+    case SIN: for (int i = 0; i < lanes; i++) x[i] = std::sin(x[i]); return;
+    case COS: for (int i = 0; i < lanes; i++) x[i] = std::cos(x[i]); return;
+    case TANH: for (int i = 0; i < lanes; i++) x[i] = std::tanh(x[i]); return;
+    case STEP: for (int i = 0; i < lanes; i++) x[i] = x[i] > 0 ? 1.0f : 0.0f; return;
+    case DOT:
+      for (int i = 0; i < lanes; i++) ax[i] = ax[i]*x[i] + ay[i]*y[i];
+      top--;
+      return;
+    case MAG: for (int i = 0; i < lanes; i++) x[i] = std::sqrt(x[i]*x[i] + y[i]*y[i]); return;
+    case MAKE_VEC: std::copy(x, x + lanes, ay); top--; return; //the x component is already in place
+    case X_OF: return;
+    case Y_OF: std::copy(y, y + lanes, x); return;
+  }
+};
@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <any>
+
+/*
+A small arithmetic language for user-defined forces, e.g. "-k*(r - x0)*rhat", so custom physics
+doesn't have to run as a std::function (or through the Python interpreter) once per pair.
+
+The source is parsed and type checked once into stack bytecode. evaluate then runs each instruction across
+a tile of lanes (pairs or movers) held as arrays, so the dispatch cost is paid once per tile, not per value,
+and the per-instruction loops are simple enough for the compiler to vectorize.
+
+  operators:  + - * / ^ (power, right associative), unary -, parentheses
+  functions:  sqrt exp log abs sin cos tanh, min(a, b) max(a, b) pow(a, b), step(a) (1 if a > 0, else 0)
+              dot(u, v) mag(v) vec(x, y) x(v) y(v)
+Values are scalars or 2D vectors. Vectors add and subtract with vectors, and multiply or divide by scalars;
+any other mix is rejected when compiling. Sub-expressions without variables are folded into constants.
+*/
+
+struct ExpressionVariable {
+  // a name the expression can read. scalars read input slot, vectors read slot (x) and ySlot (y)
+  std::string name;
+  int slot;
+  int ySlot = -1;
+  bool isVector() const { return ySlot >= 0; };
+};
+
+class Expression {
+  public:
+    static constexpr int TILE = 64; //most lanes evaluated per call
+    static constexpr int MAX_DEPTH = 16; //deepest value stack a program may need
+
+    // names resolve to variables first, then constants. throws std::invalid_argument on syntax or type errors,
+    // unknown names, or programs needing more than MAX_DEPTH stack entries
+    Expression(const std::string& source, const std::vector<ExpressionVariable>& variables,
+      const std::unordered_map<std::string, float>& constants = {});
+
+    const std::string& source() const { return text; };
+    bool isVector() const { return vectorResult; };
+    bool uses(int slot) const; //whether the program reads input slot
+    int instructionCount() const { return program.size(); };
+
+    // inputs[slot] points at lanes values for every slot the program uses (others may be nullptr).
+    // writes lanes results to outX, and to outY for vector expressions. lanes <= TILE
+    void evaluate(const float* const* inputs, int lanes, float* outX, float* outY = nullptr) const;
+
+    static float toFloat(const std::any& value); //parameter values as floats, accepting float, double or int
+
+  private:
+    enum Op {
+      PUSH, LOAD, LOAD_VEC,
+      ADD, SUB, MUL, DIV, POW, NEG, //scalar, scalar
+      ADD_VEC, SUB_VEC, NEG_VEC, SCALE, SCALE_RIGHT, DIV_VEC, //SCALE: scalar*vector, SCALE_RIGHT: vector*scalar
+      SQRT, EXP, LOG, ABS, SIN, COS, TANH, STEP, MIN, MAX,
+      DOT, MAG, MAKE_VEC, X_OF, Y_OF
+    };
+    struct Instruction {
+      Op op;
+      int a = 0; //input slot(s) for loads
+      int b = 0;
+      float value = 0; //constant for PUSH
+    };
+    struct Node; //parse tree, only kept while compiling
+    class Parser;
+
+    std::string text;
+    std::vector<Instruction> program;
+    std::vector<int> usedSlots;
+    bool vectorResult = false;
+
+    void emit(const Node& node, int depth, int& maxDepth);
+    static void run(const Instruction& instruction, float (*stack)[2][TILE], int& top, const float* const* inputs, int lanes);
+};
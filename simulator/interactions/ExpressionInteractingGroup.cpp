@@ -0,0 +1,74 @@
+#include "ExpressionInteractingGroup.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ExpressionInteractingGroup::ExpressionInteractingGroup(Simulator& simulator, std::vector<int>& moverIds,
+  const std::string& force, const std::unordered_map<std::string, float>& constants,
+  const std::vector<std::pair<std::string, float>>& moverParams)
+  : TiledInteractingGroup(simulator, moverIds, typeid(ExpressionInteractingGroup), defaults(moverParams)),
+  force(force, variables(moverParams), constants) {
+    if (!this->force.isVector()) {
+      throw std::invalid_argument("ExpressionInteractingGroup: the force \"" + force + "\" must be a vector");
+    }
+    relativeVelocity = this->force.uses(DVX) || this->force.uses(DVY);
+};
+
+std::vector<ExpressionVariable> ExpressionInteractingGroup::variables(const std::vector<std::pair<std::string, float>>& moverParams) {
+  std::vector<ExpressionVariable> variables = {
+    {"r", R}, {"d", DX, DY}, {"rhat", UX, UY}, {"v", DVX, DVY},
+    {"mass1", MASS1}, {"mass2", MASS2}, {"radius1", RADIUS1}, {"radius2", RADIUS2},
+  };
+  if (moverParams.size() > MAX_PARAMS) {
+    throw std::invalid_argument("ExpressionInteractingGroup: at most " + std::to_string(MAX_PARAMS) + " parameters");
+  }
+  for (int k = 0; k < moverParams.size(); k++) {
+    for (int mover = 1; mover <= 2; mover++) {
+      std::string name = moverParams[k].first + std::to_string(mover);
+      for (auto& variable : variables) {
+        if (variable.name == name) throw std::invalid_argument("ExpressionInteractingGroup: parameter name " + name + " is taken");
+      }
+      variables.push_back({name, PARAMS + 2*k + mover - 1});
+    }
+  }
+  return variables;
+};
+
+std::vector<float> ExpressionInteractingGroup::defaults(const std::vector<std::pair<std::string, float>>& moverParams) {
+  std::vector<float> values;
+  for (auto& param : moverParams) values.push_back(param.second);
+  return values;
+};
+
+void ExpressionInteractingGroup::pairForces(const phys_tile& first, const phys_tile& second, float* fx, float* fy) {
+  constexpr int TILE = Expression::TILE;
+  int lanes = first.count;
+  float r[TILE], dx[TILE], dy[TILE], ux[TILE], uy[TILE], dvx[TILE], dvy[TILE];
+  const float* slots[PARAMS + 2*MAX_PARAMS];
+  slots[R] = r; slots[DX] = dx; slots[DY] = dy; slots[UX] = ux; slots[UY] = uy;
+  slots[DVX] = dvx; slots[DVY] = dvy;
+  slots[MASS1] = first.mass; slots[MASS2] = second.mass;
+  slots[RADIUS1] = first.radius; slots[RADIUS2] = second.radius;
+  for (int k = 0; k < first.paramCount; k++) {
+    slots[PARAMS + 2*k] = first.params[k];
+    slots[PARAMS + 2*k + 1] = second.params[k];
+  }
+  for (int l = 0; l < lanes; l++) {
+    dx[l] = first.x[l] - second.x[l];
+    dy[l] = first.y[l] - second.y[l];
+    r[l] = std::sqrt(dx[l]*dx[l] + dy[l]*dy[l]);
+    float inverse = r[l] > 0 ? 1/r[l] : 0;
+    ux[l] = dx[l]*inverse;
+    uy[l] = dy[l]*inverse;
+  }
+  if (relativeVelocity) {
+    for (int l = 0; l < lanes; l++) {
+      dvx[l] = first.vx[l] - second.vx[l];
+      dvy[l] = first.vy[l] - second.vy[l];
+    }
+  }
+  force.evaluate(slots, lanes, fx, fy);
+  for (int l = 0; l < lanes; l++) {
+    if (r[l] == 0) fx[l] = fy[l] = 0; //direction undefined
+  }
+};
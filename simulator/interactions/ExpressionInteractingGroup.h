@@ -0,0 +1,35 @@
+#pragma once
+#include "TiledInteractingGroup.h"
+#include "Expression.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+class ExpressionInteractingGroup : public TiledInteractingGroup {
+  // Interacting group whose pair force is an Expression, e.g. "-k*(r - x0)*rhat" for the spring group.
+  // The expression gives the force on the first mover of a pair; the second gets its opposite.
+  //   r           distance between the movers
+  //   d, rhat     p1 - p2 and its unit vector
+  //   v           relative velocity v1 - v2
+  //   mass1 mass2 radius1 radius2
+  //   name1 name2 for every per-mover parameter name, read from the mover's interactionParams under
+  //               typeid(ExpressionInteractingGroup) (floats in the order given), or the default when it has none
+  // plus the named constants. Pairs at the same position are skipped, since rhat is undefined there.
+  public:
+    ExpressionInteractingGroup(Simulator& simulator, std::vector<int>& moverIds, const std::string& force,
+      const std::unordered_map<std::string, float>& constants = {},
+      const std::vector<std::pair<std::string, float>>& moverParams = {}); //throws std::invalid_argument
+    const Expression& expression() const { return force; };
+
+  protected:
+    void pairForces(const phys_tile& first, const phys_tile& second, float* fx, float* fy) override;
+
+  private:
+    enum Slot { R, DX, DY, UX, UY, DVX, DVY, MASS1, MASS2, RADIUS1, RADIUS2, PARAMS }; //parameter k uses PARAMS + 2k (+1)
+    static constexpr int MAX_PARAMS = 32;
+    static std::vector<ExpressionVariable> variables(const std::vector<std::pair<std::string, float>>& moverParams);
+    static std::vector<float> defaults(const std::vector<std::pair<std::string, float>>& moverParams);
+    Expression force;
+    bool relativeVelocity;
+};
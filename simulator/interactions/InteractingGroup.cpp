@@ -12,18 +12,52 @@ InteractingGroup::InteractingGroup(Simulator& simulator,
   }
 };
 
-// might be worth multithreading this, depending on expected group sizes
-// but test this way first for simplicity
+InteractingGroup::InteractingGroup(Simulator& simulator, std::vector<int>& moverIds)
+  : InteractingGroup(simulator, moverIds, nullptr) {};
+
+// serial path. Simulator::update instead resolves every group and spreads applyPairs over the thread pool
 void InteractingGroup::applyInteractions() {
+  resolveMembers();
+  applyPairs(0, members.size());
+};
+
+void InteractingGroup::resolveMembers() {
+  // look every member up once per step, rather than once per pair
+  members.resize(moverIds.size());
   for (int i = 0; i < moverIds.size(); i++) {
-    Mover& mover1 = getMover(i);
-    for (int j = i+1; j < moverIds.size(); j++) {
-      Mover& mover2 = getMover(j);
-      interaction(mover1, mover2);
+    members[i] = &getMover(i);
+  }
+};
+
+void InteractingGroup::applyPairs(int rowStart, int rowEnd) {
+  int n = members.size();
+  for (int i = rowStart; i < rowEnd; i++) {
+    Mover& mover1 = *members[i];
+    for (int j = i+1; j < n; j++) {
+      interaction(mover1, *members[j]);
     }
   }
 };
 
+long long InteractingGroup::pairCount() const {
+  long long n = moverIds.size();
+  return n*(n-1)/2;
+};
+
+std::vector<int> InteractingGroup::rowSplits(int chunks) const {
+  // row i holds n-1-i pairs, so equal row counts would give the first chunk most of the work
+  int n = moverIds.size();
+  std::vector<int> splits = {0};
+  long long total = pairCount();
+  long long accumulated = 0;
+  for (int i = 0; i < n && splits.size() < chunks; i++) {
+    accumulated += n-1-i;
+    if (accumulated * chunks >= total * (long long)splits.size()) splits.push_back(i+1);
+  }
+  if (splits.back() != n) splits.push_back(n);
+  return splits;
+};
+
 bool InteractingGroup::addMover(int moverId) {
   moverIds.push_back(moverId);
   simMoversIdx.push_back(-1); //placeholder value since updateMoverIdx will write to this position
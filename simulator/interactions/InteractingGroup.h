@@ -2,17 +2,29 @@
 #include "Simulator.h"
 
 class Simulator; //forward declare
+class ThreadPool;
 
 //template to accept additional args?
 class InteractingGroup {
   public:
     InteractingGroup(Simulator& simulator, std::vector<int>& moverIds, std::function<void(Mover&, Mover&)> interaction);
-    void applyInteractions();
+    virtual ~InteractingGroup() = default;
+    void applyInteractions(); //resolves members and applies all pairs on this thread
     bool addMover(int moverId);
     bool removeMover(int moverId);
     int updateMoverIdx(int groupIdx); //search for moverId in simulator.movers and update simMoversIdx
 
+    // split evaluation, used by Simulator to run groups on the thread pool:
+    // resolveMembers once per step (not thread safe), then applyPairs on disjoint row ranges from any thread
+    void virtual resolveMembers();
+    void virtual applyPairs(int rowStart, int rowEnd); //all pairs (i, j>i) with i in [rowStart, rowEnd)
+    long long pairCount() const;
+    std::vector<int> rowSplits(int chunks) const; //row boundaries giving each chunk about the same number of pairs
+
     std::vector<int> moverIds;
+  protected:
+    InteractingGroup(Simulator& simulator, std::vector<int>& moverIds); //for typed groups, which bring their own kernel
+    std::vector<Mover*> members; //resolved by resolveMembers, aligned with moverIds
   private:
     Simulator& simulator;
     std::vector<int> simMoversIdx; //indices of movers in simulator.movers. check first before searching
@@ -20,3 +32,36 @@ class InteractingGroup {
     Mover& getMover(int groupIdx); //get mover from simulator.movers by index of moverIds/simMoversIdx
 };
 
+template <class Kernel>
+class TypedInteractingGroup : public InteractingGroup {
+  // InteractingGroup with the pair interaction known at compile time.
+  // Kernel is any callable void(Mover&, Mover&), called directly (and inlinable) instead of through std::function
+  public:
+    Kernel kernel;
+    TypedInteractingGroup(Simulator& simulator, std::vector<int>& moverIds, Kernel kernel)
+      : InteractingGroup(simulator, moverIds), kernel(kernel) {};
+    void applyPairs(int rowStart, int rowEnd) override {
+      int n = members.size();
+      for (int i = rowStart; i < rowEnd; i++) {
+        Mover& mover1 = *members[i];
+        for (int j = i+1; j < n; j++) {
+          kernel(mover1, *members[j]);
+        }
+      }
+    }
+};
+
+struct SpringPairKernel {
+  // spring between every pair of a group, as used for spring groups
+  float k;
+  float x0;
+  void operator()(Mover& mover1, Mover& mover2) const {
+    Vect2 r = mover1.position - mover2.position;
+    float magnitude = r.mag();
+    if (magnitude == 0) return; //direction undefined
+    float springForceMag = -k*(magnitude - x0);
+    Vect2 springForce = springForceMag * r/magnitude;
+    mover1.apply_force(springForce);
+    mover2.apply_force(-1*springForce);
+  }
+};
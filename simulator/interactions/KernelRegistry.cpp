@@ -0,0 +1,118 @@
+#include "KernelRegistry.h"
+#include <stdexcept>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace {
+
+void* openLibrary(const std::string& path) {
+#ifdef _WIN32
+  return (void*)LoadLibraryA(path.c_str());
+#else
+  return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+};
+
+void* findSymbol(void* library, const char* name) {
+#ifdef _WIN32
+  return (void*)GetProcAddress((HMODULE)library, name);
+#else
+  return dlsym(library, name);
+#endif
+};
+
+void closeLibrary(void* library) {
+#ifdef _WIN32
+  FreeLibrary((HMODULE)library);
+#else
+  dlclose(library);
+#endif
+};
+
+std::string lastError() {
+#ifdef _WIN32
+  return "error " + std::to_string(GetLastError());
+#else
+  const char* error = dlerror();
+  return error ? error : "unknown error";
+#endif
+};
+
+}
+
+KernelRegistry::~KernelRegistry() {
+  kernels.clear();
+  for (void* library : libraries) closeLibrary(library);
+};
+
+void KernelRegistry::validate(const phys_kernel& kernel) {
+  if (kernel.name == nullptr || kernel.name[0] == '\0') throw std::invalid_argument("KernelRegistry: kernel without a name");
+  std::string name = kernel.name;
+  if (kernel.paramCount < 0 || kernel.constantCount < 0) {
+    throw std::invalid_argument("KernelRegistry: kernel " + name + " has a negative parameter count");
+  }
+  bool pair = kernel.kind == PHYS_PAIR_KERNEL && kernel.pair != nullptr;
+  bool effect = kernel.kind == PHYS_EFFECT_KERNEL && kernel.effect != nullptr;
+  if (!pair && !effect) throw std::invalid_argument("KernelRegistry: kernel " + name + " has no function for its kind");
+};
+
+std::vector<std::string> KernelRegistry::load(const std::string& path) {
+  void* library = openLibrary(path);
+  if (library == nullptr) throw std::runtime_error("KernelRegistry: can't load " + path + ": " + lastError());
+  auto listKernels = (phys_kernels_function)findSymbol(library, PHYS_KERNELS_SYMBOL);
+  if (listKernels == nullptr) {
+    closeLibrary(library);
+    throw std::runtime_error("KernelRegistry: " + path + " doesn't export " PHYS_KERNELS_SYMBOL);
+  }
+  int count = 0;
+  const phys_kernel* loaded = listKernels(PHYS_KERNEL_ABI_VERSION, &count);
+  std::vector<std::string> loadedNames;
+  try {
+    if (loaded == nullptr) {
+      throw std::invalid_argument("KernelRegistry: " + path + " doesn't support kernel ABI version "
+        + std::to_string(PHYS_KERNEL_ABI_VERSION));
+    }
+    // check all before registering any
+    for (int i = 0; i < count; i++) {
+      validate(loaded[i]);
+      std::string name = loaded[i].name;
+      if (contains(name) || std::find(loadedNames.begin(), loadedNames.end(), name) != loadedNames.end()) {
+        throw std::invalid_argument("KernelRegistry: a kernel named " + name + " is already registered");
+      }
+      loadedNames.push_back(name);
+    }
+  } catch (...) {
+    closeLibrary(library);
+    throw;
+  }
+  libraries.push_back(library);
+  for (int i = 0; i < count; i++) add(loaded[i]);
+  return loadedNames;
+};
+
+void KernelRegistry::add(const phys_kernel& kernel) {
+  validate(kernel);
+  if (contains(kernel.name)) throw std::invalid_argument("KernelRegistry: a kernel named " + std::string(kernel.name) + " is already registered");
+  auto entry = std::make_unique<Entry>();
+  entry->name = kernel.name;
+  entry->kernel = kernel;
+  entry->kernel.name = entry->name.c_str();
+  kernels[entry->name] = std::move(entry);
+};
+
+const phys_kernel& KernelRegistry::find(const std::string& name) const {
+  auto it = kernels.find(name);
+  if (it == kernels.end()) throw std::invalid_argument("KernelRegistry: no kernel named " + name);
+  return it->second->kernel;
+};
+
+std::vector<std::string> KernelRegistry::names() const {
+  std::vector<std::string> result;
+  for (auto& [name, entry] : kernels) result.push_back(name);
+  std::sort(result.begin(), result.end());
+  return result;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include "PhysKernelABI.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+class KernelRegistry {
+  // Named force kernels for PluginInteractingGroup and PluginEffect, from shared libraries implementing
+  // PhysKernelABI.h or registered directly from C++. Libraries stay loaded as long as the registry, which
+  // Simulator keeps for as long as the groups and effects using its kernels.
+  public:
+    KernelRegistry() = default;
+    ~KernelRegistry(); //unloads the libraries
+    KernelRegistry(const KernelRegistry&) = delete;
+    KernelRegistry& operator=(const KernelRegistry&) = delete;
+
+    // loads a library and registers all its kernels, returning their names. throws std::runtime_error if it can't
+    // be loaded or doesn't export phys_kernels, std::invalid_argument (registering none) if a kernel is malformed,
+    // its name is taken, or the library doesn't support PHYS_KERNEL_ABI_VERSION
+    std::vector<std::string> load(const std::string& path);
+    // registers a kernel whose functions live in this program. the name is copied, the functions must stay valid
+    void add(const phys_kernel& kernel);
+    const phys_kernel& find(const std::string& name) const; //throws std::invalid_argument if unknown
+    bool contains(const std::string& name) const { return kernels.count(name) > 0; };
+    std::vector<std::string> names() const;
+
+  private:
+    struct Entry {
+      std::string name; //owned copy, kernel.name points here
+      phys_kernel kernel;
+    };
+    std::unordered_map<std::string, std::unique_ptr<Entry>> kernels;
+    std::vector<void*> libraries;
+    static void validate(const phys_kernel& kernel);
+};
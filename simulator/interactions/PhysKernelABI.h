@@ -0,0 +1,56 @@
+#pragma once
+/*
+Stable C interface for force kernels, so interaction and effect kernels can be built separately from the
+engine (in C, C++ or anything producing a C shared library) and loaded at runtime by KernelRegistry.
+
+Kernels work on tiles: struct-of-arrays views of up to 64 movers. They are called from the thread pool,
+concurrently, so they must be thread safe and should not keep state between calls.
+
+A plugin library exports
+    const phys_kernel* phys_kernels(int abiVersion, int* count);
+returning an array of *count kernels that lives as long as the library, or a null pointer if it doesn't
+support abiVersion. Only add fields at the end of these structs, and bump PHYS_KERNEL_ABI_VERSION when doing so.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHYS_KERNEL_ABI_VERSION 1
+#define PHYS_KERNELS_SYMBOL "phys_kernels"
+
+typedef struct phys_tile {
+  int count; //lanes, at most 64
+  const int* id;
+  const float* x;
+  const float* y;
+  const float* vx;
+  const float* vy;
+  const float* mass;
+  const float* radius;
+  int paramCount;
+  const float* const* params; //params[k][lane], the movers' per-mover parameters
+} phys_tile;
+
+enum phys_kernel_kind {
+  PHYS_PAIR_KERNEL = 1,
+  PHYS_EFFECT_KERNEL = 2
+};
+
+typedef struct phys_kernel {
+  const char* name;
+  int kind; //a phys_kernel_kind
+  int paramCount; //per-mover parameters the kernel reads
+  int constantCount; //length of the constants passed on every call
+  // pair kernels: writes the force on first's lane l from second's lane l; the second mover gets the opposite.
+  // every lane of first holds the same mover
+  void (*pair)(const phys_tile* first, const phys_tile* second, const float* constants, float* fx, float* fy);
+  // effect kernels: writes the force on every lane's mover
+  void (*effect)(const phys_tile* movers, float time, const float* constants, float* fx, float* fy);
+} phys_kernel;
+
+typedef const phys_kernel* (*phys_kernels_function)(int abiVersion, int* count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+#include "PluginInteractingGroup.h"
+#include <stdexcept>
+#include <string>
+
+PluginInteractingGroup::PluginInteractingGroup(Simulator& simulator, std::vector<int>& moverIds,
+  const phys_kernel& kernel, std::vector<float> constants, std::vector<float> paramDefaults)
+  : TiledInteractingGroup(simulator, moverIds, typeid(PluginInteractingGroup), checked(kernel, constants, paramDefaults)),
+  kernel(kernel), constants(constants) {};
+
+std::vector<float> PluginInteractingGroup::checked(const phys_kernel& kernel, const std::vector<float>& constants,
+  const std::vector<float>& paramDefaults) {
+  std::string name = kernel.name;
+  if (kernel.kind != PHYS_PAIR_KERNEL) throw std::invalid_argument("PluginInteractingGroup: " + name + " is not a pair kernel");
+  if (constants.size() != kernel.constantCount) {
+    throw std::invalid_argument("PluginInteractingGroup: " + name + " takes " + std::to_string(kernel.constantCount) + " constant(s)");
+  }
+  if (paramDefaults.size() != kernel.paramCount) {
+    throw std::invalid_argument("PluginInteractingGroup: " + name + " takes " + std::to_string(kernel.paramCount) + " parameter(s)");
+  }
+  return paramDefaults;
+};
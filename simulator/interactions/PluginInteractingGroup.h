@@ -0,0 +1,25 @@
+#pragma once
+#include "TiledInteractingGroup.h"
+#include "PhysKernelABI.h"
+#include <vector>
+
+class PluginInteractingGroup : public TiledInteractingGroup {
+  // Interacting group running a pair kernel from a KernelRegistry (e.g. simulator.kernels.find(name)).
+  // Per-mover parameters are read from the movers' interactionParams under typeid(PluginInteractingGroup),
+  // or taken from paramDefaults, which holds kernel.paramCount values.
+  public:
+    // throws std::invalid_argument if kernel isn't a pair kernel or the counts don't match
+    PluginInteractingGroup(Simulator& simulator, std::vector<int>& moverIds, const phys_kernel& kernel,
+      std::vector<float> constants = {}, std::vector<float> paramDefaults = {});
+    const phys_kernel& kernel;
+    std::vector<float> constants;
+
+  protected:
+    void pairForces(const phys_tile& first, const phys_tile& second, float* fx, float* fy) override {
+      kernel.pair(&first, &second, constants.data(), fx, fy);
+    }
+
+  private:
+    static std::vector<float> checked(const phys_kernel& kernel, const std::vector<float>& constants,
+      const std::vector<float>& paramDefaults);
+};
@@ -0,0 +1,86 @@
+#include "TiledInteractingGroup.h"
+#include "Expression.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TiledInteractingGroup::TiledInteractingGroup(Simulator& simulator, std::vector<int>& moverIds,
+  std::type_index paramKey, std::vector<float> paramDefaults)
+  : InteractingGroup(simulator, moverIds), paramKey(paramKey), paramDefaults(paramDefaults),
+  params(paramDefaults.size()) {};
+
+void TiledInteractingGroup::resolveMembers() {
+  InteractingGroup::resolveMembers();
+  int n = members.size();
+  ids.resize(n);
+  px.resize(n); py.resize(n); vx.resize(n); vy.resize(n); mass.resize(n); radius.resize(n);
+  for (auto& column : params) column.resize(n);
+  for (int i = 0; i < n; i++) {
+    Mover& mover = *members[i];
+    ids[i] = mover.id;
+    px[i] = mover.position.x;
+    py[i] = mover.position.y;
+    vx[i] = mover.velocity.x;
+    vy[i] = mover.velocity.y;
+    mass[i] = mover.mass;
+    radius[i] = mover.radius;
+    if (params.empty()) continue;
+    // a mover without an entry takes the defaults, a wrongly sized entry is an error (as for tiled effects)
+    auto found = mover.interactionParams.find(paramKey);
+    bool own = found != mover.interactionParams.end();
+    if (own && found->second.size() != params.size()) {
+      throw std::invalid_argument("TiledInteractingGroup: mover " + std::to_string(mover.id) + " has "
+        + std::to_string(found->second.size()) + " parameter(s). Expected " + std::to_string(params.size()) + ".");
+    }
+    for (int k = 0; k < params.size(); k++) {
+      params[k][i] = own ? Expression::toFloat(found->second[k]) : paramDefaults[k];
+    }
+  }
+};
+
+void TiledInteractingGroup::applyPairs(int rowStart, int rowEnd) {
+  int n = members.size();
+  int paramCount = params.size();
+  // the row's mover is repeated across the first tile's lanes, the partners are read in place from the member arrays
+  int rowIds[TILE];
+  std::vector<float> rowValues((6 + paramCount)*TILE);
+  std::vector<const float*> firstParams(paramCount), secondParams(paramCount);
+  for (int k = 0; k < paramCount; k++) firstParams[k] = &rowValues[(6 + k)*TILE];
+  phys_tile first = {0, rowIds, &rowValues[0], &rowValues[TILE], &rowValues[2*TILE], &rowValues[3*TILE],
+    &rowValues[4*TILE], &rowValues[5*TILE], paramCount, firstParams.data()};
+  phys_tile second = first;
+  second.params = secondParams.data();
+  float fx[TILE], fy[TILE];
+
+  for (int i = rowStart; i < rowEnd; i++) {
+    int partners = std::min(TILE, n - i - 1);
+    if (partners <= 0) continue;
+    std::fill_n(rowIds, partners, ids[i]);
+    float rowState[6] = {px[i], py[i], vx[i], vy[i], mass[i], radius[i]};
+    for (int f = 0; f < 6; f++) std::fill_n(&rowValues[f*TILE], partners, rowState[f]);
+    for (int k = 0; k < paramCount; k++) std::fill_n(&rowValues[(6 + k)*TILE], partners, params[k][i]);
+    Vect2 total;
+    for (int start = i + 1; start < n; start += TILE) {
+      int lanes = std::min(TILE, n - start);
+      first.count = second.count = lanes;
+      second.id = &ids[start];
+      second.x = &px[start];
+      second.y = &py[start];
+      second.vx = &vx[start];
+      second.vy = &vy[start];
+      second.mass = &mass[start];
+      second.radius = &radius[start];
+      for (int k = 0; k < paramCount; k++) secondParams[k] = &params[k][start];
+      std::fill_n(fx, lanes, 0.0f);
+      std::fill_n(fy, lanes, 0.0f);
+      pairForces(first, second, fx, fy);
+      for (int l = 0; l < lanes; l++) {
+        if (fx[l] == 0 && fy[l] == 0) continue;
+        Vect2 pairForce(fx[l], fy[l]);
+        total += pairForce;
+        members[start + l]->apply_force(-1*pairForce);
+      }
+    }
+    if (total.x != 0 || total.y != 0) members[i]->apply_force(total);
+  }
+};
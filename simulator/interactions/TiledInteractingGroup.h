@@ -0,0 +1,31 @@
+#pragma once
+#include "InteractingGroup.h"
+#include "PhysKernelABI.h"
+#include <typeindex>
+#include <vector>
+
+class TiledInteractingGroup : public InteractingGroup {
+  // Interacting group whose pair forces are computed a tile at a time, for expression and plugin kernels.
+  // resolveMembers copies the members' state, and their per-mover parameters from interactionParams[paramKey]
+  // (or the defaults when a mover has none), into arrays once per step. An entry of the wrong size throws
+  // std::invalid_argument from the step. applyPairs then hands pairForces
+  // each row's mover against tiles of up to TILE partners, and applies the forces it writes.
+  public:
+    static constexpr int TILE = 64;
+    void resolveMembers() override;
+    void applyPairs(int rowStart, int rowEnd) override;
+
+  protected:
+    TiledInteractingGroup(Simulator& simulator, std::vector<int>& moverIds, std::type_index paramKey,
+      std::vector<float> paramDefaults);
+    // force on first's lane l from second's lane l into fx, fy. lanes left at zero apply nothing
+    void virtual pairForces(const phys_tile& first, const phys_tile& second, float* fx, float* fy) = 0;
+
+  private:
+    std::type_index paramKey;
+    std::vector<float> paramDefaults;
+    // member state as of resolveMembers, aligned with members
+    std::vector<int> ids;
+    std::vector<float> px, py, vx, vy, mass, radius;
+    std::vector<std::vector<float>> params; //[parameter][member]
+};
@@ -100,13 +100,9 @@ std::array<Vect2, 3> NewtMover::next_vecs(float dt) {
 };
 
 void NewtMover::apply_force(Vect2 force) {
-    // atomic addition of Vect2 forces
+    // atomic addition of Vect2 forces. a failed exchange reloads currentForce, so the sum is recomputed from it
     Vect2 currentForce = force_sum.load();
-    Vect2 new_force = currentForce + force;
-    while (!force_sum.compare_exchange_weak(currentForce, new_force)){
-        // if the current force is not equal to the new force, try again after loading the new current force
-        force_sum.store(currentForce);
-    }
+    while (!force_sum.compare_exchange_weak(currentForce, currentForce + force)) {}
 };
 
 void NewtMover::update(float dt) {
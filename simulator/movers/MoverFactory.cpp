@@ -1,4 +1,5 @@
 #include "MoverFactory.h"
+#include <algorithm>
 
 
 MoverFactory::MoverFactory()
@@ -120,4 +121,66 @@ std::unique_ptr<Mover> MoverFactory::createMover(std::type_index type, MoverArgs
   mover->id = current_mover_id;
   current_mover_id++;
   return mover;
+};
+
+std::vector<std::unique_ptr<Mover>> MoverFactory::createMovers(std::type_index type, const MoverArrays& arrays,
+    std::unordered_map<std::type_index, std::vector<std::any>> interactionParams, ThreadPool* pool) {
+  // defaults and shared parameters are resolved once, through the same constructor as createMover,
+  // so each mover only copies the finished template and overwrites its own columns
+  if (moverConstructors.find(type) == moverConstructors.end())
+    throw std::invalid_argument("MoverFactory::createMovers: type not found");
+  size_t count = arrays.count;
+  // a plain Mover carrying the type's defaults, so a NewtMover default mass of 0 overridden by masses doesn't throw here
+  auto prototype = moverConstructors[typeid(Mover)](moverDefaults[type], interactionParams);
+  if (type != typeid(Mover)) {
+    bool zeroMass = arrays.masses ? std::find(arrays.masses, arrays.masses + count, 0.0f) != arrays.masses + count : prototype->mass == 0;
+    if (zeroMass) throw std::invalid_argument("MoverFactory::createMovers: NewtMover mass must be non-zero");
+  }
+  for (auto& [paramType, columns] : arrays.paramColumns) {
+    auto it = prototype->interactionParams.find(paramType);
+    size_t known = it == prototype->interactionParams.end() ? 0 : it->second.size();
+    for (size_t c = 0; c < columns.size(); c++) {
+      if (columns[c] == nullptr) continue;
+      if (c > known) throw std::invalid_argument("MoverFactory::createMovers: parameter " + std::to_string(c)
+        + " has a column but parameter " + std::to_string(known) + " has no value");
+      if (c == known) {
+        prototype->interactionParams[paramType].push_back(0.0f); //filled per mover
+        known++;
+      }
+    }
+  }
+  const Mover& base = *prototype;
+  std::vector<std::unique_ptr<Mover>> movers(count);
+  int firstId = current_mover_id;
+  auto build = [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      MoverArgs moverArgs(arrays.positions ? arrays.positions[i] : base.position,
+        arrays.velocities ? arrays.velocities[i] : base.velocity,
+        arrays.accelerations ? arrays.accelerations[i] : base.accel,
+        arrays.radii ? arrays.radii[i] : base.radius,
+        arrays.masses ? arrays.masses[i] : base.mass);
+      std::unique_ptr<Mover> mover;
+      if (type == typeid(Mover)) mover = std::make_unique<Mover>(moverArgs);
+      else if (type == typeid(NewtMover)) mover = std::make_unique<NewtMover>(moverArgs);
+      else mover = std::make_unique<RigidConnectedMover>(moverArgs, nullptr);
+      mover->id = firstId + i;
+      mover->interactionParams = base.interactionParams;
+      for (auto& [paramType, columns] : arrays.paramColumns) {
+        auto& values = mover->interactionParams[paramType];
+        for (size_t c = 0; c < columns.size(); c++) {
+          if (columns[c] != nullptr) values[c] = columns[c][i];
+        }
+      }
+      movers[i] = std::move(mover);
+    }
+  };
+  size_t tasks = pool ? std::min<size_t>(4*std::max(1u, std::thread::hardware_concurrency()), count/4096) : 0;
+  if (tasks < 2) build(0, count);
+  else {
+    std::vector<std::future<void>> futures;
+    for (size_t t = 0; t < tasks; t++) futures.push_back(pool->enqueue(build, count*t/tasks, count*(t + 1)/tasks));
+    for (auto& future : futures) future.get();
+  }
+  current_mover_id += count;
+  return movers;
 };
\ No newline at end of file
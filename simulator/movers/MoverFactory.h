@@ -8,6 +8,20 @@
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include "ThreadPool.h"
+
+// arrays for creating many movers of one type at once. each points at count entries, or is nullptr to use the
+// type's default for every mover. paramColumns[type][c] overrides interaction parameter c of that type per mover
+// (nullptr keeps the shared or default value); parameters before c need a shared or default value.
+struct MoverArrays {
+  size_t count = 0;
+  const Vect2* positions = nullptr;
+  const Vect2* velocities = nullptr;
+  const Vect2* accelerations = nullptr;
+  const float* radii = nullptr;
+  const float* masses = nullptr;
+  std::unordered_map<std::type_index, std::vector<const float*>> paramColumns;
+};
 
 class MoverFactory
 {
@@ -35,6 +49,12 @@ public:
   void registerMoverConstructor(std::type_index type);
   std::unique_ptr<Mover> createMover(std::type_index type, MoverArgs args = MoverArgs(),
     std::unordered_map<std::type_index, std::vector<std::any>> interactionParams={});
+  // arrays.count movers with consecutive ids, in id order. interactionParams are shared by all of them.
+  // everything is checked before any mover is built or id used. construction is spread over pool when given
+  std::vector<std::unique_ptr<Mover>> createMovers(std::type_index type, const MoverArrays& arrays,
+    std::unordered_map<std::type_index, std::vector<std::any>> interactionParams = {}, ThreadPool* pool = nullptr);
+  int nextMoverId() const { return current_mover_id; }; //id the next created mover gets
+  void setNextMoverId(int id) { current_mover_id = id; }; //when restoring movers with their original ids
 
   private:
 
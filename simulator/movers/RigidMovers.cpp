@@ -1,29 +1,16 @@
 #include "RigidMovers.h"
 
 RigidConnectedMover::RigidConnectedMover(MoverArgs args, RigidConnectedGroup* group) : NewtMover(args), group(group) {
-  if (group != nullptr) {
-    group->movers.push_back(this);
-    group->computeProperties();
-  }
+  if (group != nullptr) group->moverJoined(this);
 }
 
 
 RigidConnectedMover::RigidConnectedMover(Mover& mover, RigidConnectedGroup* group) : NewtMover(mover), group(group) {
-  if (group != nullptr) {
-    group->movers.push_back(this);
-    group->computeProperties();
-  }
+  if (group != nullptr) group->moverJoined(this);
 }
 
 RigidConnectedMover::~RigidConnectedMover() {
-  if (group != nullptr) {
-    //erase_if equals to this
-    group->movers.erase(std::remove_if(group->movers.begin(), group->movers.end(), 
-    [this](RigidConnectedMover* mover) { return mover == this; }), 
-    group->movers.end());
-    // group->movers.erase(group->movers.begin() + group_idx);
-    group->computeProperties();
-  }
+  if (group != nullptr) group->moverLeft(this);
 };
 
 std::array<Vect2, 3> RigidConnectedMover::next_vecs(float dt) {
@@ -65,12 +52,85 @@ RigidConnectedGroup::RigidConnectedGroup(std::vector<RigidConnectedMover*> mover
 
 RigidConnectedGroup::~RigidConnectedGroup() {
   for (auto mover : movers) {
+    if (mover != nullptr) mover->group = nullptr; //slots may be nulled mid-edit
+  }
+}
+
+void RigidConnectedGroup::addMovers(const std::vector<RigidConnectedMover*>& newMovers) {
+  beginEdit();
+  movers.reserve(movers.size() + newMovers.size());
+  for (auto mover : newMovers) {
+    if (mover == nullptr || mover->group == this) continue;
+    // a mover can only belong to one group. if moving many movers out of another group,
+    // wrap that group in beginEdit/endEdit too so it is only rebuilt once
+    if (mover->group != nullptr) mover->group->moverLeft(mover);
+    mover->group = this;
+    moverJoined(mover);
+  }
+  endEdit();
+}
+
+void RigidConnectedGroup::removeMovers(const std::vector<RigidConnectedMover*>& oldMovers) {
+  beginEdit();
+  for (auto mover : oldMovers) {
+    if (mover == nullptr || mover->group != this) continue;
+    moverLeft(mover);
     mover->group = nullptr;
   }
+  endEdit();
+}
+
+void RigidConnectedGroup::beginEdit() {
+  editDepth++;
+}
+
+void RigidConnectedGroup::endEdit() {
+  if (editDepth == 0) return;
+  editDepth--;
+  if (editDepth > 0) return; //outermost edit does the rebuild
+  compactMovers();
+  computeProperties();
+}
+
+void RigidConnectedGroup::moverJoined(RigidConnectedMover* mover) {
+  movers.push_back(mover);
+  mover->group_idx = movers.size() - 1;
+  if (!isEditing()) computeProperties();
+}
+
+void RigidConnectedGroup::moverLeft(RigidConnectedMover* mover) {
+  // null the slot instead of erasing, so removing k movers costs one compaction rather than k
+  int idx = mover->group_idx;
+  bool idxValid = idx >= 0 && idx < movers.size() && movers[idx] == mover;
+  if (!idxValid) { //group_idx not assigned yet (joined during this edit) or stale, fall back to a search
+    auto it = std::find(movers.begin(), movers.end(), mover);
+    if (it == movers.end()) return;
+    idx = it - movers.begin();
+  }
+  movers[idx] = nullptr;
+  pendingRemovals++;
+  if (!isEditing()) {
+    compactMovers();
+    computeProperties();
+  }
+}
+
+void RigidConnectedGroup::compactMovers() {
+  if (pendingRemovals == 0) return;
+  movers.erase(std::remove(movers.begin(), movers.end(), nullptr), movers.end());
+  pendingRemovals = 0;
 }
 
 void RigidConnectedGroup::computeProperties() {
   //calculates center of mass, moverMoments, moment of inertia, and total mass
+  if (movers.empty()) { //nothing left to describe, avoid dividing by zero mass
+    totalMass = 0;
+    momentOfInertia = 0;
+    moverMoments.clear();
+    currentGroupIdx = 0;
+    NumMoversLeftToUpdate = 0;
+    return;
+  }
   totalMass = 0;
   momentOfInertia = 0;
   centerOfMass = Vect2();
@@ -84,6 +144,7 @@ void RigidConnectedGroup::computeProperties() {
   centerOfMass = centerOfMass / totalMass;
   // now that we have COM, calculate moments and moment of inertia
   moverMoments.clear();
+  moverMoments.reserve(movers.size());
   for (auto& mover : movers) {
     Vect2 r = mover->position - centerOfMass;
     moverMoments.push_back(r);
@@ -17,7 +17,7 @@ class RigidConnectedMover : public NewtMover {
   friend RigidConnectedGroup;
   public:
     RigidConnectedGroup* group;
-    int group_idx;
+    int group_idx = -1;
     RigidConnectedMover(MoverArgs args, RigidConnectedGroup* group = nullptr);
     // RigidConnectedMover(NewtMover& mover, RigidConnectedGroup* group = nullptr);
     RigidConnectedMover(Mover& mover, RigidConnectedGroup* group = nullptr);
@@ -48,14 +48,27 @@ class RigidConnectedGroup {
     ~RigidConnectedGroup();
     void update(float dt);
     std::array<Vect2, 3> next_vecs(RigidConnectedMover*, float dt);
+    // bulk membership changes. properties are recomputed once per call instead of once per mover
+    void addMovers(const std::vector<RigidConnectedMover*>& newMovers);
+    void removeMovers(const std::vector<RigidConnectedMover*>& oldMovers);
+    // while editing, movers joining (constructed with this group) or leaving (destroyed) are
+    // only tallied, and the group is rebuilt in a single pass when the last endEdit is called
+    void beginEdit();
+    void endEdit();
+    bool isEditing() const { return editDepth > 0; };
   private:
     void computeProperties();
+    void compactMovers(); //drops slots nulled by moverLeft. computeProperties reassigns group_idx
+    void moverJoined(RigidConnectedMover* mover);
+    void moverLeft(RigidConnectedMover* mover);
     void reset();
     void moverUpdated();
     bool isUpdated = false; //when to reset this? after the last mover calls update?
     std::atomic<int> NumMoversLeftToUpdate;
     std::mutex update_mutex;
     int currentGroupIdx = 0;
+    int editDepth = 0;
+    int pendingRemovals = 0; //number of nulled slots in movers waiting for compactMovers
 };
 
 
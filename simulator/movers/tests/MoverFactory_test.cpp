@@ -58,3 +58,45 @@ TEST_F(MoverFactoryFixture, MoverIdsAssignedInOrder) {
   EXPECT_EQ(mover3->id, 2);
 };
 
+
+TEST_F(MoverFactoryFixture, CreateMoversFromArrays) {
+  factory.registerInteraction(typeid(Interaction), std::vector<std::any>({1.0f, 2.0f}));
+  factory.createMover(typeid(Mover));
+  std::vector<Vect2> positions = {Vect2(1, 1), Vect2(2, 2), Vect2(3, 3)};
+  std::vector<float> masses = {4, 5, 6};
+  std::vector<float> charges = {-1, 0, 1};
+  MoverArrays arrays;
+  arrays.count = 3;
+  arrays.positions = positions.data();
+  arrays.masses = masses.data();
+  arrays.paramColumns[typeid(Interaction)] = {nullptr, charges.data()};
+  auto movers = factory.createMovers(typeid(NewtMover), arrays, {{typeid(Interaction), {7.0f}}});
+  ASSERT_EQ(movers.size(), 3);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(movers[i]->id, i + 1);
+    EXPECT_NE(dynamic_cast<NewtMover*>(movers[i].get()), nullptr);
+    EXPECT_EQ(movers[i]->position, positions[i]);
+    EXPECT_EQ(movers[i]->velocity, Vect2()); //default
+    EXPECT_EQ(movers[i]->mass, masses[i]);
+    auto& params = movers[i]->interactionParams[typeid(Interaction)];
+    EXPECT_EQ(std::any_cast<float>(params[0]), 7.0f); //shared
+    EXPECT_EQ(std::any_cast<float>(params[1]), charges[i]);
+  }
+  EXPECT_EQ(factory.createMover(typeid(Mover))->id, 4);
+};
+
+TEST_F(MoverFactoryFixture, CreateMoversChecksBeforeBuilding) {
+  std::vector<float> masses = {1, 0};
+  MoverArrays arrays;
+  arrays.count = 2;
+  arrays.masses = masses.data();
+  EXPECT_THROW(factory.createMovers(typeid(NewtMover), arrays), std::invalid_argument);
+  EXPECT_EQ(factory.createMovers(typeid(Mover), arrays).size(), 2); //plain movers may be massless
+  std::vector<float> column = {1, 2};
+  MoverArrays gap;
+  gap.count = 2;
+  gap.paramColumns[typeid(Interaction)] = {nullptr, column.data()}; //parameter 0 has no value
+  EXPECT_THROW(factory.createMovers(typeid(Mover), gap), std::invalid_argument);
+  EXPECT_THROW(factory.createMovers(typeid(int), arrays), std::invalid_argument);
+  EXPECT_EQ(factory.nextMoverId(), 2);
+};
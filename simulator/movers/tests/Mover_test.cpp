@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "Mover.h"
+#include <thread>
+#include <vector>
 
 class MoverArgsFixture : public ::testing::Test {
   protected:
@@ -199,6 +201,18 @@ TEST_F(NewtMoverFixture, ApplyForce) {
   EXPECT_NEAR(mover.force_sum.load().y, Vect2(11,6).y, 1e-6);
 };
 
+TEST_F(NewtMoverFixture, ApplyForceFromManyThreads) {
+  // interacting group tasks add to the same movers concurrently, none of their forces may be lost
+  const int threads = 4, perThread = 200000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([this] { for (int i = 0; i < perThread; i++) mover.apply_force(Vect2(1, 0.5)); });
+  }
+  for (auto& worker : workers) worker.join();
+  EXPECT_EQ(mover.force_sum.load().x, threads*perThread);
+  EXPECT_EQ(mover.force_sum.load().y, threads*perThread*0.5f);
+};
+
 TEST_F(NewtMoverFixture, NextVecs) { 
   Vect2 force(100, 120);
   mover.apply_force(force);
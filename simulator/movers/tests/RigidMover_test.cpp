@@ -138,3 +138,49 @@ TEST_F(RigidMoverFixture, CloneToNewtMoverAndUpdate) {
   EXPECT_NEAR(mover2->position.y, expectedPosition.y, 1e-6);
 };
 
+
+TEST_F(RigidMoverFixture, AddMoversMatchesConstructedGroup) {
+  RigidConnectedMover mover1(args1);
+  RigidConnectedMover mover2(args2);
+  RigidConnectedGroup group({&mover1});
+  group.addMovers({&mover2});
+  EXPECT_EQ(group.movers.size(), 2);
+  EXPECT_EQ(mover2.group, &group);
+  EXPECT_EQ(group.centerOfMass, Vect2(25,0));
+  EXPECT_EQ(group.totalMass, 2);
+  EXPECT_EQ(group.momentOfInertia, 2*25*25);
+};
+
+TEST_F(RigidMoverFixture, RemoveMoversDetachesAndRecomputes) {
+  RigidConnectedMover mover1(args1);
+  RigidConnectedMover mover2(args2);
+  MoverArgs args3 = args2;
+  args3.position = Vect2(0,50);
+  RigidConnectedMover mover3(args3);
+  RigidConnectedGroup group({&mover1, &mover2, &mover3});
+  group.removeMovers({&mover3});
+  EXPECT_EQ(mover3.group, nullptr);
+  EXPECT_EQ(group.movers.size(), 2);
+  EXPECT_EQ(group.centerOfMass, Vect2(25,0));
+  EXPECT_EQ(group.momentOfInertia, 2*25*25);
+};
+
+TEST_F(RigidMoverFixture, DestroyMoversDuringEditDefersRebuild) {
+  RigidConnectedMover mover1(args1);
+  RigidConnectedMover mover2(args2);
+  MoverArgs args3 = args2;
+  args3.position = Vect2(0,50);
+  RigidConnectedMover* mover3 = new RigidConnectedMover(args3);
+  RigidConnectedMover* mover4 = new RigidConnectedMover(args3);
+  RigidConnectedGroup group({&mover1, &mover2, mover3, mover4});
+  group.beginEdit();
+  delete mover3;
+  delete mover4;
+  EXPECT_EQ(group.totalMass, 4); //not rebuilt until the edit ends
+  group.endEdit();
+  EXPECT_EQ(group.movers.size(), 2);
+  EXPECT_EQ(group.centerOfMass, Vect2(25,0));
+  EXPECT_EQ(group.totalMass, 2);
+  EXPECT_EQ(mover1.group_idx, 0);
+  EXPECT_EQ(mover2.group_idx, 1);
+};
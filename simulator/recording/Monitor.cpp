@@ -1,4 +1,5 @@
 #include "Monitor.h"
+#include <stdexcept>
 
 Monitor::Monitor(Mover* mover, std::vector<RECORDABLE_DATA> recordableData, 
   std::ostream* outputStream, int stepsBeforeFlush) : mover(mover),
@@ -52,3 +53,26 @@ void Monitor::getRecordableData(RECORDABLE_DATA dataToGet) {
       break;
     };
 };
+
+void Monitor::addRecordableData(RECORDABLE_DATA dataToRecord) {
+  data.try_emplace(dataToRecord);
+};
+
+void Monitor::openTextFileToStreamTo(std::string fileName) {
+  fileStream.open(fileName);
+  if (!fileStream) throw std::invalid_argument("Monitor::openTextFileToStreamTo: could not open " + fileName);
+  outputStream = &fileStream;
+};
+
+void Monitor::flush() {
+  // one line per recorded time: time, then each recorded field. without a stream the data stays in memory
+  if (outputStream == nullptr) return;
+  for (int i = 0; i < times.size(); i++) {
+    *outputStream << times[i];
+    for (auto& field : data) *outputStream << "," << field.second[i];
+    *outputStream << "\n";
+  }
+  outputStream->flush();
+  times.clear();
+  for (auto& field : data) field.second.clear();
+};
@@ -1,9 +1,11 @@
 #pragma once
 #include "Simulator.h"
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <unordered_map>
 #include <optional>
+#include <stdexcept>
 
 template <typename T>
 struct RotatingArray { 
@@ -13,47 +15,48 @@ struct RotatingArray {
   // perhaps for storage in a different buffer that can then be written to an output stream
   std::vector<T> data;
   int size;
-  int current_idx = 0;
+  int current_idx = 0; //slot the next element is written to
   int num_elements = 0; //current # of elements
   
   RotatingArray(int size) : size(size) {
+    if (size < 1) throw std::invalid_argument("RotatingArray: size must be at least 1");
     data.resize(size);
   }
 
   std::optional<T> add(T newElement) {
-    T return_value;
-    if (num_elements == size) {
-      return_value = data[current_idx];
-      data[current_idx] = newElement;
-      current_idx = (current_idx + 1) % size;
-      return return_value;
-    }
-    else {
-      data[current_idx] = newElement;
-      current_idx = (current_idx + 1) % size;
-      num_elements++;
-      return std::nullopt;
-    }
+    std::optional<T> return_value;
+    if (num_elements == size) return_value = std::move(data[current_idx]);
+    else num_elements++;
+    data[current_idx] = std::move(newElement);
+    current_idx = wrap(current_idx + 1);
+    return return_value;
   }
 
-  std::optional<T> pop() {
+  std::optional<T> pop() { //removes and returns the most recent element
     if (num_elements == 0) {
       return std::nullopt;
     }
-    T popped = data[current_idx];
-    current_idx = (current_idx - 1) % size;
+    current_idx = wrap(current_idx - 1);
     num_elements--;
-    return popped;
+    return std::move(data[current_idx]);
   }
 
-  std::optional<T&> get_previous(int stepsBack) { //hm, should this provide a pointer or reference?
-    if (stepsBack > num_elements) {
-      return std::nullopt;
+  T* get_previous(int stepsBack) { //1 is the most recent element, num_elements the oldest. nullptr if out of range
+    if (stepsBack < 1 || stepsBack > num_elements) {
+      return nullptr;
     }
-    int idx = (current_idx - stepsBack) % size;
-    return data[idx];
+    return &data[wrap(current_idx - stepsBack)];
+  }
+  const T* get_previous(int stepsBack) const { return const_cast<RotatingArray*>(this)->get_previous(stepsBack); }
+
+  void clear() {
+    for (auto& element : data) element = T();
+    current_idx = 0;
+    num_elements = 0;
   }
 
+  private:
+  int wrap(int idx) const { return ((idx % size) + size) % size; } //% keeps the sign of negative indices
 };
 
 //enum for recordable data 
@@ -76,6 +79,7 @@ class Monitor {
     std::unordered_map<RECORDABLE_DATA, std::vector<float> > data;
     int monitorEveryTStep = 1; // how many time steps between recordings float
     std::ostream* outputStream = nullptr;
+    std::ofstream fileStream; //owned stream, when opened with openTextFileToStreamTo
     //hold this many steps, then flush all data to outputStream
     int stepsBeforeFlush = 0;
     int data_idx = 0; //resets upon flush
@@ -0,0 +1,207 @@
+#include "ReplayRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+uint32_t bitsOf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, 4);
+  return bits;
+};
+
+float floatOf(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, 4);
+  return value;
+};
+
+void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+};
+
+uint32_t getVarint(const uint8_t*& data) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t byte = *data++;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (byte < 0x80) return value;
+  }
+};
+
+}
+
+size_t ReplaySegment::bytes() const {
+  size_t total = ids.size()*sizeof(int) + steps.size()*sizeof(long long) + times.size()*sizeof(float)
+    + deltas.size() + deltaOffsets.size()*sizeof(size_t);
+  for (auto& column : keyframe) total += column.size()*sizeof(float);
+  return total;
+};
+
+ReplayRecorder::ReplayRecorder(Simulator& simulator, std::vector<RECORDABLE_DATA> fields, int keyframeInterval,
+  int maxSegments, int stride)
+  : simulator(simulator), keyframeInterval(keyframeInterval), sampler(simulator, fields, {}, stride, 1),
+  segments(maxSegments) {
+    if (keyframeInterval < 1) throw std::invalid_argument("ReplayRecorder: keyframeInterval must be at least 1");
+    sampler.keepChunks = false;
+    sampler.onChunk = [this](const RecordChunk& sample) { append(sample); };
+};
+
+bool ReplayRecorder::record() {
+  return sampler.record();
+};
+
+void ReplayRecorder::run(int steps) {
+  for (int i = 0; i < steps; i++) {
+    simulator.update();
+    record();
+  }
+};
+
+void ReplayRecorder::clear() {
+  sampler.clear();
+  segments.clear();
+  last.clear();
+};
+
+void ReplayRecorder::append(const RecordChunk& sample) {
+  int fieldCount = sample.columns.size();
+  int moverCount = sample.ids.size();
+  ReplaySegment* open = segments.get_previous(1);
+  if (open != nullptr && open->samples() < keyframeInterval && open->ids == sample.ids) {
+    open->deltaOffsets.push_back(open->deltas.size());
+    for (int f = 0; f < fieldCount; f++) {
+      const float* values = sample.columns[f].data();
+      float* previous = last[f].data();
+      for (int m = 0; m < moverCount; m++) {
+        putVarint(open->deltas, bitsOf(values[m]) ^ bitsOf(previous[m]));
+        previous[m] = values[m];
+      }
+    }
+    open->steps.push_back(sample.steps[0]);
+    open->times.push_back(sample.times[0]);
+    return;
+  }
+  // keyframe: interval complete, first sample, or a different mover set
+  ReplaySegment segment;
+  segment.ids = sample.ids;
+  segment.steps.push_back(sample.steps[0]);
+  segment.times.push_back(sample.times[0]);
+  segment.keyframe = sample.columns;
+  segment.deltas.reserve((size_t)2*fieldCount*moverCount*(keyframeInterval - 1)); //about two bytes per value
+  segment.deltaOffsets.reserve(keyframeInterval - 1);
+  last = sample.columns;
+  auto evicted = segments.add(std::move(segment));
+  if (evicted && onEvict) onEvict(*evicted);
+};
+
+const ReplaySegment& ReplayRecorder::segment(int i) const {
+  if (i < 0 || i >= segments.num_elements) throw std::out_of_range("ReplayRecorder::segment: no segment " + std::to_string(i));
+  return *segments.get_previous(segments.num_elements - i);
+};
+
+long long ReplayRecorder::firstStep() const {
+  return empty() ? -1 : segment(0).steps.front();
+};
+
+long long ReplayRecorder::lastStep() const {
+  return empty() ? -1 : segment(segments.num_elements - 1).steps.back();
+};
+
+size_t ReplayRecorder::bytes() const {
+  size_t total = 0;
+  for (int i = 0; i < segments.num_elements; i++) total += segment(i).bytes();
+  return total;
+};
+
+int ReplayRecorder::findSegment(long long step) const {
+  // segments are in step order, so the last one starting at or before step holds it
+  int low = 0, high = segments.num_elements;
+  while (low < high) {
+    int mid = (low + high)/2;
+    if (segment(mid).steps.front() <= step) low = mid + 1;
+    else high = mid;
+  }
+  return low - 1;
+};
+
+void ReplayRecorder::applyDelta(const uint8_t*& data, std::vector<std::vector<float>>& values) {
+  for (auto& column : values) {
+    for (float& value : column) value = floatOf(bitsOf(value) ^ getVarint(data));
+  }
+};
+
+void ReplayRecorder::decode(int segmentIndex, int sample, ReplayFrame& frame) const {
+  const ReplaySegment& source = segment(segmentIndex);
+  frame.ids = source.ids;
+  frame.values = source.keyframe;
+  if (sample > 0) {
+    const uint8_t* data = source.deltas.data();
+    for (int k = 0; k < sample; k++) applyDelta(data, frame.values); //deltas are contiguous, in sample order
+  }
+  frame.step = source.steps[sample];
+  frame.time = source.times[sample];
+  frame.segmentStep = source.steps.front();
+  frame.sample = sample;
+};
+
+bool ReplayRecorder::seek(long long step, ReplayFrame& frame) const {
+  int index = findSegment(step);
+  if (index < 0) return false;
+  const auto& steps = segment(index).steps;
+  int sample = std::upper_bound(steps.begin(), steps.end(), step) - steps.begin() - 1;
+  decode(index, sample, frame);
+  return true;
+};
+
+bool ReplayRecorder::seekTime(float time, ReplayFrame& frame) const {
+  int low = 0, high = segments.num_elements;
+  while (low < high) {
+    int mid = (low + high)/2;
+    if (segment(mid).times.front() <= time) low = mid + 1;
+    else high = mid;
+  }
+  if (low == 0) return false;
+  const auto& times = segment(low - 1).times;
+  int sample = std::upper_bound(times.begin(), times.end(), time) - times.begin() - 1;
+  decode(low - 1, sample, frame);
+  return true;
+};
+
+bool ReplayRecorder::next(ReplayFrame& frame) const {
+  if (empty()) return false;
+  if (frame.step < firstStep()) {
+    decode(0, 0, frame);
+    return true;
+  }
+  int index = findSegment(frame.step);
+  const ReplaySegment& current = segment(index);
+  int sample = std::upper_bound(current.steps.begin(), current.steps.end(), frame.step) - current.steps.begin();
+  if (sample < current.samples()) {
+    if (frame.segmentStep == current.steps.front() && frame.sample == sample - 1 && frame.values.size() == current.keyframe.size()) {
+      const uint8_t* data = current.deltas.data() + current.deltaOffsets[frame.sample];
+      applyDelta(data, frame.values);
+      frame.step = current.steps[sample];
+      frame.time = current.times[sample];
+      frame.sample = sample;
+    } else {
+      decode(index, sample, frame);
+    }
+    return true;
+  }
+  if (index + 1 < segments.num_elements) {
+    decode(index + 1, 0, frame);
+    return true;
+  }
+  return false;
+};
+
+bool ReplayRecorder::previous(ReplayFrame& frame) const {
+  if (frame.step <= firstStep()) return false;
+  return seek(frame.step - 1, frame);
+};
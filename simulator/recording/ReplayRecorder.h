@@ -0,0 +1,82 @@
+#pragma once
+#include "Monitor.h"
+#include "SimulationRecorder.h"
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// One keyframe interval of a replay: the full values of every mover at the first sample,
+// then one delta per later sample. A delta holds, field by field and mover by mover, the XOR of each
+// value's bits with the previous sample's as a varint, so it is exact and values that barely change take a byte or two.
+struct ReplaySegment {
+  std::vector<int> ids;
+  std::vector<long long> steps; //one per sample, steps[0] is the keyframe's
+  std::vector<float> times;
+  std::vector<std::vector<float>> keyframe; //[field][mover]
+  std::vector<uint8_t> deltas;
+  std::vector<size_t> deltaOffsets; //delta k, which turns sample k into sample k + 1, starts at deltas[deltaOffsets[k]]
+
+  int samples() const { return steps.size(); };
+  size_t bytes() const; //memory held by the encoded samples
+};
+
+// A reconstructed sample. values[field][mover] is field of mover ids[mover] at step
+struct ReplayFrame {
+  long long step = -1;
+  float time = 0;
+  std::vector<int> ids;
+  std::vector<std::vector<float>> values;
+
+  float value(int field, int mover) const { return values[field][mover]; };
+  private:
+  friend class ReplayRecorder;
+  long long segmentStep = -1; //keyframe step of the segment this was decoded from, for stepping forward cheaply
+  int sample = -1;
+};
+
+class ReplayRecorder {
+  // Keeps the recent past of a run in memory for seeking and scrubbing without re-simulating.
+  // Every mover's fields are sampled through a SimulationRecorder; every keyframeInterval samples, or when movers are
+  // added or removed, a new segment starts with a keyframe. Segments are held in a RotatingArray, so the newest
+  // maxSegments are kept and older ones are handed to onEvict (e.g. to write them out) and dropped.
+  // seek finds the segment by its first step and replays at most keyframeInterval - 1 deltas from its keyframe.
+  public:
+    Simulator& simulator;
+    int keyframeInterval;
+    std::function<void(const ReplaySegment&)> onEvict;
+
+    ReplayRecorder(Simulator& simulator, std::vector<RECORDABLE_DATA> fields, int keyframeInterval = 64,
+      int maxSegments = 64, int stride = 1);
+    ReplayRecorder(const ReplayRecorder&) = delete; //the sampler calls back into this object
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    const std::vector<RECORDABLE_DATA>& fields() const { return sampler.fields; };
+    bool record(); //records the current state if the step is due, returns true if it did
+    void run(int steps); //updates the simulator steps times, recording every due step
+    void clear();
+
+    bool empty() const { return segments.num_elements == 0; };
+    long long firstStep() const; //oldest step that can be sought, -1 when empty
+    long long lastStep() const;
+    int segmentCount() const { return segments.num_elements; };
+    const ReplaySegment& segment(int i) const; //0 is the oldest segment kept
+    size_t bytes() const;
+
+    // frame becomes the latest recorded sample at or before step. false (frame untouched) if step is before firstStep
+    bool seek(long long step, ReplayFrame& frame) const;
+    bool seekTime(float time, ReplayFrame& frame) const;
+    // scrubbing: move frame to the next or previous recorded sample. false at either end.
+    // next applies one delta when it stays in the same segment, previous re-decodes from the keyframe
+    bool next(ReplayFrame& frame) const;
+    bool previous(ReplayFrame& frame) const;
+
+  private:
+    SimulationRecorder sampler; //samples one step per chunk, handed to append
+    RotatingArray<ReplaySegment> segments;
+    std::vector<std::vector<float>> last; //values of the latest sample, which the next delta is taken against
+
+    void append(const RecordChunk& sample);
+    int findSegment(long long step) const; //index of the segment holding step, -1 if before the first
+    void decode(int segmentIndex, int sample, ReplayFrame& frame) const;
+    static void applyDelta(const uint8_t*& data, std::vector<std::vector<float>>& values);
+};
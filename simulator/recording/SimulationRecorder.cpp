@@ -0,0 +1,187 @@
+#include "SimulationRecorder.h"
+#include <stdexcept>
+
+SimulationRecorder::SimulationRecorder(Simulator& simulator, std::vector<RECORDABLE_DATA> fields,
+  std::vector<int> moverIds, int stride, int chunkSamples)
+  : simulator(simulator), fields(fields), stride(stride), chunkSamples(chunkSamples), selectedIds(moverIds) {
+    if (fields.empty()) throw std::invalid_argument("SimulationRecorder: no fields to record");
+    if (stride < 1) throw std::invalid_argument("SimulationRecorder: stride must be at least 1");
+    if (chunkSamples < 1) throw std::invalid_argument("SimulationRecorder: chunkSamples must be at least 1");
+    for (auto field : fields) sources.push_back(sourceFor(field));
+};
+
+SimulationRecorder::FieldSource SimulationRecorder::sourceFor(RECORDABLE_DATA field) {
+  FieldSource source;
+  switch (field) {
+    case POSITION_X: source.vector = &Mover::position; source.component = &Vect2::x; break;
+    case POSITION_Y: source.vector = &Mover::position; source.component = &Vect2::y; break;
+    case VELOCITY_X: source.vector = &Mover::velocity; source.component = &Vect2::x; break;
+    case VELOCITY_Y: source.vector = &Mover::velocity; source.component = &Vect2::y; break;
+    case ACCELERATION_X: source.vector = &Mover::accel; source.component = &Vect2::x; break;
+    case ACCELERATION_Y: source.vector = &Mover::accel; source.component = &Vect2::y; break;
+    case MASS: source.scalar = &Mover::mass; break;
+    default: throw std::invalid_argument("SimulationRecorder: unknown field " + std::to_string(field));
+  }
+  return source;
+};
+
+void SimulationRecorder::compilePlan() {
+  auto& movers = simulator.movers;
+  planIndices.clear();
+  planIds.clear();
+  unresolvedIds.clear();
+  if (selectedIds.empty()) {
+    for (int i = 0; i < movers.size(); i++) {
+      planIndices.push_back(i);
+      planIds.push_back(movers[i]->id);
+    }
+  } else {
+    for (int id : selectedIds) {
+      auto it = simulator.find_mover(id);
+      planIndices.push_back(it == movers.end() ? -1 : it - movers.begin());
+      planIds.push_back(id);
+      if (it == movers.end()) unresolvedIds.push_back(id);
+    }
+  }
+  planValid = true;
+  // every mover recorded: a different mover set needs different columns, so it starts a new chunk
+  if (active.capacity > 0 && active.ids != planIds) {
+    if (active.samples > 0) completeChunk();
+    else active.capacity = 0; //resized for the new movers by startChunk
+  }
+};
+
+bool SimulationRecorder::planIsCurrent() const {
+  // cheap checks only. ids are verified per mover while copying, since the mover is read then anyway
+  if (!planValid) return false;
+  if (selectedIds.empty()) return planIds.size() == simulator.movers.size();
+  // a missing mover may have been added since (e.g. by a command queued before the recorder was made).
+  // usually there are none or a few, so they are looked up on every sample
+  for (int id : unresolvedIds) {
+    if (simulator.find_mover(id) != simulator.movers.end()) return false;
+  }
+  return true;
+};
+
+bool SimulationRecorder::record() {
+  long long step = simulator.step_count;
+  if (step == lastStep || step % stride != 0) return false;
+  auto& movers = simulator.movers;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (!planIsCurrent()) compilePlan();
+    if (active.capacity == 0) startChunk();
+    int moverCount = planIndices.size();
+    size_t base = (size_t)active.samples*moverCount;
+    int fieldCount = sources.size();
+    bool stale = false;
+    for (int m = 0; m < moverCount && !stale; m++) {
+      int index = planIndices[m];
+      if (index < 0 || index >= movers.size()) {
+        if (index >= 0) { stale = true; break; }
+        for (int f = 0; f < fieldCount; f++) active.columns[f][base + m] = NAN;
+        continue;
+      }
+      const Mover& mover = *movers[index];
+      if (mover.id != planIds[m]) { stale = true; break; } //movers were added or removed before this one
+      for (int f = 0; f < fieldCount; f++) {
+        const FieldSource& source = sources[f];
+        active.columns[f][base + m] = source.vector ? (mover.*source.vector).*source.component : mover.*source.scalar;
+      }
+    }
+    if (stale) {
+      planValid = false;
+      continue;
+    }
+    active.steps[active.samples] = step;
+    active.times[active.samples] = simulator.current_time;
+    active.samples++;
+    lastStep = step;
+    totalSamples++;
+    if (active.full()) completeChunk();
+    return true;
+  }
+  throw std::logic_error("SimulationRecorder::record: mover plan could not be resolved");
+};
+
+void SimulationRecorder::run(int steps) {
+  for (int i = 0; i < steps; i++) {
+    simulator.update();
+    record();
+  }
+};
+
+void SimulationRecorder::startChunk() {
+  // buffers are sized once per chunk, so recording a sample never allocates
+  if (!spare.empty()) {
+    active = std::move(spare.back());
+    spare.pop_back();
+  }
+  active.ids = planIds;
+  active.samples = 0;
+  active.capacity = chunkSamples;
+  size_t values = (size_t)chunkSamples*planIds.size();
+  active.steps.resize(chunkSamples);
+  active.times.resize(chunkSamples);
+  active.columns.resize(sources.size());
+  for (auto& column : active.columns) column.resize(values);
+};
+
+void SimulationRecorder::completeChunk() {
+  // trims a partly filled chunk to its samples, then hands it on
+  size_t values = (size_t)active.samples*active.ids.size();
+  active.steps.resize(active.samples);
+  active.times.resize(active.samples);
+  for (auto& column : active.columns) column.resize(values);
+  active.capacity = active.samples;
+  if (onChunk) onChunk(active);
+  if (keepChunks) chunks.push_back(std::move(active));
+  else spare.push_back(std::move(active));
+  active = RecordChunk();
+};
+
+void SimulationRecorder::flush() {
+  if (active.samples > 0) completeChunk();
+};
+
+void SimulationRecorder::clear() {
+  chunks.clear();
+  active = RecordChunk();
+  totalSamples = 0;
+  lastStep = -1;
+};
+
+std::vector<RecordChunk> SimulationRecorder::takeChunks() {
+  flush();
+  std::vector<RecordChunk> taken = std::move(chunks);
+  chunks.clear();
+  return taken;
+};
+
+RecordChunk RecordChunk::concatenate(const std::vector<RecordChunk>& chunks) {
+  RecordChunk block;
+  if (chunks.empty()) return block;
+  block.ids = chunks[0].ids;
+  block.columns.resize(chunks[0].columns.size());
+  int total = 0;
+  for (auto& chunk : chunks) {
+    if (chunk.ids != block.ids || chunk.columns.size() != block.columns.size()) {
+      throw std::invalid_argument("RecordChunk::concatenate: chunks record different movers or fields");
+    }
+    total += chunk.samples;
+  }
+  block.steps.reserve(total);
+  block.times.reserve(total);
+  for (auto& column : block.columns) column.reserve((size_t)total*block.ids.size());
+  size_t moverCount = block.ids.size();
+  for (auto& chunk : chunks) {
+    block.steps.insert(block.steps.end(), chunk.steps.begin(), chunk.steps.begin() + chunk.samples);
+    block.times.insert(block.times.end(), chunk.times.begin(), chunk.times.begin() + chunk.samples);
+    for (int f = 0; f < block.columns.size(); f++) {
+      auto& source = chunk.columns[f];
+      block.columns[f].insert(block.columns[f].end(), source.begin(), source.begin() + (size_t)chunk.samples*moverCount);
+    }
+  }
+  block.samples = total;
+  block.capacity = total;
+  return block;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include "Monitor.h"
+#include "Simulator.h"
+#include <vector>
+#include <functional>
+#include <cmath>
+
+// Samples of every recorded mover over a run of consecutive recorded steps, stored column per field.
+// columns[f][sample*ids.size() + m] is field f of mover ids[m] at steps[sample]. Movers missing at a sample read NaN.
+struct RecordChunk {
+  std::vector<int> ids;
+  std::vector<long long> steps;
+  std::vector<float> times;
+  std::vector<std::vector<float>> columns; //one per recorder field, in recorder field order
+  int samples = 0;
+  int capacity = 0;
+
+  bool full() const { return samples == capacity; };
+  float value(int field, int sample, int mover) const { return columns[field][sample*ids.size() + mover]; };
+  const float* row(int field, int sample) const { return &columns[field][sample*ids.size()]; }; //all movers at a sample
+  // one chunk holding the samples of chunks in order. throws std::invalid_argument if their movers differ
+  static RecordChunk concatenate(const std::vector<RecordChunk>& chunks);
+};
+
+class SimulationRecorder {
+  // Records the same fields of many movers at once, instead of one Monitor per mover.
+  // The requested fields and movers are compiled once into a plan of member pointers and mover indices,
+  // so a sample is one pass over the recorded movers copying straight into preallocated chunk columns,
+  // with no per-value lookups or allocations. The plan is re-resolved only when the movers it points at change.
+  public:
+    Simulator& simulator;
+    std::vector<RECORDABLE_DATA> fields;
+    int stride; //record steps where step_count % stride == 0
+    int chunkSamples; //samples per chunk
+    bool keepChunks = true; //false: chunks are only handed to onChunk, and their buffers are reused
+    std::function<void(const RecordChunk&)> onChunk; //called with every chunk once it is complete
+    std::vector<RecordChunk> chunks; //completed chunks, when keepChunks
+
+    // empty moverIds records every mover in the simulator, following additions and removals
+    SimulationRecorder(Simulator& simulator, std::vector<RECORDABLE_DATA> fields, std::vector<int> moverIds = {},
+      int stride = 1, int chunkSamples = 256);
+
+    bool record(); //records the current state if the step is due, returns true if it did
+    void run(int steps); //updates the simulator steps times, recording every due step
+    void flush(); //completes the current chunk even if it isn't full
+    const RecordChunk& current() const { return active; }; //chunk being filled
+    long long sampleCount() const { return totalSamples; };
+    void clear(); //drops recorded chunks and the current chunk
+    std::vector<RecordChunk> takeChunks(); //flushes, then hands over the recorded chunks, leaving none
+
+  private:
+    struct FieldSource { //value is (mover.*vector).*component, or mover.*scalar
+      Vect2 Mover::* vector = nullptr;
+      float Vect2::* component = nullptr;
+      float Mover::* scalar = nullptr;
+    };
+    std::vector<FieldSource> sources;
+    std::vector<int> selectedIds; //empty when recording every mover
+    std::vector<int> planIndices; //index in simulator.movers per recorded mover, -1 if missing
+    std::vector<int> planIds;
+    bool planValid = false;
+    std::vector<int> unresolvedIds; //selected ids that had no mover when the plan was compiled
+    RecordChunk active;
+    std::vector<RecordChunk> spare; //emptied chunks for reuse when !keepChunks
+    long long lastStep = -1;
+    long long totalSamples = 0;
+
+    static FieldSource sourceFor(RECORDABLE_DATA field);
+    bool planIsCurrent() const;
+    void compilePlan();
+    void startChunk();
+    void completeChunk();
+};
@@ -0,0 +1,495 @@
+#include "SimulatorCheckpoint.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+#include <future>
+#include <thread>
+
+namespace {
+
+constexpr char fileMagic[8] = {'S', 'I', 'M', 'C', 'K', 'P', 'T', '\0'};
+
+enum MoverType : uint8_t { MOVER = 0, NEWT_MOVER = 1, RIGID_MOVER = 2 };
+enum ConstraintType : uint32_t { DISTANCE = 0, ANGLE = 1, PIN = 2 };
+enum ParamTag : uint32_t { FLOAT = 0, DOUBLE = 1, INT = 2, BOOL = 3, VECT2 = 4 };
+
+static_assert(std::is_trivially_copyable<Vect2>::value && sizeof(Vect2) == 8, "Vect2 arrays are copied as bytes");
+
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t interactionCount, effectCount, interactingGroupCount;
+  float globalDt, currentTime, interactionMinDistance;
+  int32_t constraintIterations;
+  int32_t nextMoverId, currentId;
+  int64_t stepCount;
+  uint64_t moverCount, groupCount, groupMemberCount, wallCount, bondCount, constraintCount, constraintMoverCount;
+  uint64_t paramSetCount, paramBytes, typeNameBytes, configBytes;
+};
+
+struct GroupState {
+  Vect2 linearPosition, linearVelocity, linearAcceleration, centerOfMass;
+  float angularPosition, angularVelocity, angularAcceleration, totalMass, momentOfInertia;
+  uint32_t memberCount; //members are the next memberCount entries of groupMembers and groupMoments
+};
+
+struct ConstraintRecord {
+  uint32_t type;
+  uint32_t moverCount; //ids are the next moverCount entries of constraintMoverIds
+  float compliance;
+  float rest; //restLength or restAngle
+  Vect2 pin;
+};
+
+// interaction parameter sets: uint32 entryCount, uint32 0, then per entry a ParamEntry and its ParamValues
+struct ParamEntry { uint32_t typeName; uint32_t valueCount; };
+struct ParamValue { uint32_t tag; uint32_t reserved; uint8_t value[8]; };
+
+size_t padded(size_t bytes) { return (bytes + 7) & ~(size_t)7; };
+
+struct Layout { //byte offsets of every array, from the counts in the header
+  size_t moverIds, moverTypes, positions, velocities, accels, forces, radii, masses, paramSetIndex;
+  size_t groupStates, groupMembers, groupMoments, walls, bondIds, bondK, bondX0, constraints, constraintMoverIds;
+  size_t paramSetOffsets, params, typeNames, config, total;
+  Layout(const CheckpointHeader& h) {
+    size_t at = padded(sizeof(CheckpointHeader));
+    auto take = [&at](size_t bytes) { size_t start = at; at += padded(bytes); return start; };
+    moverIds = take(4*h.moverCount);
+    moverTypes = take(h.moverCount);
+    positions = take(8*h.moverCount);
+    velocities = take(8*h.moverCount);
+    accels = take(8*h.moverCount);
+    forces = take(8*h.moverCount);
+    radii = take(4*h.moverCount);
+    masses = take(4*h.moverCount);
+    paramSetIndex = take(4*h.moverCount);
+    groupStates = take(sizeof(GroupState)*h.groupCount);
+    groupMembers = take(4*h.groupMemberCount);
+    groupMoments = take(8*h.groupMemberCount);
+    walls = take(16*h.wallCount);
+    bondIds = take(8*h.bondCount);
+    bondK = take(4*h.bondCount);
+    bondX0 = take(4*h.bondCount);
+    constraints = take(sizeof(ConstraintRecord)*h.constraintCount);
+    constraintMoverIds = take(4*h.constraintMoverCount);
+    paramSetOffsets = take(8*(h.paramSetCount + 1));
+    params = take(h.paramBytes);
+    typeNames = take(h.typeNameBytes);
+    config = take(h.configBytes);
+    total = at;
+  }
+};
+
+template <class T>
+T* at(uint8_t* base, size_t offset) { return reinterpret_cast<T*>(base + offset); };
+template <class T>
+const T* at(const uint8_t* base, size_t offset) { return reinterpret_cast<const T*>(base + offset); };
+
+// runs f(start, end) over [0, count) on the pool, in a few ranges per thread
+template <class F>
+void parallelFor(ThreadPool& pool, size_t count, F f) {
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t tasks = std::max<size_t>(1, std::min(threads*4, count/16384));
+  std::vector<std::future<void>> futures;
+  for (size_t t = 0; t < tasks; t++) {
+    futures.push_back(pool.enqueue([&f, t, tasks, count]() { f(count*t/tasks, count*(t + 1)/tasks); }));
+  }
+  for (auto& future : futures) future.get();
+};
+
+// "I:name" per interaction and "E:name" per effect, in order, each followed by a 0
+std::string configurationOf(Simulator& simulator) {
+  std::string config;
+  for (auto& interaction : simulator.interactions) config += std::string("I:") + typeid(*interaction).name() + '\0';
+  for (auto& effect : simulator.effects) config += std::string("E:") + typeid(*effect).name() + '\0';
+  return config;
+};
+
+void appendBytes(std::string& out, const void* data, size_t bytes) {
+  out.append(static_cast<const char*>(data), bytes);
+};
+
+void encodeParams(const std::unordered_map<std::type_index, std::vector<std::any>>& params,
+  std::unordered_map<std::type_index, uint32_t>& typeNameIndex, std::vector<std::type_index>& typeNames, std::string& out) {
+  uint32_t setHeader[2] = {(uint32_t)params.size(), 0};
+  appendBytes(out, setHeader, sizeof(setHeader));
+  // in type name order, so equal sets encode the same whatever their maps' iteration order
+  std::vector<std::pair<std::type_index, const std::vector<std::any>*>> entries;
+  for (auto& [type, values] : params) entries.emplace_back(type, &values);
+  std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return std::strcmp(a.first.name(), b.first.name()) < 0; });
+  for (auto& [type, valuesPtr] : entries) {
+    const std::vector<std::any>& values = *valuesPtr;
+    auto [it, inserted] = typeNameIndex.try_emplace(type, typeNames.size());
+    if (inserted) typeNames.push_back(type);
+    ParamEntry entry = {it->second, (uint32_t)values.size()};
+    appendBytes(out, &entry, sizeof(entry));
+    for (auto& value : values) {
+      ParamValue encoded = {};
+      if (value.type() == typeid(float)) { encoded.tag = FLOAT; float v = std::any_cast<float>(value); std::memcpy(encoded.value, &v, 4); }
+      else if (value.type() == typeid(double)) { encoded.tag = DOUBLE; double v = std::any_cast<double>(value); std::memcpy(encoded.value, &v, 8); }
+      else if (value.type() == typeid(int)) { encoded.tag = INT; int v = std::any_cast<int>(value); std::memcpy(encoded.value, &v, 4); }
+      else if (value.type() == typeid(bool)) { encoded.tag = BOOL; encoded.value[0] = std::any_cast<bool>(value); }
+      else if (value.type() == typeid(Vect2)) { encoded.tag = VECT2; Vect2 v = std::any_cast<Vect2>(value); std::memcpy(encoded.value, &v, 8); }
+      else {
+        throw std::invalid_argument(std::string("SimulatorCheckpoint::save: can't save an interaction parameter of type ")
+          + value.type().name());
+      }
+      appendBytes(out, &encoded, sizeof(encoded));
+    }
+  }
+};
+
+// decodes one parameter set. types maps the checkpoint's type name indices to the simulator's types
+std::unordered_map<std::type_index, std::vector<std::any>> decodeParams(const uint8_t* data, size_t bytes,
+  const std::vector<std::type_index>& types) {
+  std::unordered_map<std::type_index, std::vector<std::any>> params;
+  auto need = [&](size_t offset, size_t size) {
+    if (offset + size > bytes) throw std::invalid_argument("SimulatorCheckpoint::restore: parameter set is truncated");
+  };
+  need(0, 8);
+  uint32_t entryCount;
+  std::memcpy(&entryCount, data, 4);
+  size_t offset = 8;
+  for (uint32_t e = 0; e < entryCount; e++) {
+    need(offset, sizeof(ParamEntry));
+    ParamEntry entry;
+    std::memcpy(&entry, data + offset, sizeof(entry));
+    offset += sizeof(entry);
+    if (entry.typeName >= types.size()) throw std::invalid_argument("SimulatorCheckpoint::restore: bad parameter type index");
+    need(offset, (size_t)entry.valueCount*sizeof(ParamValue));
+    std::vector<std::any>& values = params[types[entry.typeName]];
+    for (uint32_t v = 0; v < entry.valueCount; v++, offset += sizeof(ParamValue)) {
+      ParamValue encoded;
+      std::memcpy(&encoded, data + offset, sizeof(encoded));
+      switch (encoded.tag) {
+        case FLOAT: { float x; std::memcpy(&x, encoded.value, 4); values.push_back(x); break; }
+        case DOUBLE: { double x; std::memcpy(&x, encoded.value, 8); values.push_back(x); break; }
+        case INT: { int x; std::memcpy(&x, encoded.value, 4); values.push_back(x); break; }
+        case BOOL: values.push_back(encoded.value[0] != 0); break;
+        case VECT2: { Vect2 x; std::memcpy(&x, encoded.value, 8); values.push_back(x); break; }
+        default: throw std::invalid_argument("SimulatorCheckpoint::restore: unknown parameter tag");
+      }
+    }
+  }
+  return params;
+};
+
+}
+
+std::vector<uint8_t> SimulatorCheckpoint::save(Simulator& simulator) {
+  auto& movers = simulator.movers;
+  size_t n = movers.size();
+  CheckpointHeader header = {};
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = formatVersion;
+
+  // distinct parameter sets. neighbouring movers usually share one, so compare with the previous mover first
+  std::unordered_map<std::type_index, uint32_t> typeNameIndex;
+  std::vector<std::type_index> typeNames;
+  std::unordered_map<std::string, int32_t> setIndex;
+  std::vector<const std::string*> sets;
+  std::vector<int32_t> moverSets(n);
+  std::string encoded, previous;
+  int32_t previousSet = -1;
+  for (size_t i = 0; i < n; i++) {
+    encoded.clear();
+    encodeParams(movers[i]->interactionParams, typeNameIndex, typeNames, encoded);
+    if (previousSet < 0 || encoded != previous) {
+      auto [it, inserted] = setIndex.try_emplace(encoded, sets.size());
+      if (inserted) sets.push_back(&it->first);
+      previousSet = it->second;
+      previous = encoded;
+    }
+    moverSets[i] = previousSet;
+  }
+  std::string params;
+  std::vector<uint64_t> setOffsets;
+  for (auto set : sets) {
+    setOffsets.push_back(params.size());
+    params += *set;
+  }
+  setOffsets.push_back(params.size());
+  std::string names;
+  for (auto& type : typeNames) names += std::string(type.name()) + '\0';
+  std::string config = configurationOf(simulator);
+
+  // rigid groups, with members as indices into movers
+  std::vector<GroupState> groupStates;
+  std::vector<int32_t> groupMembers;
+  std::vector<Vect2> groupMoments;
+  for (auto& group : simulator.groups) {
+    GroupState state = {group->linearPosition, group->linearVelocity, group->linearAcceleration, group->centerOfMass,
+      group->angularPosition, group->angularVelocity, group->angularAcceleration, group->totalMass, group->momentOfInertia,
+      (uint32_t)group->movers.size()};
+    groupStates.push_back(state);
+    for (int m = 0; m < group->movers.size(); m++) {
+      groupMembers.push_back(simulator.find_mover(group->movers[m]->id) - movers.begin());
+      groupMoments.push_back(m < group->moverMoments.size() ? group->moverMoments[m] : Vect2());
+    }
+  }
+  std::vector<int32_t> bondIds1, bondIds2;
+  std::vector<float> bondK, bondX0;
+  simulator.bondNetwork.getBonds(bondIds1, bondIds2, bondK, bondX0);
+  std::vector<ConstraintRecord> constraints;
+  std::vector<int32_t> constraintMoverIds;
+  for (auto& constraint : simulator.constraintSolver.constraints) {
+    ConstraintRecord record = {0, (uint32_t)constraint->moverIds.size(), constraint->compliance, 0, Vect2()};
+    if (auto distance = dynamic_cast<DistanceConstraint*>(constraint.get())) { record.type = DISTANCE; record.rest = distance->restLength; }
+    else if (auto angle = dynamic_cast<AngleConstraint*>(constraint.get())) { record.type = ANGLE; record.rest = angle->restAngle; }
+    else if (auto pin = dynamic_cast<PinConstraint*>(constraint.get())) { record.type = PIN; record.pin = pin->pinPosition; }
+    else throw std::invalid_argument(std::string("SimulatorCheckpoint::save: can't save constraint type ") + typeid(*constraint).name());
+    constraints.push_back(record);
+    constraintMoverIds.insert(constraintMoverIds.end(), constraint->moverIds.begin(), constraint->moverIds.end());
+  }
+
+  header.interactionCount = simulator.interactions.size();
+  header.effectCount = simulator.effects.size();
+  header.interactingGroupCount = simulator.interactingGroups.size();
+  header.globalDt = simulator.global_dt;
+  header.currentTime = simulator.current_time;
+  header.interactionMinDistance = simulator.interaction_min_distance;
+  header.constraintIterations = simulator.constraintSolver.iterations;
+  header.nextMoverId = simulator.factory.nextMoverId();
+  header.currentId = simulator.current_id;
+  header.stepCount = simulator.step_count;
+  header.moverCount = n;
+  header.groupCount = groupStates.size();
+  header.groupMemberCount = groupMembers.size();
+  header.wallCount = simulator.walls.size();
+  header.bondCount = bondK.size();
+  header.constraintCount = constraints.size();
+  header.constraintMoverCount = constraintMoverIds.size();
+  header.paramSetCount = sets.size();
+  header.paramBytes = params.size();
+  header.typeNameBytes = names.size();
+  header.configBytes = config.size();
+  Layout layout(header);
+  std::vector<uint8_t> buffer(layout.total);
+  uint8_t* base = buffer.data();
+  std::memcpy(base, &header, sizeof(header));
+
+  // mover columns, gathered in parallel
+  int32_t* ids = at<int32_t>(base, layout.moverIds);
+  uint8_t* types = at<uint8_t>(base, layout.moverTypes);
+  Vect2* positions = at<Vect2>(base, layout.positions);
+  Vect2* velocities = at<Vect2>(base, layout.velocities);
+  Vect2* accels = at<Vect2>(base, layout.accels);
+  Vect2* forces = at<Vect2>(base, layout.forces);
+  float* radii = at<float>(base, layout.radii);
+  float* masses = at<float>(base, layout.masses);
+  parallelFor(simulator.threadPool, n, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      Mover* mover = movers[i].get();
+      const std::type_info& type = typeid(*mover);
+      if (type == typeid(RigidConnectedMover)) types[i] = RIGID_MOVER;
+      else if (type == typeid(NewtMover)) types[i] = NEWT_MOVER;
+      else if (type == typeid(Mover)) types[i] = MOVER;
+      else throw std::invalid_argument(std::string("SimulatorCheckpoint::save: can't save mover type ") + type.name());
+      ids[i] = mover->id;
+      positions[i] = mover->position;
+      velocities[i] = mover->velocity;
+      accels[i] = mover->accel;
+      forces[i] = types[i] == MOVER ? Vect2() : static_cast<NewtMover*>(mover)->force_sum.load();
+      radii[i] = mover->radius;
+      masses[i] = mover->mass;
+    }
+  });
+  std::memcpy(base + layout.paramSetIndex, moverSets.data(), 4*n);
+  std::memcpy(base + layout.groupStates, groupStates.data(), sizeof(GroupState)*groupStates.size());
+  std::memcpy(base + layout.groupMembers, groupMembers.data(), 4*groupMembers.size());
+  std::memcpy(base + layout.groupMoments, groupMoments.data(), 8*groupMoments.size());
+  Vect2* walls = at<Vect2>(base, layout.walls);
+  for (size_t w = 0; w < simulator.walls.size(); w++) {
+    walls[2*w] = simulator.walls[w]->pointA;
+    walls[2*w + 1] = simulator.walls[w]->pointB;
+  }
+  int32_t* bondIds = at<int32_t>(base, layout.bondIds);
+  for (size_t b = 0; b < bondK.size(); b++) {
+    bondIds[2*b] = bondIds1[b];
+    bondIds[2*b + 1] = bondIds2[b];
+  }
+  std::memcpy(base + layout.bondK, bondK.data(), 4*bondK.size());
+  std::memcpy(base + layout.bondX0, bondX0.data(), 4*bondX0.size());
+  std::memcpy(base + layout.constraints, constraints.data(), sizeof(ConstraintRecord)*constraints.size());
+  std::memcpy(base + layout.constraintMoverIds, constraintMoverIds.data(), 4*constraintMoverIds.size());
+  std::memcpy(base + layout.paramSetOffsets, setOffsets.data(), 8*setOffsets.size());
+  std::memcpy(base + layout.params, params.data(), params.size());
+  std::memcpy(base + layout.typeNames, names.data(), names.size());
+  std::memcpy(base + layout.config, config.data(), config.size());
+  return buffer;
+};
+
+void SimulatorCheckpoint::saveFile(Simulator& simulator, const std::string& path) {
+  // written beside the old checkpoint and renamed over it, so a crash mid-save leaves the old one intact
+  std::vector<uint8_t> buffer = save(simulator);
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("SimulatorCheckpoint::saveFile: could not open " + temporary);
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    if (!file) throw std::runtime_error("SimulatorCheckpoint::saveFile: write failed");
+  }
+  std::filesystem::rename(temporary, path);
+};
+
+void SimulatorCheckpoint::restore(Simulator& simulator, const uint8_t* data, size_t size, bool checkConfiguration) {
+  std::vector<uint8_t> aligned;
+  if (reinterpret_cast<uintptr_t>(data) % 8 != 0) { //arrays are read in place, which needs the buffer 8 byte aligned
+    aligned.assign(data, data + size);
+    data = aligned.data();
+  }
+  auto fail = [](const std::string& reason) { throw std::invalid_argument("SimulatorCheckpoint::restore: " + reason); };
+  if (size < sizeof(CheckpointHeader)) fail("too short for a checkpoint");
+  CheckpointHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) fail("not a checkpoint");
+  if (header.version != formatVersion) fail("unsupported version " + std::to_string(header.version));
+  for (uint64_t count : {header.moverCount, header.groupCount, header.groupMemberCount, header.wallCount, header.bondCount,
+    header.constraintCount, header.constraintMoverCount, header.paramSetCount, header.paramBytes, header.typeNameBytes, header.configBytes}) {
+    if (count > size) fail("corrupt counts"); //also keeps the layout arithmetic from overflowing
+  }
+  Layout layout(header);
+  if (layout.total > size) fail("truncated");
+  size_t n = header.moverCount;
+
+  // everything is checked before the simulator is touched
+  std::string config(at<char>(data, layout.config), header.configBytes);
+  if (checkConfiguration && (config != configurationOf(simulator) || header.interactingGroupCount != simulator.interactingGroups.size())) {
+    fail("the simulator's interactions, effects or interacting groups differ from the checkpoint's");
+  }
+  std::vector<std::type_index> types;
+  const char* names = at<char>(data, layout.typeNames);
+  for (size_t offset = 0; offset < header.typeNameBytes;) {
+    std::string name(names + offset, strnlen(names + offset, header.typeNameBytes - offset));
+    offset += name.size() + 1;
+    bool found = false;
+    for (auto& interaction : simulator.interactions) {
+      if (!found && name == typeid(*interaction).name()) { types.push_back(typeid(*interaction)); found = true; }
+    }
+    for (auto& effect : simulator.effects) {
+      if (!found && name == typeid(*effect).name()) { types.push_back(typeid(*effect)); found = true; }
+    }
+    if (!found) fail("movers have parameters for " + name + ", which the simulator has no interaction or effect of");
+  }
+  const uint64_t* setOffsets = at<uint64_t>(data, layout.paramSetOffsets);
+  std::vector<std::unordered_map<std::type_index, std::vector<std::any>>> paramSets;
+  for (size_t s = 0; s < header.paramSetCount; s++) {
+    if (setOffsets[s] > setOffsets[s + 1] || setOffsets[s + 1] > header.paramBytes) fail("bad parameter set offsets");
+    paramSets.push_back(decodeParams(data + layout.params + setOffsets[s], setOffsets[s + 1] - setOffsets[s], types));
+  }
+  const int32_t* ids = at<int32_t>(data, layout.moverIds);
+  const uint8_t* moverTypes = at<uint8_t>(data, layout.moverTypes);
+  const Vect2* positions = at<Vect2>(data, layout.positions);
+  const Vect2* velocities = at<Vect2>(data, layout.velocities);
+  const Vect2* accels = at<Vect2>(data, layout.accels);
+  const Vect2* forces = at<Vect2>(data, layout.forces);
+  const float* radii = at<float>(data, layout.radii);
+  const float* masses = at<float>(data, layout.masses);
+  const int32_t* moverSets = at<int32_t>(data, layout.paramSetIndex);
+  for (size_t i = 0; i < n; i++) {
+    if (moverTypes[i] > RIGID_MOVER) fail("unknown mover type");
+    if (moverTypes[i] != MOVER && masses[i] == 0) fail("NewtMover with zero mass");
+    if (moverSets[i] < 0 || moverSets[i] >= (int64_t)header.paramSetCount) fail("bad parameter set index");
+    if (i > 0 && ids[i] <= ids[i - 1]) fail("movers are not sorted by id");
+  }
+  const GroupState* groupStates = at<GroupState>(data, layout.groupStates);
+  const int32_t* groupMembers = at<int32_t>(data, layout.groupMembers);
+  std::vector<uint8_t> grouped(n, 0);
+  size_t memberTotal = 0;
+  for (size_t g = 0; g < header.groupCount; g++) memberTotal += groupStates[g].memberCount;
+  if (memberTotal != header.groupMemberCount) fail("group sizes don't add up");
+  for (size_t m = 0; m < header.groupMemberCount; m++) {
+    int32_t index = groupMembers[m];
+    if (index < 0 || index >= n || moverTypes[index] != RIGID_MOVER || grouped[index]++) fail("bad group member");
+  }
+  const ConstraintRecord* constraints = at<ConstraintRecord>(data, layout.constraints);
+  size_t constraintMoverTotal = 0;
+  for (size_t c = 0; c < header.constraintCount; c++) {
+    uint32_t expected = constraints[c].type == DISTANCE ? 2 : constraints[c].type == ANGLE ? 3 : 1;
+    if (constraints[c].type > PIN || constraints[c].moverCount != expected) fail("bad constraint");
+    constraintMoverTotal += constraints[c].moverCount;
+  }
+  if (constraintMoverTotal != header.constraintMoverCount) fail("constraint sizes don't add up");
+  const int32_t* bondIds = at<int32_t>(data, layout.bondIds);
+  for (size_t b = 0; b < header.bondCount; b++) {
+    if (bondIds[2*b] == bondIds[2*b + 1]) fail("mover bonded to itself"); //addBond would throw halfway through
+  }
+
+  // replace the state. interactions, effects and interacting groups are kept
+  simulator.movers.clear();
+  simulator.groups.clear();
+  simulator.walls.clear();
+  simulator.bondNetwork.clear();
+  simulator.constraintSolver.clear();
+  auto& movers = simulator.movers;
+  movers.resize(n);
+  parallelFor(simulator.threadPool, n, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      MoverArgs args(positions[i], velocities[i], accels[i], radii[i], masses[i]);
+      std::unique_ptr<Mover> mover;
+      if (moverTypes[i] == MOVER) mover = std::make_unique<Mover>(args);
+      else if (moverTypes[i] == NEWT_MOVER) mover = std::make_unique<NewtMover>(args);
+      else mover = std::make_unique<RigidConnectedMover>(args, nullptr);
+      if (moverTypes[i] != MOVER) static_cast<NewtMover*>(mover.get())->force_sum = forces[i];
+      mover->id = ids[i];
+      mover->interactionParams = paramSets[moverSets[i]];
+      movers[i] = std::move(mover);
+    }
+  });
+  const Vect2* groupMoments = at<Vect2>(data, layout.groupMoments);
+  size_t member = 0;
+  for (size_t g = 0; g < header.groupCount; g++) {
+    const GroupState& state = groupStates[g];
+    std::vector<RigidConnectedMover*> members;
+    for (uint32_t m = 0; m < state.memberCount; m++) {
+      members.push_back(static_cast<RigidConnectedMover*>(movers[groupMembers[member + m]].get()));
+    }
+    auto group = std::make_unique<RigidConnectedGroup>(members);
+    // the constructor derives these from the movers as they are now, with the body unrotated. use the saved ones
+    group->linearPosition = state.linearPosition;
+    group->linearVelocity = state.linearVelocity;
+    group->linearAcceleration = state.linearAcceleration;
+    group->centerOfMass = state.centerOfMass;
+    group->angularPosition = state.angularPosition;
+    group->angularVelocity = state.angularVelocity;
+    group->angularAcceleration = state.angularAcceleration;
+    group->totalMass = state.totalMass;
+    group->momentOfInertia = state.momentOfInertia;
+    group->moverMoments.assign(groupMoments + member, groupMoments + member + state.memberCount);
+    member += state.memberCount;
+    simulator.groups.push_back(std::move(group));
+  }
+  const Vect2* walls = at<Vect2>(data, layout.walls);
+  for (size_t w = 0; w < header.wallCount; w++) simulator.add_wall(walls[2*w], walls[2*w + 1]);
+  const float* bondK = at<float>(data, layout.bondK);
+  const float* bondX0 = at<float>(data, layout.bondX0);
+  for (size_t b = 0; b < header.bondCount; b++) simulator.bondNetwork.addBond(bondIds[2*b], bondIds[2*b + 1], bondK[b], bondX0[b]);
+  const int32_t* constraintMoverIds = at<int32_t>(data, layout.constraintMoverIds);
+  for (size_t c = 0; c < header.constraintCount; c++) {
+    const ConstraintRecord& record = constraints[c];
+    const int32_t* ids = constraintMoverIds;
+    constraintMoverIds += record.moverCount;
+    Constraint* constraint;
+    if (record.type == DISTANCE) constraint = new DistanceConstraint(ids[0], ids[1], record.rest, record.compliance);
+    else if (record.type == ANGLE) constraint = new AngleConstraint(ids[0], ids[1], ids[2], record.rest, record.compliance);
+    else constraint = new PinConstraint(ids[0], record.pin, record.compliance);
+    simulator.constraintSolver.addConstraint(constraint);
+  }
+  simulator.global_dt = header.globalDt;
+  simulator.current_time = header.currentTime;
+  simulator.interaction_min_distance = header.interactionMinDistance;
+  simulator.constraintSolver.iterations = header.constraintIterations;
+  simulator.factory.setNextMoverId(header.nextMoverId);
+  simulator.current_id = header.currentId;
+  simulator.step_count = header.stepCount;
+  if (simulator.publishSnapshots) simulator.publish_snapshot();
+};
+
+void SimulatorCheckpoint::restoreFile(Simulator& simulator, const std::string& path, bool checkConfiguration) {
+  MappedFile file(path);
+  restore(simulator, file.data(), file.size(), checkConfiguration);
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include "Simulator.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Binary checkpoint of a Simulator's state: movers with their interaction parameters, rigid groups with their
+body-frame moments and linear/angular state, walls, spring bonds, constraints, ids, time and step count.
+
+Interactions, effects and interacting groups are configuration rather than state: they hold code (kernels,
+field functions) that can't be written to a file. A checkpoint records their types, and is restored into a
+simulator set up with the same interactions and effects, which is also how their parameter types are resolved.
+
+Layout (little endian): a CheckpointHeader, then arrays sized by its counts, each starting on an 8 byte
+boundary. Mover state is stored column per field, so saving is a bulk gather and restoring reads the columns in
+place from a mapped file. Interaction parameter sets are stored once per distinct set, not once per mover.
+Save and restore between steps, not while another thread is stepping the simulator.
+*/
+class SimulatorCheckpoint {
+  public:
+    static constexpr uint32_t formatVersion = 1;
+
+    static std::vector<uint8_t> save(Simulator& simulator);
+    static void saveFile(Simulator& simulator, const std::string& path);
+    // replaces the simulator's state with the checkpoint's. throws std::invalid_argument without changing anything
+    // if the checkpoint doesn't fit the simulator's interactions and effects (checkConfiguration also compares
+    // their order and the number of interacting groups)
+    static void restore(Simulator& simulator, const uint8_t* data, size_t size, bool checkConfiguration = true);
+    static void restoreFile(Simulator& simulator, const std::string& path, bool checkConfiguration = true);
+};
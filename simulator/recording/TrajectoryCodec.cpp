@@ -0,0 +1,115 @@
+#include "TrajectoryCodec.h"
+#include "TrajectoryFormat.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace trajectory {
+
+static uint64_t zigzag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); };
+static int64_t unzigzag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); };
+static int bitWidth(uint64_t value) { int bits = 0; while (value) { bits++; value >>= 1; } return bits; };
+
+// the value expected from the same mover's previous two samples: linear extrapolation, so smooth motion
+// costs a few bits whatever its speed. falls back to the previous sample, then to zero, at the start of a chunk
+static int64_t predict(const int64_t* quantized, size_t i, int movers) {
+  if (i >= 2*(size_t)movers) return 2*quantized[i - movers] - quantized[i - 2*movers];
+  if (i >= (size_t)movers) return quantized[i - movers];
+  return 0;
+};
+
+static void appendBytes(std::vector<uint8_t>& out, const void* data, size_t bytes) {
+  const uint8_t* begin = static_cast<const uint8_t*>(data);
+  out.insert(out.end(), begin, begin + bytes);
+};
+
+static void appendRaw(const float* values, size_t count, std::vector<uint8_t>& out) {
+  ColumnHeader header = {COLUMN_RAW, 0, padded(4*count)};
+  appendBytes(out, &header, sizeof(header));
+  appendBytes(out, values, 4*count);
+  out.resize(out.size() + header.bytes - 4*count, 0);
+};
+
+void encodeColumn(const float* values, int samples, int movers, float maxError, std::vector<uint8_t>& out) {
+  size_t count = (size_t)samples*movers;
+  if (maxError <= 0) return appendRaw(values, count, out);
+  double quantum = (float)(2.0*maxError); //as stored, so encoder and decoder agree exactly
+  const double limit = 1e18; //keeps quantized values and their residuals inside int64
+  std::vector<int64_t> quantized(count);
+  for (size_t i = 0; i < count; i++) {
+    double scaled = values[i]/quantum;
+    if (!std::isfinite(scaled) || std::abs(scaled) > limit) return appendRaw(values, count, out);
+    quantized[i] = std::llround(scaled);
+  }
+  std::vector<uint64_t> deltas(count);
+  for (size_t i = 0; i < count; i++) deltas[i] = zigzag(quantized[i] - predict(quantized.data(), i, movers));
+  size_t blockCount = (count + blockValues - 1)/blockValues;
+  std::vector<uint8_t> widths(blockCount);
+  size_t totalBits = 0;
+  for (size_t b = 0; b < blockCount; b++) {
+    uint64_t combined = 0;
+    size_t end = std::min(count, (b + 1)*blockValues);
+    for (size_t i = b*blockValues; i < end; i++) combined |= deltas[i];
+    widths[b] = bitWidth(combined);
+    totalBits += (size_t)widths[b]*(end - b*blockValues);
+  }
+  std::vector<uint64_t> words((totalBits + 63)/64, 0);
+  size_t bit = 0;
+  for (size_t b = 0; b < blockCount; b++) {
+    int width = widths[b];
+    if (width == 0) continue;
+    size_t end = std::min(count, (b + 1)*blockValues);
+    for (size_t i = b*blockValues; i < end; i++, bit += width) {
+      int offset = bit & 63;
+      words[bit >> 6] |= deltas[i] << offset;
+      if (offset + width > 64) words[(bit >> 6) + 1] |= deltas[i] >> (64 - offset);
+    }
+  }
+  ColumnHeader header = {COLUMN_QUANTIZED, (float)quantum, padded(blockCount) + 8*words.size()};
+  appendBytes(out, &header, sizeof(header));
+  appendBytes(out, widths.data(), blockCount);
+  out.resize(out.size() + padded(blockCount) - blockCount, 0);
+  appendBytes(out, words.data(), 8*words.size());
+};
+
+size_t decodeColumn(const uint8_t* data, int samples, int movers, float* out) {
+  ColumnHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  const uint8_t* body = data + sizeof(header);
+  size_t count = (size_t)samples*movers;
+  if (header.mode == COLUMN_RAW) {
+    std::memcpy(out, body, 4*count);
+    return sizeof(header) + header.bytes;
+  }
+  size_t blockCount = (count + blockValues - 1)/blockValues;
+  const uint8_t* widths = body;
+  const uint8_t* words = body + padded(blockCount);
+  double quantum = header.quantum;
+  std::vector<int64_t> quantized(count);
+  size_t bit = 0;
+  for (size_t b = 0; b < blockCount; b++) {
+    int width = widths[b];
+    uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+    size_t end = std::min(count, (b + 1)*blockValues);
+    for (size_t i = b*blockValues; i < end; i++, bit += width) {
+      uint64_t value = 0;
+      if (width > 0) {
+        int offset = bit & 63;
+        uint64_t word;
+        std::memcpy(&word, words + 8*(bit >> 6), 8);
+        value = word >> offset;
+        if (offset + width > 64) {
+          uint64_t next;
+          std::memcpy(&next, words + 8*((bit >> 6) + 1), 8);
+          value |= next << (64 - offset);
+        }
+        value &= mask;
+      }
+      quantized[i] = predict(quantized.data(), i, movers) + unzigzag(value);
+      out[i] = (float)(quantized[i]*quantum);
+    }
+  }
+  return sizeof(header) + header.bytes;
+};
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+Lossy-bounded column codec for trajectory chunks (chunk encoding QUANTIZED in TrajectoryFormat.h).
+Each column is written as a ColumnHeader then its data, padded to 8 bytes.
+  COLUMN_RAW        the floats as is. used for lossless fields, and for columns holding NaN/inf (missing movers)
+  COLUMN_QUANTIZED  values rounded to multiples of quantum = 2*maxError, so every value is within maxError
+                    (plus float rounding). each value is stored as its difference from a linear extrapolation
+                    of the same mover's previous two samples, zigzag mapped to unsigned and bit-packed in
+                    blocks of blockValues, each block with the bit width of its largest value.
+                    layout: uint8 widths[blockCount] padded to 8, then the packed uint64 words
+*/
+namespace trajectory {
+
+enum ColumnMode : uint32_t {
+  COLUMN_RAW = 0,
+  COLUMN_QUANTIZED = 1,
+};
+
+struct ColumnHeader {
+  uint32_t mode;
+  float quantum;
+  uint64_t bytes; //data bytes after this header, including padding
+};
+
+constexpr int blockValues = 128;
+
+// appends column (samples*movers values, sample major) to out. maxError <= 0 stores it raw
+void encodeColumn(const float* values, int samples, int movers, float maxError, std::vector<uint8_t>& out);
+// decodes one column written by encodeColumn into out. returns the bytes it took, header included
+size_t decodeColumn(const uint8_t* data, int samples, int movers, float* out);
+
+}
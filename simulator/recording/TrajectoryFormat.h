@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/*
+Binary trajectory file, written by TrajectoryWriter and mapped by TrajectoryReader. Little endian.
+
+  file header      TrajectoryFileHeader, then uint32 field ids (RECORDABLE_DATA), padded to 8 bytes
+  chunk ...        TrajectoryChunkHeader, then payloadBytes of chunk data
+  chunk index      TrajectoryIndexHeader, then one TrajectoryIndexEntry per chunk
+
+Raw chunk payload, every array starting on an 8 byte boundary so a mapped file can be read in place:
+  int32 ids[moverCount], int64 steps[samples], float times[samples],
+  then per field float values[samples*moverCount] (sample major, as RecordChunk::columns)
+Quantized chunks have the same ids, steps and times, followed by one encoded column per field (TrajectoryCodec.h).
+
+indexOffset stays 0 until the writer is closed. A reader of an unclosed file rebuilds the index
+by walking the chunk headers, so a run that stopped early is still readable up to its last whole chunk.
+*/
+namespace trajectory {
+
+constexpr char fileMagic[8] = {'S', 'I', 'M', 'T', 'R', 'A', 'J', '\0'};
+constexpr uint32_t formatVersion = 1;
+constexpr uint32_t chunkMagic = 0x4B4E4843; //"CHNK"
+constexpr uint32_t indexMagic = 0x58444E49; //"INDX"
+
+enum Encoding : uint32_t {
+  RAW = 0,
+  QUANTIZED = 1, //columns encoded by TrajectoryCodec
+};
+
+struct TrajectoryFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t fieldCount;
+  uint64_t indexOffset; //0 while the file is being written
+};
+
+struct TrajectoryChunkHeader {
+  uint32_t magic;
+  uint32_t encoding;
+  uint32_t samples;
+  uint32_t moverCount;
+  uint64_t payloadBytes; //bytes after this header up to the next chunk
+  int64_t firstStep;
+};
+
+struct TrajectoryIndexHeader {
+  uint32_t magic;
+  uint32_t reserved;
+  uint64_t chunkCount;
+};
+
+struct TrajectoryIndexEntry {
+  uint64_t offset; //of the chunk header
+  int64_t firstStep, lastStep;
+  uint32_t samples, moverCount;
+  float firstTime, lastTime;
+};
+
+inline size_t padded(size_t bytes) { return (bytes + 7) & ~(size_t)7; };
+
+// byte offsets of the raw payload arrays, relative to the start of the payload
+struct RawLayout {
+  size_t ids, steps, times, columns, columnStride, total;
+  RawLayout(uint32_t samples, uint32_t moverCount, uint32_t fieldCount) {
+    ids = 0;
+    steps = padded(4*(size_t)moverCount);
+    times = steps + 8*(size_t)samples;
+    columns = times + padded(4*(size_t)samples);
+    columnStride = padded(4*(size_t)samples*moverCount);
+    total = columns + columnStride*fieldCount;
+  }
+};
+
+}
@@ -0,0 +1,167 @@
+#include "TrajectoryReader.h"
+#include "TrajectoryCodec.h"
+#include "ThreadPool.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+using namespace trajectory;
+
+TrajectoryReader::TrajectoryReader(const std::string& path) : file(path), data(file.data()), length(file.size()) {
+  if (length < sizeof(TrajectoryFileHeader)) throw std::runtime_error("TrajectoryReader: " + path + " is too short");
+  TrajectoryFileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) {
+    throw std::runtime_error("TrajectoryReader: " + path + " is not a trajectory file");
+  }
+  if (header.version != formatVersion) {
+    throw std::runtime_error("TrajectoryReader: unsupported version " + std::to_string(header.version));
+  }
+  size_t firstChunk = sizeof(header) + padded(4*(size_t)header.fieldCount);
+  if (firstChunk > length) throw std::runtime_error("TrajectoryReader: " + path + " is truncated");
+  const uint32_t* ids = reinterpret_cast<const uint32_t*>(data + sizeof(header));
+  for (uint32_t i = 0; i < header.fieldCount; i++) fieldList.push_back(static_cast<RECORDABLE_DATA>(ids[i]));
+  complete = header.indexOffset != 0 && readIndex(header.indexOffset);
+  if (!complete) rebuildIndex(firstChunk);
+  frameStarts.push_back(0);
+  for (auto& entry : chunkIndex) {
+    const uint8_t* encoded = nullptr;
+    chunks.push_back(viewChunk(entry, encoded));
+    encodedColumns.push_back(encoded);
+    frameStarts.push_back(frameStarts.back() + entry.samples);
+  }
+  decoded.resize(chunks.size());
+  decodeOnce.reset(new std::once_flag[chunks.size()]);
+};
+
+bool TrajectoryReader::readIndex(uint64_t indexOffset) {
+  if (indexOffset + sizeof(TrajectoryIndexHeader) > length) return false;
+  TrajectoryIndexHeader header;
+  std::memcpy(&header, data + indexOffset, sizeof(header));
+  if (header.magic != indexMagic) return false;
+  if (indexOffset + sizeof(header) + header.chunkCount*sizeof(TrajectoryIndexEntry) > length) return false;
+  chunkIndex.resize(header.chunkCount);
+  std::memcpy(chunkIndex.data(), data + indexOffset + sizeof(header), header.chunkCount*sizeof(TrajectoryIndexEntry));
+  for (auto& entry : chunkIndex) {
+    if (entry.offset + sizeof(TrajectoryChunkHeader) > indexOffset) {
+      chunkIndex.clear();
+      return false;
+    }
+  }
+  return true;
+};
+
+void TrajectoryReader::rebuildIndex(size_t offset) {
+  // the writer didn't finish: walk the chunks, keeping every one that is whole
+  chunkIndex.clear();
+  while (offset + sizeof(TrajectoryChunkHeader) <= length) {
+    TrajectoryChunkHeader header;
+    std::memcpy(&header, data + offset, sizeof(header));
+    if (header.magic != chunkMagic || header.samples == 0) break;
+    size_t payload = offset + sizeof(header);
+    if (payload + header.payloadBytes > length) break;
+    RawLayout layout(header.samples, header.moverCount, fieldList.size());
+    TrajectoryIndexEntry entry;
+    entry.offset = offset;
+    entry.samples = header.samples;
+    entry.moverCount = header.moverCount;
+    const int64_t* steps = reinterpret_cast<const int64_t*>(data + payload + layout.steps);
+    const float* times = reinterpret_cast<const float*>(data + payload + layout.times);
+    entry.firstStep = steps[0];
+    entry.lastStep = steps[header.samples - 1];
+    entry.firstTime = times[0];
+    entry.lastTime = times[header.samples - 1];
+    chunkIndex.push_back(entry);
+    offset = payload + header.payloadBytes;
+  }
+};
+
+TrajectoryReader::ChunkView TrajectoryReader::viewChunk(const TrajectoryIndexEntry& entry, const uint8_t*& encoded) const {
+  TrajectoryChunkHeader header;
+  std::memcpy(&header, data + entry.offset, sizeof(header));
+  if (header.magic != chunkMagic) throw std::runtime_error("TrajectoryReader: bad chunk header");
+  if (header.encoding != RAW && header.encoding != QUANTIZED) {
+    throw std::runtime_error("TrajectoryReader: unknown chunk encoding " + std::to_string(header.encoding));
+  }
+  RawLayout layout(header.samples, header.moverCount, fieldList.size());
+  size_t minimum = header.encoding == RAW ? layout.total : layout.columns;
+  if (header.payloadBytes < minimum || entry.offset + sizeof(header) + header.payloadBytes > length) {
+    throw std::runtime_error("TrajectoryReader: chunk payload is truncated");
+  }
+  const uint8_t* payload = data + entry.offset + sizeof(header);
+  ChunkView view;
+  view.samples = header.samples;
+  view.moverCount = header.moverCount;
+  view.ids = reinterpret_cast<const int32_t*>(payload + layout.ids);
+  view.steps = reinterpret_cast<const int64_t*>(payload + layout.steps);
+  view.times = reinterpret_cast<const float*>(payload + layout.times);
+  if (header.encoding == QUANTIZED) {
+    encoded = payload + layout.columns;
+    return view;
+  }
+  for (size_t f = 0; f < fieldList.size(); f++) {
+    view.columns.push_back(reinterpret_cast<const float*>(payload + layout.columns + f*layout.columnStride));
+  }
+  return view;
+};
+
+int TrajectoryReader::fieldIndex(RECORDABLE_DATA field) const {
+  auto it = std::find(fieldList.begin(), fieldList.end(), field);
+  return it == fieldList.end() ? -1 : it - fieldList.begin();
+};
+
+const TrajectoryReader::ChunkView& TrajectoryReader::chunk(int index) const {
+  if (index < 0 || index >= chunks.size()) throw std::out_of_range("TrajectoryReader::chunk: no chunk " + std::to_string(index));
+  return decodedChunk(index);
+};
+
+const TrajectoryReader::ChunkView& TrajectoryReader::decodedChunk(int index) const {
+  // decoding only fills in storage no one can see yet, so it is done once, by whichever thread gets there first
+  if (encodedColumns[index] != nullptr) {
+    std::call_once(decodeOnce[index], [this, index]() { decodeChunk(index); });
+  }
+  return chunks[index];
+};
+
+void TrajectoryReader::decodeChunk(int index) const {
+  ChunkView& view = chunks[index];
+  size_t values = (size_t)view.samples*view.moverCount;
+  decoded[index].resize(values*fieldList.size());
+  const uint8_t* column = encodedColumns[index];
+  for (size_t f = 0; f < fieldList.size(); f++) {
+    float* out = decoded[index].data() + f*values;
+    column += decodeColumn(column, view.samples, view.moverCount, out);
+    view.columns.push_back(out);
+  }
+};
+
+void TrajectoryReader::decodeChunks(int first, int last, int threads) {
+  first = std::max(first, 0);
+  last = std::min(last, chunkCount());
+  if (first >= last) return;
+  ThreadPool pool(std::min(threads, last - first));
+  std::vector<std::future<void>> futures;
+  for (int c = first; c < last; c++) {
+    futures.push_back(pool.enqueue([this, c]() { decodedChunk(c); }));
+  }
+  for (auto& future : futures) future.get();
+};
+
+TrajectoryReader::Frame TrajectoryReader::frame(long long index) const {
+  if (index < 0 || index >= frameCount()) throw std::out_of_range("TrajectoryReader::frame: no frame " + std::to_string(index));
+  int c = std::upper_bound(frameStarts.begin(), frameStarts.end(), index) - frameStarts.begin() - 1;
+  int sample = index - frameStarts[c];
+  const ChunkView& view = decodedChunk(c);
+  return Frame{&view, sample, view.steps[sample], view.times[sample]};
+};
+
+long long TrajectoryReader::findStep(long long step) const {
+  // chunks are in step order: pick the chunk by its index entry, then search its steps
+  auto it = std::lower_bound(chunkIndex.begin(), chunkIndex.end(), step,
+    [](const TrajectoryIndexEntry& entry, long long step) { return entry.lastStep < step; });
+  if (it == chunkIndex.end()) return frameCount();
+  int c = it - chunkIndex.begin();
+  const ChunkView& view = chunks[c];
+  int sample = std::lower_bound(view.steps, view.steps + view.samples, step) - view.steps;
+  return frameStarts[c] + sample;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include "TrajectoryFormat.h"
+#include "Monitor.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class TrajectoryReader {
+  // Maps a trajectory file (see TrajectoryFormat.h) into memory and reads it in place.
+  // Chunk and frame views point straight into the mapping: nothing is parsed or copied beyond the chunk index,
+  // and the OS only pages in what is actually read. Views are valid for the lifetime of the reader.
+  // Quantized chunks are the exception: they are decoded into memory owned by the reader the first time
+  // they are viewed, or ahead of time and in parallel with decodeChunks.
+  public:
+    struct ChunkView {
+      int samples = 0, moverCount = 0;
+      const int32_t* ids = nullptr;
+      const int64_t* steps = nullptr;
+      const float* times = nullptr;
+      std::vector<const float*> columns; //per field, samples*moverCount values, sample major
+
+      float value(int field, int sample, int mover) const { return columns[field][(size_t)sample*moverCount + mover]; };
+    };
+    struct Frame { //one recorded step
+      const ChunkView* chunk;
+      int sample;
+      int64_t step;
+      float time;
+      int moverCount() const { return chunk->moverCount; };
+      const int32_t* ids() const { return chunk->ids; };
+      const float* values(int field) const { return chunk->columns[field] + (size_t)sample*chunk->moverCount; };
+      float value(int field, int mover) const { return values(field)[mover]; };
+    };
+
+    explicit TrajectoryReader(const std::string& path);
+
+    const std::vector<RECORDABLE_DATA>& fields() const { return fieldList; };
+    int fieldIndex(RECORDABLE_DATA field) const; //-1 if the field wasn't recorded
+    bool isComplete() const { return complete; }; //false if the writer wasn't closed and the index was rebuilt
+    int chunkCount() const { return chunks.size(); };
+    const ChunkView& chunk(int index) const;
+    const trajectory::TrajectoryIndexEntry& indexEntry(int index) const { return chunkIndex.at(index); };
+    long long frameCount() const { return frameStarts.back(); };
+    Frame frame(long long index) const;
+    long long findStep(long long step) const; //index of the first frame at or after step, frameCount() if none
+    // decodes quantized chunks [first, last) in parallel, so later views don't decode on first use
+    void decodeChunks(int first, int last, int threads = std::max(1u, std::thread::hardware_concurrency()));
+
+  private:
+    MappedFile file;
+    const uint8_t* data;
+    size_t length;
+    std::vector<RECORDABLE_DATA> fieldList;
+    std::vector<trajectory::TrajectoryIndexEntry> chunkIndex;
+    mutable std::vector<ChunkView> chunks; //columns of quantized chunks are filled in when decoded
+    std::vector<const uint8_t*> encodedColumns; //per chunk, nullptr for raw chunks
+    mutable std::vector<std::vector<float>> decoded; //per chunk, storage of decoded columns
+    std::unique_ptr<std::once_flag[]> decodeOnce;
+    std::vector<long long> frameStarts; //frame index of each chunk's first sample, then the total
+    bool complete = false;
+
+    bool readIndex(uint64_t indexOffset);
+    void rebuildIndex(size_t firstChunk);
+    ChunkView viewChunk(const trajectory::TrajectoryIndexEntry& entry, const uint8_t*& encoded) const;
+    void decodeChunk(int index) const;
+    const ChunkView& decodedChunk(int index) const;
+};
@@ -0,0 +1,116 @@
+#include "TrajectoryWriter.h"
+#include "TrajectoryCodec.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+using namespace trajectory;
+
+TrajectoryWriter::TrajectoryWriter(const std::string& path, std::vector<RECORDABLE_DATA> fields, std::vector<float> maxErrors)
+  : fields(fields), maxErrors(maxErrors) {
+  if (fields.empty()) throw std::invalid_argument("TrajectoryWriter: no fields");
+  if (!maxErrors.empty() && maxErrors.size() != fields.size()) {
+    throw std::invalid_argument("TrajectoryWriter: expected one max error per field");
+  }
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file) throw std::runtime_error("TrajectoryWriter: could not open " + path);
+  TrajectoryFileHeader header;
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.version = formatVersion;
+  header.fieldCount = fields.size();
+  header.indexOffset = 0;
+  writeBytes(&header, sizeof(header));
+  for (auto field : fields) {
+    uint32_t id = field;
+    writeBytes(&id, sizeof(id));
+  }
+  pad(4*fields.size());
+};
+
+TrajectoryWriter::~TrajectoryWriter() {
+  if (isOpen()) close();
+};
+
+void TrajectoryWriter::writeBytes(const void* data, size_t bytes) {
+  file.write(static_cast<const char*>(data), bytes);
+  offset += bytes;
+};
+
+void TrajectoryWriter::pad(size_t bytes) {
+  static const char zeros[8] = {};
+  writeBytes(zeros, padded(bytes) - bytes);
+};
+
+void TrajectoryWriter::write(const RecordChunk& chunk) {
+  if (!isOpen()) throw std::logic_error("TrajectoryWriter::write: writer is closed");
+  if (chunk.columns.size() != fields.size()) {
+    throw std::invalid_argument("TrajectoryWriter::write: chunk has " + std::to_string(chunk.columns.size())
+      + " fields, file has " + std::to_string(fields.size()));
+  }
+  if (chunk.samples == 0) return;
+  uint32_t samples = chunk.samples, moverCount = chunk.ids.size();
+  RawLayout layout(samples, moverCount, fields.size());
+  TrajectoryIndexEntry entry;
+  entry.offset = offset;
+  entry.firstStep = chunk.steps[0];
+  entry.lastStep = chunk.steps[samples - 1];
+  entry.samples = samples;
+  entry.moverCount = moverCount;
+  entry.firstTime = chunk.times[0];
+  entry.lastTime = chunk.times[samples - 1];
+
+  bool quantized = std::any_of(maxErrors.begin(), maxErrors.end(), [](float error) { return error > 0; });
+  size_t values = (size_t)samples*moverCount;
+  encoded.clear();
+  if (quantized) {
+    for (int f = 0; f < fields.size(); f++) {
+      encodeColumn(chunk.columns[f].data(), samples, moverCount, maxErrors[f], encoded);
+    }
+  }
+
+  TrajectoryChunkHeader header;
+  header.magic = chunkMagic;
+  header.encoding = quantized ? QUANTIZED : RAW;
+  header.samples = samples;
+  header.moverCount = moverCount;
+  header.payloadBytes = quantized ? layout.columns + encoded.size() : layout.total;
+  header.firstStep = entry.firstStep;
+  writeBytes(&header, sizeof(header));
+  static_assert(sizeof(int) == sizeof(int32_t) && sizeof(long long) == sizeof(int64_t), "ids and steps are written as is");
+  writeBytes(chunk.ids.data(), 4*(size_t)moverCount);
+  pad(4*(size_t)moverCount);
+  writeBytes(chunk.steps.data(), 8*(size_t)samples);
+  writeBytes(chunk.times.data(), 4*(size_t)samples);
+  pad(4*(size_t)samples);
+  if (quantized) {
+    writeBytes(encoded.data(), encoded.size());
+  } else {
+    for (auto& column : chunk.columns) { //a chunk still being filled has spare capacity past its samples
+      writeBytes(column.data(), 4*values);
+      pad(4*values);
+    }
+  }
+  if (!file) throw std::runtime_error("TrajectoryWriter::write: write failed");
+  index.push_back(entry);
+};
+
+void TrajectoryWriter::attach(SimulationRecorder& recorder) {
+  if (recorder.fields != fields) throw std::invalid_argument("TrajectoryWriter::attach: recorder fields differ from the file's");
+  recorder.keepChunks = false;
+  recorder.onChunk = [this](const RecordChunk& chunk) { write(chunk); };
+};
+
+void TrajectoryWriter::close() {
+  if (!isOpen()) return;
+  uint64_t indexOffset = offset;
+  TrajectoryIndexHeader header;
+  header.magic = indexMagic;
+  header.reserved = 0;
+  header.chunkCount = index.size();
+  writeBytes(&header, sizeof(header));
+  writeBytes(index.data(), index.size()*sizeof(TrajectoryIndexEntry));
+  // only now is the file complete, so only now does the header point at the index
+  file.seekp(offsetof(TrajectoryFileHeader, indexOffset));
+  file.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+  file.close();
+};
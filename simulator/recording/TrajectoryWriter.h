@@ -0,0 +1,37 @@
+#pragma once
+#include "TrajectoryFormat.h"
+#include "SimulationRecorder.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+class TrajectoryWriter {
+  // Streams RecordChunks to a binary trajectory file (see TrajectoryFormat.h) as they complete.
+  // Chunks are written as they come, so memory use doesn't grow with the run. close() appends the chunk index.
+  // With maxErrors, each field is stored to within its absolute error instead of exactly (see TrajectoryCodec.h).
+  public:
+    // maxErrors: empty to store every field exactly, or one per field, where 0 stores that field exactly
+    TrajectoryWriter(const std::string& path, std::vector<RECORDABLE_DATA> fields, std::vector<float> maxErrors = {});
+    ~TrajectoryWriter(); //closes the file if still open
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    void write(const RecordChunk& chunk);
+    // writes every chunk the recorder completes. the recorder stops keeping chunks and reuses their buffers
+    void attach(SimulationRecorder& recorder);
+    void close(); //writes the chunk index. the writer can't be used afterwards
+    bool isOpen() const { return file.is_open(); };
+    int chunkCount() const { return index.size(); };
+    uint64_t bytesWritten() const { return offset; };
+
+  private:
+    std::ofstream file;
+    std::vector<RECORDABLE_DATA> fields;
+    std::vector<float> maxErrors;
+    std::vector<uint8_t> encoded; //reused between chunks
+    std::vector<trajectory::TrajectoryIndexEntry> index;
+    uint64_t offset = 0; //bytes written so far
+
+    void writeBytes(const void* data, size_t bytes);
+    void pad(size_t bytes); //zeros up to the next 8 byte boundary
+};
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "SimulatorCheckpoint.h"
+#include "CoulombInteraction.h"
+#include "Drag.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+class CheckpointFixture : public ::testing::Test {
+  protected:
+  Simulator sim = Simulator(0.01);
+  Simulator other = Simulator(0.5);
+  std::string path = ::testing::TempDir() + "checkpoint_test.ckpt";
+
+  static void configure(Simulator& simulator) {
+    simulator.add_interaction(new Coulomb(1.0), {1.0f});
+    simulator.add_effect(new Drag(0.1), {1.0f});
+  }
+  void SetUp() override {
+    configure(sim);
+    configure(other);
+    for (int i = 0; i < 6; i++) {
+      sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(3*i, i % 2), Vect2(0, 0.5f*i), Vect2(), 0.5, 1 + i),
+        {{typeid(Coulomb), {i % 2 ? 1.0f : -1.0f}}, {typeid(Drag), {0.5f}}});
+    }
+    std::vector<int> rigidIds;
+    for (int i = 0; i < 3; i++) {
+      rigidIds.push_back(sim.add_mover(typeid(RigidConnectedMover), MoverArgs(Vect2(i, 10), Vect2(1, 0), Vect2(), 0.5, 2),
+        {{typeid(Coulomb), {0.0f}}, {typeid(Drag), {0.5f}}}));
+    }
+    sim.create_group(rigidIds);
+    sim.groups[0]->angularVelocity = 0.3f;
+    sim.add_wall(Vect2(-50, -50), Vect2(50, -50));
+    sim.add_spring_bond(sim.movers[0]->id, sim.movers[1]->id, 2.0f);
+    sim.add_distance_constraint(sim.movers[2]->id, sim.movers[3]->id);
+    sim.add_angle_constraint(sim.movers[3]->id, sim.movers[4]->id, sim.movers[5]->id, std::nullopt, 0.01f);
+    sim.add_pin_constraint(sim.movers[5]->id);
+    sim.update(5);
+  }
+  void TearDown() override {
+    std::filesystem::remove(path);
+  }
+};
+
+TEST_F(CheckpointFixture, RestoredSimulatorContinuesTheSameRun) {
+  SimulatorCheckpoint::saveFile(sim, path);
+  SimulatorCheckpoint::restoreFile(other, path);
+  EXPECT_EQ(other.step_count, sim.step_count);
+  EXPECT_FLOAT_EQ(other.current_time, sim.current_time);
+  EXPECT_FLOAT_EQ(other.global_dt, sim.global_dt);
+  EXPECT_EQ(other.walls.size(), 1);
+  EXPECT_EQ(other.bondNetwork.bondCount(), 1);
+  EXPECT_EQ(other.constraintSolver.constraints.size(), 3);
+  ASSERT_EQ(other.groups.size(), 1);
+  EXPECT_FLOAT_EQ(other.groups[0]->angularPosition, sim.groups[0]->angularPosition);
+  ASSERT_EQ(other.movers.size(), sim.movers.size());
+  EXPECT_EQ(std::any_cast<float>(other.movers[1]->interactionParams[typeid(Coulomb)][0]), 1.0f);
+  EXPECT_EQ(typeid(*other.movers[7]), typeid(RigidConnectedMover));
+
+  sim.update(20);
+  other.update(20);
+  for (int i = 0; i < sim.movers.size(); i++) {
+    EXPECT_EQ(other.movers[i]->id, sim.movers[i]->id);
+    EXPECT_NEAR(other.movers[i]->position.x, sim.movers[i]->position.x, 1e-4);
+    EXPECT_NEAR(other.movers[i]->position.y, sim.movers[i]->position.y, 1e-4);
+    EXPECT_NEAR(other.movers[i]->velocity.x, sim.movers[i]->velocity.x, 1e-4);
+  }
+  EXPECT_EQ(other.add_mover(typeid(Mover)), sim.add_mover(typeid(Mover))); //ids continue where they left off
+};
+
+TEST_F(CheckpointFixture, RestoresFromMemory) {
+  std::vector<uint8_t> bytes = SimulatorCheckpoint::save(sim);
+  std::vector<uint8_t> shifted(bytes.size() + 1);
+  std::copy(bytes.begin(), bytes.end(), shifted.begin() + 1); //misaligned copy
+  SimulatorCheckpoint::restore(other, shifted.data() + 1, bytes.size());
+  EXPECT_EQ(SimulatorCheckpoint::save(other), bytes);
+};
+
+TEST_F(CheckpointFixture, RejectsOtherConfigurations) {
+  std::vector<uint8_t> bytes = SimulatorCheckpoint::save(sim);
+  Simulator bare(0.01);
+  bare.add_mover(typeid(Mover));
+  EXPECT_THROW(SimulatorCheckpoint::restore(bare, bytes.data(), bytes.size()), std::invalid_argument);
+  // without the check the parameter types still have to resolve
+  EXPECT_THROW(SimulatorCheckpoint::restore(bare, bytes.data(), bytes.size(), false), std::invalid_argument);
+  EXPECT_EQ(bare.movers.size(), 1); //untouched
+  configure(bare);
+  bare.add_effect(new Drag(0.2), {1.0f});
+  EXPECT_THROW(SimulatorCheckpoint::restore(bare, bytes.data(), bytes.size()), std::invalid_argument); //one effect more
+  EXPECT_NO_THROW(SimulatorCheckpoint::restore(bare, bytes.data(), bytes.size(), false));
+  EXPECT_EQ(bare.movers.size(), sim.movers.size());
+};
+
+TEST_F(CheckpointFixture, RejectsDamagedCheckpoints) {
+  std::vector<uint8_t> bytes = SimulatorCheckpoint::save(sim);
+  size_t moverCount = other.movers.size();
+  EXPECT_THROW(SimulatorCheckpoint::restore(other, bytes.data(), bytes.size() - 8), std::invalid_argument);
+  EXPECT_THROW(SimulatorCheckpoint::restore(other, bytes.data(), 16), std::invalid_argument);
+  bytes[0] = 'X';
+  EXPECT_THROW(SimulatorCheckpoint::restore(other, bytes.data(), bytes.size()), std::invalid_argument);
+  EXPECT_EQ(other.movers.size(), moverCount);
+  {
+    std::ofstream file(path);
+    file << "not a checkpoint";
+  }
+  EXPECT_THROW(SimulatorCheckpoint::restoreFile(other, path), std::invalid_argument);
+  EXPECT_THROW(SimulatorCheckpoint::restoreFile(other, path + ".missing"), std::runtime_error);
+};
+
+TEST_F(CheckpointFixture, RejectsSelfBondsBeforeChangingAnything) {
+  sim.add_spring_bond(sim.movers[6]->id, sim.movers[7]->id, 1.0f);
+  std::vector<uint8_t> bytes = SimulatorCheckpoint::save(sim);
+  // the bond ids are stored as consecutive pairs: 0 1 6 7. make the second bond 6 6
+  const int32_t pattern[4] = {0, 1, 6, 7};
+  size_t found = 0;
+  for (size_t offset = 0; offset + sizeof(pattern) <= bytes.size(); offset += 4) {
+    if (std::memcmp(bytes.data() + offset, pattern, sizeof(pattern)) == 0) found = offset;
+  }
+  ASSERT_GT(found, 0);
+  const int32_t self = 6;
+  std::memcpy(bytes.data() + found + 12, &self, 4);
+  size_t moverCount = other.movers.size();
+  EXPECT_THROW(SimulatorCheckpoint::restore(other, bytes.data(), bytes.size()), std::invalid_argument);
+  EXPECT_EQ(other.movers.size(), moverCount);
+};
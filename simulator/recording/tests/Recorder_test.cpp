@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "SimulationRecorder.h"
+
+class RecorderFixture : public ::testing::Test {
+  protected:
+  Simulator sim = Simulator(0.1);
+
+  void addMovers(int count) {
+    for (int i = 0; i < count; i++) {
+      sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0), Vect2(1, i), Vect2(), 1, 1 + i));
+    }
+  }
+};
+
+TEST_F(RecorderFixture, RecordsColumnsMatchingMovers) {
+  addMovers(3);
+  SimulationRecorder recorder(sim, {POSITION_X, VELOCITY_Y, MASS}, {}, 1, 4);
+  recorder.run(2);
+  const RecordChunk& chunk = recorder.current();
+  ASSERT_EQ(chunk.samples, 2);
+  EXPECT_EQ(chunk.ids, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(chunk.steps, std::vector<long long>({1, 2, 0, 0}));
+  for (int m = 0; m < 3; m++) {
+    EXPECT_FLOAT_EQ(chunk.value(0, 1, m), sim.movers[m]->position.x);
+    EXPECT_FLOAT_EQ(chunk.value(1, 1, m), sim.movers[m]->velocity.y);
+    EXPECT_FLOAT_EQ(chunk.value(2, 1, m), 1 + m);
+  }
+  EXPECT_FLOAT_EQ(chunk.row(0, 0)[1], 1.1); //x + vx*dt after the first step
+};
+
+TEST_F(RecorderFixture, StrideAndChunking) {
+  addMovers(2);
+  SimulationRecorder recorder(sim, {POSITION_X}, {}, 3, 2);
+  EXPECT_TRUE(recorder.record()); //step 0
+  EXPECT_FALSE(recorder.record()); //same step again
+  recorder.run(9); //records steps 3, 6, 9
+  EXPECT_EQ(recorder.sampleCount(), 4);
+  ASSERT_EQ(recorder.chunks.size(), 2);
+  EXPECT_EQ(recorder.chunks[0].steps, std::vector<long long>({0, 3}));
+  EXPECT_EQ(recorder.chunks[1].steps, std::vector<long long>({6, 9}));
+  EXPECT_EQ(recorder.chunks[1].columns[0].size(), 4);
+  EXPECT_EQ(recorder.current().samples, 0);
+};
+
+TEST_F(RecorderFixture, SelectedMoversSurviveRemoval) {
+  addMovers(4);
+  SimulationRecorder recorder(sim, {POSITION_X}, {3, 1});
+  recorder.record();
+  sim.remove_mover(1);
+  sim.update();
+  recorder.record();
+  const RecordChunk& chunk = recorder.current();
+  ASSERT_EQ(chunk.samples, 2);
+  EXPECT_FLOAT_EQ(chunk.value(0, 0, 0), 3);
+  EXPECT_FLOAT_EQ(chunk.value(0, 0, 1), 1);
+  EXPECT_FLOAT_EQ(chunk.value(0, 1, 0), sim.find_mover(3)->get()->position.x);
+  EXPECT_TRUE(std::isnan(chunk.value(0, 1, 1)));
+};
+
+TEST_F(RecorderFixture, SelectedMoverAddedLaterIsRecorded) {
+  addMovers(1);
+  SimulationRecorder recorder(sim, {POSITION_X}, {1, 0});
+  recorder.record();
+  addMovers(1); //id 1
+  sim.update();
+  recorder.record();
+  const RecordChunk& chunk = recorder.current();
+  ASSERT_EQ(chunk.samples, 2);
+  EXPECT_TRUE(std::isnan(chunk.value(0, 0, 0)));
+  EXPECT_FLOAT_EQ(chunk.value(0, 1, 0), sim.find_mover(1)->get()->position.x);
+  EXPECT_FLOAT_EQ(chunk.value(0, 1, 1), sim.find_mover(0)->get()->position.x);
+};
+
+TEST_F(RecorderFixture, SelectedMoverAddedAsAnotherIsRemoved) {
+  addMovers(1);
+  SimulationRecorder recorder(sim, {POSITION_X}, {2, 0});
+  addMovers(1); //id 1
+  recorder.record();
+  sim.remove_mover(1);
+  addMovers(1); //id 2, same mover count as before
+  sim.update();
+  recorder.record();
+  const RecordChunk& chunk = recorder.current();
+  ASSERT_EQ(chunk.samples, 2);
+  EXPECT_TRUE(std::isnan(chunk.value(0, 0, 0)));
+  EXPECT_FLOAT_EQ(chunk.value(0, 1, 0), sim.find_mover(2)->get()->position.x);
+};
+
+TEST_F(RecorderFixture, MoverSetChangeStartsNewChunk) {
+  addMovers(2);
+  SimulationRecorder recorder(sim, {POSITION_X});
+  recorder.record();
+  sim.remove_mover(0);
+  addMovers(1);
+  sim.update();
+  recorder.record();
+  ASSERT_EQ(recorder.chunks.size(), 1);
+  EXPECT_EQ(recorder.chunks[0].ids, std::vector<int>({0, 1}));
+  EXPECT_EQ(recorder.chunks[0].samples, 1);
+  EXPECT_EQ(recorder.current().ids, std::vector<int>({1, 2}));
+  EXPECT_FLOAT_EQ(recorder.current().value(0, 0, 1), sim.movers[1]->position.x);
+};
+
+TEST_F(RecorderFixture, StreamingReusesChunkBuffers) {
+  addMovers(2);
+  SimulationRecorder recorder(sim, {POSITION_X, POSITION_Y}, {}, 1, 2);
+  recorder.keepChunks = false;
+  std::vector<long long> streamedSteps;
+  recorder.onChunk = [&](const RecordChunk& chunk) {
+    streamedSteps.insert(streamedSteps.end(), chunk.steps.begin(), chunk.steps.end());
+  };
+  recorder.run(5);
+  recorder.flush();
+  EXPECT_TRUE(recorder.chunks.empty());
+  EXPECT_EQ(streamedSteps, std::vector<long long>({1, 2, 3, 4, 5}));
+};
+
+TEST(RecorderTest, InvalidArgumentsThrow) {
+  Simulator sim(0.1);
+  EXPECT_THROW(SimulationRecorder(sim, {}), std::invalid_argument);
+  EXPECT_THROW(SimulationRecorder(sim, {POSITION_X}, {}, 0), std::invalid_argument);
+};
+
+TEST_F(RecorderFixture, TakeChunksAsOneBlock) {
+  addMovers(3);
+  SimulationRecorder recorder(sim, {POSITION_X, VELOCITY_Y}, {}, 2, 3);
+  recorder.run(14); //steps 2 to 14: chunks of 3, 3 and 1 samples
+  auto chunks = recorder.takeChunks();
+  ASSERT_EQ(chunks.size(), 3);
+  EXPECT_TRUE(recorder.chunks.empty());
+  EXPECT_EQ(recorder.current().samples, 0);
+  RecordChunk block = RecordChunk::concatenate(chunks);
+  ASSERT_EQ(block.samples, 7);
+  EXPECT_EQ(block.steps.front(), 2);
+  EXPECT_EQ(block.steps.back(), 14);
+  EXPECT_EQ(block.columns[0].size(), 21);
+  for (int m = 0; m < 3; m++) EXPECT_FLOAT_EQ(block.value(0, 6, m), sim.movers[m]->position.x);
+  EXPECT_FLOAT_EQ(block.value(1, 4, 2), 2);
+
+  sim.add_mover(typeid(NewtMover));
+  recorder.run(2);
+  chunks.push_back(recorder.takeChunks()[0]); //four movers
+  EXPECT_THROW(RecordChunk::concatenate(chunks), std::invalid_argument);
+};
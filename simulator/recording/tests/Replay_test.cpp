@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "ReplayRecorder.h"
+#include <map>
+
+TEST(RotatingArrayTest, KeepsNewestAndReturnsEvicted) {
+  RotatingArray<int> array(3);
+  EXPECT_EQ(array.get_previous(1), nullptr);
+  for (int i = 1; i <= 3; i++) EXPECT_FALSE(array.add(i).has_value());
+  EXPECT_EQ(array.add(4), 1);
+  EXPECT_EQ(*array.get_previous(1), 4);
+  EXPECT_EQ(*array.get_previous(3), 2);
+  EXPECT_EQ(array.get_previous(4), nullptr);
+  EXPECT_EQ(array.pop(), 4);
+  EXPECT_EQ(array.pop(), 3);
+  EXPECT_EQ(*array.get_previous(1), 2);
+  array.add(5);
+  EXPECT_EQ(*array.get_previous(1), 5);
+  EXPECT_EQ(*array.get_previous(2), 2);
+  EXPECT_THROW(RotatingArray<int>(0), std::invalid_argument);
+};
+
+class ReplayFixture : public ::testing::Test {
+  protected:
+  Simulator sim = Simulator(0.1);
+  std::map<long long, std::vector<float>> positions; //x then y of every mover, per step
+
+  void SetUp() override {
+    for (int i = 0; i < 20; i++) {
+      sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0.5f*i), Vect2(0.37f*(i % 5), -0.21f*i), Vect2(0, -0.3f), 1, 1));
+    }
+  }
+  void run(ReplayRecorder& replay, int steps) {
+    for (int i = 0; i < steps; i++) {
+      sim.update();
+      replay.record();
+      auto& row = positions[sim.step_count];
+      for (auto& mover : sim.movers) row.push_back(mover->position.x);
+      for (auto& mover : sim.movers) row.push_back(mover->position.y);
+    }
+  }
+  void expectFrame(const ReplayFrame& frame, long long step) {
+    ASSERT_EQ(frame.step, step);
+    const auto& row = positions[step];
+    int n = frame.ids.size();
+    ASSERT_EQ(row.size(), 2*n);
+    for (int m = 0; m < n; m++) {
+      EXPECT_EQ(frame.value(0, m), row[m]); //exact, deltas are lossless
+      EXPECT_EQ(frame.value(1, m), row[n + m]);
+    }
+  }
+};
+
+TEST_F(ReplayFixture, SeeksToAnyStep) {
+  ReplayRecorder replay(sim, {POSITION_X, POSITION_Y}, 8);
+  run(replay, 50);
+  EXPECT_EQ(replay.firstStep(), 1);
+  EXPECT_EQ(replay.lastStep(), 50);
+  EXPECT_EQ(replay.segmentCount(), 7); //ceil(50/8)
+  ReplayFrame frame;
+  for (long long step : {1, 8, 9, 23, 50, 37}) {
+    ASSERT_TRUE(replay.seek(step, frame));
+    expectFrame(frame, step);
+  }
+  EXPECT_FALSE(replay.seek(0, frame));
+  ASSERT_TRUE(replay.seek(1000, frame)); //latest at or before
+  EXPECT_EQ(frame.step, 50);
+  ASSERT_TRUE(replay.seekTime(2.05f, frame));
+  EXPECT_EQ(frame.step, 20);
+  EXPECT_LT(replay.bytes(), (size_t)50*20*2*sizeof(float));
+};
+
+TEST_F(ReplayFixture, ScrubsBothWays) {
+  ReplayRecorder replay(sim, {POSITION_X, POSITION_Y}, 5, 64, 2);
+  run(replay, 30);
+  ReplayFrame frame;
+  ASSERT_TRUE(replay.seek(2, frame));
+  long long step = 2;
+  while (replay.next(frame)) {
+    step += 2;
+    expectFrame(frame, step);
+  }
+  EXPECT_EQ(step, 30);
+  while (replay.previous(frame)) {
+    step -= 2;
+    expectFrame(frame, step);
+  }
+  EXPECT_EQ(step, 2);
+};
+
+TEST_F(ReplayFixture, KeyframesWhenMoversChange) {
+  ReplayRecorder replay(sim, {POSITION_X, POSITION_Y}, 100);
+  run(replay, 5);
+  sim.remove_mover(sim.movers[3]->id);
+  run(replay, 5);
+  ASSERT_EQ(replay.segmentCount(), 2);
+  EXPECT_EQ(replay.segment(1).steps.front(), 6);
+  ReplayFrame frame;
+  replay.seek(4, frame);
+  EXPECT_EQ(frame.ids.size(), 20);
+  expectFrame(frame, 4);
+  replay.next(frame);
+  replay.next(frame);
+  EXPECT_EQ(frame.ids.size(), 19);
+  expectFrame(frame, 6);
+};
+
+TEST_F(ReplayFixture, EvictsOldestSegments) {
+  ReplayRecorder replay(sim, {POSITION_X, POSITION_Y}, 4, 2);
+  std::vector<long long> evicted;
+  replay.onEvict = [&evicted](const ReplaySegment& segment) { evicted.push_back(segment.steps.front()); };
+  run(replay, 20);
+  EXPECT_EQ(evicted, std::vector<long long>({1, 5, 9}));
+  EXPECT_EQ(replay.firstStep(), 13);
+  ReplayFrame frame;
+  EXPECT_FALSE(replay.seek(12, frame));
+  ASSERT_TRUE(replay.seek(15, frame));
+  expectFrame(frame, 15);
+  replay.clear();
+  EXPECT_TRUE(replay.empty());
+  EXPECT_EQ(replay.firstStep(), -1);
+};
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include "TrajectoryWriter.h"
+#include "TrajectoryReader.h"
+#include <filesystem>
+#include <fstream>
+
+class TrajectoryFixture : public ::testing::Test {
+  protected:
+  Simulator sim = Simulator(0.1);
+  std::string path = ::testing::TempDir() + "trajectory_test.traj";
+
+  void SetUp() override {
+    for (int i = 0; i < 3; i++) {
+      sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0), Vect2(1, 2*i), Vect2(), 1, 1));
+    }
+  }
+  void TearDown() override {
+    std::filesystem::remove(path);
+  }
+  // records steps 1 to steps in chunks of 4 samples
+  void recordRun(int steps) {
+    SimulationRecorder recorder(sim, {POSITION_X, VELOCITY_Y}, {}, 1, 4);
+    TrajectoryWriter writer(path, recorder.fields);
+    writer.attach(recorder);
+    recorder.run(steps);
+    recorder.flush();
+    writer.close();
+  }
+};
+
+TEST_F(TrajectoryFixture, RoundTripsChunksAndFrames) {
+  recordRun(10);
+  TrajectoryReader reader(path);
+  EXPECT_TRUE(reader.isComplete());
+  EXPECT_EQ(reader.fields(), std::vector<RECORDABLE_DATA>({POSITION_X, VELOCITY_Y}));
+  EXPECT_EQ(reader.fieldIndex(VELOCITY_Y), 1);
+  EXPECT_EQ(reader.fieldIndex(MASS), -1);
+  ASSERT_EQ(reader.chunkCount(), 3); //4 + 4 + 2 samples
+  EXPECT_EQ(reader.chunk(2).samples, 2);
+  EXPECT_EQ(reader.frameCount(), 10);
+  EXPECT_EQ(reader.indexEntry(1).firstStep, 5);
+  EXPECT_EQ(reader.indexEntry(1).lastStep, 8);
+
+  auto last = reader.frame(9);
+  EXPECT_EQ(last.step, 10);
+  EXPECT_FLOAT_EQ(last.time, sim.current_time);
+  ASSERT_EQ(last.moverCount(), 3);
+  for (int m = 0; m < 3; m++) {
+    EXPECT_EQ(last.ids()[m], sim.movers[m]->id);
+    EXPECT_FLOAT_EQ(last.value(0, m), sim.movers[m]->position.x);
+    EXPECT_FLOAT_EQ(last.value(1, m), 2*m);
+  }
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(last.values(0)) % 4, 0); //read in place from the mapping
+};
+
+TEST_F(TrajectoryFixture, FindStep) {
+  recordRun(10);
+  TrajectoryReader reader(path);
+  EXPECT_EQ(reader.findStep(0), 0);
+  EXPECT_EQ(reader.findStep(6), 5);
+  EXPECT_EQ(reader.frame(reader.findStep(6)).step, 6);
+  EXPECT_EQ(reader.findStep(11), reader.frameCount());
+  EXPECT_THROW(reader.frame(10), std::out_of_range);
+};
+
+TEST_F(TrajectoryFixture, UnclosedFileKeepsWholeChunks) {
+  recordRun(10);
+  size_t lastChunk = TrajectoryReader(path).indexEntry(2).offset;
+  // as if the writer stopped part way through the last chunk: no index, truncated chunk
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    uint64_t zero = 0;
+    file.seekp(offsetof(trajectory::TrajectoryFileHeader, indexOffset));
+    file.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
+  }
+  std::filesystem::resize_file(path, lastChunk + 40);
+  TrajectoryReader reader(path);
+  EXPECT_FALSE(reader.isComplete());
+  EXPECT_EQ(reader.chunkCount(), 2);
+  EXPECT_EQ(reader.frameCount(), 8);
+  EXPECT_EQ(reader.indexEntry(1).lastStep, 8);
+};
+
+TEST_F(TrajectoryFixture, RejectsOtherFiles) {
+  {
+    std::ofstream file(path);
+    file << "time,x\n0,1\n1,2\n3,4\n";
+  }
+  EXPECT_THROW(TrajectoryReader reader(path), std::runtime_error);
+  EXPECT_THROW(TrajectoryReader reader(path + ".missing"), std::runtime_error);
+};
+
+TEST_F(TrajectoryFixture, QuantizedColumnsStayWithinMaxError) {
+  for (int i = 0; i < 200; i++) {
+    sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i % 20, i / 20), Vect2(0.3f*(i % 7), -0.2f*(i % 5)), Vect2(), 1, 1));
+  }
+  std::vector<RECORDABLE_DATA> fields = {POSITION_X, POSITION_Y, VELOCITY_X, MASS};
+  SimulationRecorder recorder(sim, fields, {}, 1, 64);
+  recorder.keepChunks = true;
+  TrajectoryWriter exact(path + ".raw", fields);
+  TrajectoryWriter lossy(path, fields, {1e-3, 1e-3, 1e-3, 0});
+  recorder.run(256);
+  for (auto& chunk : recorder.chunks) {
+    exact.write(chunk);
+    lossy.write(chunk);
+  }
+  exact.close();
+  lossy.close();
+  EXPECT_GT(exact.bytesWritten(), 3*lossy.bytesWritten());
+
+  TrajectoryReader reader(path);
+  reader.decodeChunks(0, reader.chunkCount(), 2);
+  ASSERT_EQ(reader.chunkCount(), recorder.chunks.size());
+  for (int c = 0; c < reader.chunkCount(); c++) {
+    const RecordChunk& expected = recorder.chunks[c];
+    const auto& view = reader.chunk(c);
+    ASSERT_EQ(view.samples, expected.samples);
+    for (int f = 0; f < fields.size(); f++) {
+      for (int i = 0; i < expected.columns[f].size(); i++) {
+        float error = std::abs(view.columns[f][i] - expected.columns[f][i]);
+        if (f == 3) ASSERT_EQ(error, 0); //stored exactly
+        else ASSERT_LE(error, 1e-3f*1.001f + 1e-6f*std::abs(expected.columns[f][i]));
+      }
+    }
+  }
+  std::filesystem::remove(path + ".raw");
+};
+
+TEST_F(TrajectoryFixture, QuantizedChunksKeepMissingMovers) {
+  SimulationRecorder recorder(sim, {POSITION_X}, {0, 7});
+  TrajectoryWriter writer(path, recorder.fields, {0.01f});
+  writer.attach(recorder);
+  recorder.run(3);
+  recorder.flush();
+  writer.close();
+  TrajectoryReader reader(path);
+  auto frame = reader.frame(2);
+  EXPECT_FLOAT_EQ(frame.value(0, 0), sim.movers[0]->position.x); //column with NaN is stored raw
+  EXPECT_TRUE(std::isnan(frame.value(0, 1)));
+};
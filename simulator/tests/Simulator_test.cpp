@@ -6,6 +6,10 @@
 #include "Attractor.h"
 #include "SpringInteraction.h"
 #include "ConstantAcceleration.h"
+#include "ExpressionEffect.h"
+#include "ExpressionInteractingGroup.h"
+#include "PluginInteractingGroup.h"
+#include "PluginEffect.h"
 
 class SimulatorFixture : public ::testing::Test {
   protected:
@@ -211,6 +215,395 @@ TEST_F(SimulatorFixture, DeleteGroupAndUpdate) {
   EXPECT_NO_THROW(sim.update(1));
 }
 
+TEST_F(SimulatorFixture, DeleteLargeGroupAndUpdate) {
+  std::vector<int> mover_ids;
+  for (int i = 0; i < 1000; i++) {
+    mover_ids.push_back(sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0), Vect2(), Vect2(), 1, 1)));
+  }
+  int loneId = sim.add_mover(typeid(NewtMover));
+  sim.create_group(mover_ids);
+  EXPECT_EQ(sim.groups[0]->movers.size(), 1000);
+  sim.delete_group(sim.groups[0].get());
+  EXPECT_EQ(sim.groups.size(), 0);
+  EXPECT_EQ(sim.movers.size(), 1);
+  EXPECT_EQ(sim.movers[0]->id, loneId);
+  EXPECT_NO_THROW(sim.update(1));
+}
+
+TEST_F(SimulatorFixture, RemoveSomeGroupMembers) {
+  std::vector<int> mover_ids;
+  for (int i = 0; i < 4; i++) {
+    mover_ids.push_back(sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(10*i, 0), Vect2(), Vect2(), 1, 1)));
+  }
+  sim.create_group(mover_ids);
+  std::vector<int> to_remove = {mover_ids[2], mover_ids[3]};
+  EXPECT_TRUE(sim.remove_movers(to_remove));
+  EXPECT_EQ(sim.movers.size(), 2);
+  EXPECT_EQ(sim.groups[0]->movers.size(), 2);
+  EXPECT_EQ(sim.groups[0]->centerOfMass, Vect2(5, 0));
+  EXPECT_NO_THROW(sim.update(1));
+}
+
+TEST_F(SimulatorFixture, EditGroupAddsAndRemoves) {
+  int id1 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(0, 0), Vect2(), Vect2(), 1, 1));
+  int id2 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(10, 0), Vect2(), Vect2(), 1, 1));
+  int id3 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(20, 0), Vect2(), Vect2(), 1, 1));
+  std::vector<int> mover_ids = {id1, id2};
+  sim.create_group(mover_ids);
+  RigidConnectedGroup* group = sim.groups[0].get();
+  std::vector<int> add_ids = {id3};
+  std::vector<int> remove_ids = {id1};
+  sim.edit_group(group, add_ids, remove_ids);
+  EXPECT_EQ(group->movers.size(), 2);
+  EXPECT_EQ(group->centerOfMass, Vect2(15, 0));
+  EXPECT_EQ(typeid(*sim.movers[0]), typeid(NewtMover));
+  EXPECT_EQ(typeid(*sim.movers[2]), typeid(RigidConnectedMover));
+  EXPECT_NO_THROW(sim.update(1));
+}
+
+TEST_F(SimulatorFixture, DistanceConstraintHoldsAtLargeStep) {
+  sim.global_dt = 0.5f;
+  int id1 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(0, 0), Vect2(0, 0), Vect2(), 1, 1));
+  int id2 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(10, 0), Vect2(0, 20), Vect2(), 1, 1));
+  EXPECT_TRUE(sim.add_pin_constraint(id1));
+  EXPECT_TRUE(sim.add_distance_constraint(id1, id2));
+  EXPECT_FALSE(sim.add_distance_constraint(id1, 999));
+  sim.update(50);
+  EXPECT_NEAR((sim.movers[1]->position - sim.movers[0]->position).mag(), 10, 1e-2);
+  EXPECT_NEAR(sim.movers[0]->position.mag(), 0, 1e-2);
+}
+
+TEST_F(SimulatorFixture, RemovingConstrainedMoverIsSafe) {
+  int id1 = sim.add_mover(typeid(NewtMover));
+  int id2 = sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(5, 0), Vect2(), Vect2(), 1, 1));
+  sim.add_distance_constraint(id1, id2);
+  sim.remove_mover(id2);
+  EXPECT_NO_THROW(sim.update(1));
+  EXPECT_EQ(sim.constraintSolver.constraints.size(), 0);
+}
+
+TEST_F(SimulatorFixture, TypedSpringGroupMatchesFunctionGroup) {
+  Simulator functionSim(0.01);
+  std::vector<int> ids;
+  for (int i = 0; i < 300; i++) { //large enough to be split across the pool
+    MoverArgs args(Vect2(i % 17, i / 17), Vect2(), Vect2(), 1, 1);
+    ids.push_back(sim.add_mover(typeid(NewtMover), args));
+    functionSim.add_mover(typeid(NewtMover), args);
+  }
+  SpringPairKernel kernel{1.0f, 5.0f};
+  std::function<void(Mover&, Mover&)> interaction = kernel;
+  sim.add_interactingGroup(ids, kernel);
+  functionSim.add_interactingGroup(ids, interaction);
+  std::vector<int> smallGroup = {ids[0], ids[1], ids[2]}; //overlapping small group is batched
+  sim.add_interactingGroup(smallGroup, kernel);
+  functionSim.add_interactingGroup(smallGroup, interaction);
+  sim.update(2);
+  functionSim.update(2);
+  for (int i = 0; i < ids.size(); i++) {
+    EXPECT_NEAR(sim.movers[i]->position.x, functionSim.movers[i]->position.x, 1e-3);
+    EXPECT_NEAR(sim.movers[i]->position.y, functionSim.movers[i]->position.y, 1e-3);
+  }
+}
+
+TEST_F(SimulatorFixture, InteractingGroupRowSplitsBalancePairs) {
+  std::vector<int> ids;
+  for (int i = 0; i < 100; i++) ids.push_back(sim.add_mover(typeid(NewtMover)));
+  InteractingGroup group(sim, ids, SpringPairKernel{1.0f, 5.0f});
+  std::vector<int> splits = group.rowSplits(4);
+  ASSERT_EQ(splits.size(), 5);
+  EXPECT_EQ(splits.front(), 0);
+  EXPECT_EQ(splits.back(), 100);
+  for (int i = 0; i < 4; i++) {
+    long long pairs = 0;
+    for (int row = splits[i]; row < splits[i+1]; row++) pairs += 99 - row;
+    EXPECT_NEAR(pairs, group.pairCount() / 4, 100);
+  }
+}
+
+TEST_F(SimulatorFixture, ExpressionCompilesAndEvaluatesTiles) {
+  Expression square("-(x - 1)^2 + max(y, 0)", {{"x", 0}, {"y", 1}}, {});
+  EXPECT_FALSE(square.isVector());
+  float xs[3] = {0, 1, 3}, ys[3] = {-1, 2, 0.5f}, out[3];
+  const float* inputs[2] = {xs, ys};
+  square.evaluate(inputs, 3, out);
+  EXPECT_FLOAT_EQ(out[0], -1);
+  EXPECT_FLOAT_EQ(out[1], 2);
+  EXPECT_FLOAT_EQ(out[2], -3.5f);
+  Expression folded("k/2*vec(x, 1)", {{"x", 0}}, {{"k", 3}});
+  EXPECT_TRUE(folded.isVector());
+  EXPECT_EQ(folded.instructionCount(), 5); //1.5, x, 1, vec, scale
+  EXPECT_FALSE(folded.uses(1));
+  float outY[3];
+  folded.evaluate(inputs, 3, out, outY);
+  EXPECT_FLOAT_EQ(out[2], 4.5f);
+  EXPECT_FLOAT_EQ(outY[2], 1.5f);
+
+  EXPECT_THROW(Expression("x +", {{"x", 0}}), std::invalid_argument);
+  EXPECT_THROW(Expression("z", {{"x", 0}}), std::invalid_argument);
+  EXPECT_THROW(Expression("v*v", {{"v", 0, 1}}), std::invalid_argument); //use dot
+  EXPECT_THROW(Expression("v + 1", {{"v", 0, 1}}), std::invalid_argument);
+  EXPECT_THROW(Expression("mag(1)", {}), std::invalid_argument);
+  EXPECT_THROW(ExpressionEffect("mass"), std::invalid_argument); //forces are vectors
+  std::vector<int> none;
+  EXPECT_THROW(ExpressionInteractingGroup(sim, none, "rhat", {}, {{"mass", 1}}), std::invalid_argument); //mass1 is taken
+}
+
+TEST_F(SimulatorFixture, ExpressionGroupMatchesSpringGroup) {
+  Simulator kernelSim(0.01);
+  std::vector<int> ids;
+  for (int i = 0; i < 300; i++) { //several tiles per row, and split across the pool
+    MoverArgs args(Vect2(i % 17, i / 17), Vect2(), Vect2(), 1, 1);
+    ids.push_back(sim.add_mover(typeid(NewtMover), args));
+    kernelSim.add_mover(typeid(NewtMover), args);
+  }
+  sim.movers[3]->interactionParams[typeid(ExpressionInteractingGroup)] = {2.0f}; //k = 2 for pairs with mover 3
+  sim.add_interactingGroup(std::make_unique<ExpressionInteractingGroup>(sim, ids, "-sqrt(k1*k2)*(r - x0)*rhat",
+    std::unordered_map<std::string, float>{{"x0", 5}}, std::vector<std::pair<std::string, float>>{{"k", 1}}));
+  kernelSim.add_interactingGroup(ids, [](Mover& mover1, Mover& mover2) {
+    bool stiff = mover1.id == 3 || mover2.id == 3;
+    SpringPairKernel{stiff ? std::sqrt(2.0f) : 1.0f, 5.0f}(mover1, mover2);
+  });
+  sim.update(2);
+  kernelSim.update(2);
+  for (int i = 0; i < ids.size(); i++) {
+    EXPECT_NEAR(sim.movers[i]->position.x, kernelSim.movers[i]->position.x, 1e-3);
+    EXPECT_NEAR(sim.movers[i]->position.y, kernelSim.movers[i]->position.y, 1e-3);
+  }
+  sim.movers[4]->interactionParams[typeid(ExpressionInteractingGroup)] = {2.0f, 3.0f}; //one parameter, k
+  EXPECT_THROW(sim.update(), std::invalid_argument);
+}
+
+TEST_F(SimulatorFixture, ExpressionEffectMatchesDrag) {
+  Simulator dragSim(0.01);
+  sim.add_effect(new ExpressionEffect("-c*vel + vec(0, g*mass)", {{"g", -1}}, {"c"}), {0.5f});
+  dragSim.add_effect(new Drag(), {0.5f});
+  dragSim.add_effect(new ConstantAcceleration(Vect2(0, -1)));
+  for (int i = 0; i < 100; i++) {
+    MoverArgs args(Vect2(i, 0), Vect2(i % 7, 1), Vect2(), 1, 1 + i % 3);
+    sim.add_mover(typeid(NewtMover), args, {{typeid(ExpressionEffect), {i % 2 ? 0.5f : 2.0f}}});
+    dragSim.add_mover(typeid(NewtMover), args, {{typeid(Drag), {i % 2 ? 0.5f : 2.0f}}});
+  }
+  sim.update(3);
+  dragSim.update(3);
+  for (int i = 0; i < sim.movers.size(); i++) {
+    EXPECT_NEAR(sim.movers[i]->velocity.x, dragSim.movers[i]->velocity.x, 1e-4);
+    EXPECT_NEAR(sim.movers[i]->velocity.y, dragSim.movers[i]->velocity.y, 1e-4);
+  }
+}
+
+TEST_F(SimulatorFixture, TiledEffectChecksMoverParams) {
+  ExpressionEffect effect("-c*vel", {}, {"c"});
+  NewtMover mover(MoverArgs(Vect2(), Vect2(1, 0), Vect2(), 1, 1));
+  EXPECT_THROW(effect.apply(&mover), std::invalid_argument);
+  EXPECT_TRUE(mover.interactionParams.empty()); //looked up, not inserted
+  mover.interactionParams[typeid(ExpressionEffect)] = {0.5f, 1.0f};
+  EXPECT_THROW(effect.apply(&mover), std::invalid_argument);
+  mover.interactionParams[typeid(ExpressionEffect)] = {0.5f};
+  effect.apply(&mover);
+  EXPECT_FLOAT_EQ(mover.force_sum.load().x, -0.5f);
+}
+
+TEST_F(SimulatorFixture, PluginKernelsMatchBuiltIns) {
+  std::vector<std::string> loaded = sim.kernels.load(TEST_KERNELS_PATH);
+  EXPECT_EQ(loaded, std::vector<std::string>({"test_spring", "test_drag"}));
+  Simulator builtInSim(0.01);
+  std::vector<int> ids;
+  for (int i = 0; i < 300; i++) {
+    MoverArgs args(Vect2(i % 17, i / 17), Vect2(i % 3, 0), Vect2(), 1, 1);
+    ids.push_back(sim.add_mover(typeid(NewtMover), args));
+    builtInSim.add_mover(typeid(NewtMover), args);
+  }
+  sim.add_interactingGroup(std::make_unique<PluginInteractingGroup>(sim, ids, sim.kernels.find("test_spring"),
+    std::vector<float>{1.0f, 5.0f}));
+  sim.add_effect(new PluginEffect(sim.kernels.find("test_drag")), {0.5f});
+  builtInSim.add_interactingGroup(ids, SpringPairKernel{1.0f, 5.0f});
+  builtInSim.add_effect(new Drag(), {0.5f});
+  sim.update(2);
+  builtInSim.update(2);
+  for (int i = 0; i < ids.size(); i++) {
+    EXPECT_NEAR(sim.movers[i]->position.x, builtInSim.movers[i]->position.x, 1e-3);
+    EXPECT_NEAR(sim.movers[i]->position.y, builtInSim.movers[i]->position.y, 1e-3);
+  }
+}
+
+namespace {
+void towardOrigin(const phys_tile* movers, float time, const float* constants, float* fx, float* fy) {
+  for (int l = 0; l < movers->count; l++) {
+    fx[l] = -constants[0]*movers->x[l];
+    fy[l] = -constants[0]*movers->y[l];
+  }
+}
+}
+
+TEST_F(SimulatorFixture, KernelRegistryChecksKernels) {
+  EXPECT_THROW(sim.kernels.load(TEST_KERNELS_PATH ".missing"), std::runtime_error);
+  sim.kernels.load(TEST_KERNELS_PATH);
+  EXPECT_THROW(sim.kernels.load(TEST_KERNELS_PATH), std::invalid_argument); //names taken
+  EXPECT_THROW(sim.kernels.find("nothing"), std::invalid_argument);
+  phys_kernel bad = {"bad", PHYS_PAIR_KERNEL, 0, 0, nullptr, towardOrigin};
+  EXPECT_THROW(sim.kernels.add(bad), std::invalid_argument); //no pair function
+  EXPECT_FALSE(sim.kernels.contains("bad"));
+
+  std::string name = "toward_origin";
+  sim.kernels.add({name.c_str(), PHYS_EFFECT_KERNEL, 0, 1, nullptr, towardOrigin});
+  name = "changed"; //the registry keeps its own copy
+  EXPECT_EQ(sim.kernels.names(), std::vector<std::string>({"test_drag", "test_spring", "toward_origin"}));
+  const phys_kernel& kernel = sim.kernels.find("toward_origin");
+  EXPECT_THROW(PluginEffect(kernel, {}), std::invalid_argument); //one constant
+  std::vector<int> none;
+  EXPECT_THROW(PluginInteractingGroup(sim, none, kernel, {1.0f}), std::invalid_argument); //not a pair kernel
+  sim.add_effect(new PluginEffect(kernel, {2.0f}));
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(1, -1), Vect2(), Vect2(), 1, 1));
+  sim.update(1);
+  EXPECT_LT(sim.movers[0]->velocity.x, 0); //pulled toward the origin
+  EXPECT_FLOAT_EQ(sim.movers[0]->velocity.y, -sim.movers[0]->velocity.x);
+}
+
+TEST_F(SimulatorFixture, SpringBondLatticeMatchesPairGroups) {
+  Simulator groupSim(0.01);
+  const int side = 60; //~7000 bonds, enough for colours to be split across the pool
+  std::vector<int> ids1, ids2;
+  for (int i = 0; i < side*side; i++) {
+    MoverArgs args(Vect2(1.1f*(i % side), 0.9f*(i / side)), Vect2(), Vect2(), 1, 1);
+    sim.add_mover(typeid(NewtMover), args);
+    groupSim.add_mover(typeid(NewtMover), args);
+    if (i % side != side - 1) { ids1.push_back(i); ids2.push_back(i + 1); }
+    if (i / side != side - 1) { ids1.push_back(i); ids2.push_back(i + side); }
+  }
+  EXPECT_EQ(sim.add_spring_bonds(ids1, ids2, {2.0f}, {1.0f}), ids1.size());
+  for (int b = 0; b < ids1.size(); b++) {
+    std::vector<int> pair = {ids1[b], ids2[b]};
+    groupSim.add_interactingGroup(pair, SpringPairKernel{2.0f, 1.0f});
+  }
+  sim.update(2);
+  groupSim.update(2);
+  EXPECT_LE(sim.bondNetwork.colorCount(), 7); //max degree 4, greedy colouring needs at most 2*4-1
+  for (int i = 0; i < sim.movers.size(); i++) {
+    EXPECT_NEAR(sim.movers[i]->position.x, groupSim.movers[i]->position.x, 1e-4);
+    EXPECT_NEAR(sim.movers[i]->position.y, groupSim.movers[i]->position.y, 1e-4);
+  }
+}
+
+TEST_F(SimulatorFixture, SpringBondsDroppedWithMover) {
+  for (int i = 0; i < 4; i++) sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0), Vect2(), Vect2(), 1, 1));
+  EXPECT_TRUE(sim.add_spring_bond(0, 1, 1.0f));
+  EXPECT_TRUE(sim.add_spring_bond(1, 2, 1.0f, 2.0f));
+  EXPECT_TRUE(sim.add_spring_bond(2, 3, 1.0f));
+  EXPECT_FALSE(sim.add_spring_bond(0, 42, 1.0f));
+  EXPECT_THROW(sim.add_spring_bonds({0, 1}, {2}, {1.0f}, {-1.0f}), std::invalid_argument);
+  std::vector<int> bonded = sim.bondNetwork.bondedMoverIds(1);
+  std::sort(bonded.begin(), bonded.end());
+  EXPECT_EQ(bonded, std::vector<int>({0, 2}));
+  sim.remove_mover(2);
+  sim.update();
+  EXPECT_EQ(sim.bondNetwork.bondCount(), 1);
+  EXPECT_TRUE(sim.bondNetwork.bondedMoverIds(3).empty());
+  EXPECT_EQ(sim.bondNetwork.bondedMoverIds(0), std::vector<int>({1}));
+}
+
+TEST_F(SimulatorFixture, SnapshotPublishedAfterStep) {
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(1, 2), Vect2(10, 0), Vect2(), 3, 1));
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(5, 5), Vect2(), Vect2(), 4, 1));
+  sim.walls.push_back(std::make_unique<Wall>(Vect2(0, 0), Vect2(0, 100)));
+  EXPECT_TRUE(sim.snapshots.read()->ids.empty()); //nothing published yet
+  sim.update();
+  auto snapshot = sim.snapshots.read();
+  EXPECT_EQ(snapshot->step, 1);
+  EXPECT_EQ(snapshot->ids, std::vector<int>({0, 1}));
+  EXPECT_EQ(snapshot->positions[0], sim.movers[0]->position);
+  EXPECT_EQ(snapshot->radii[1], 4);
+  ASSERT_EQ(snapshot->wallStarts.size(), 1);
+  EXPECT_EQ(snapshot->wallEnds[0], Vect2(0, 100));
+}
+
+TEST_F(SimulatorFixture, PinnedSnapshotIsNotOverwritten) {
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(0, 0), Vect2(1, 0), Vect2(), 1, 1));
+  sim.update();
+  auto pinned = sim.snapshots.read();
+  Vect2 pinnedPosition = pinned->positions[0];
+  sim.update(5); //alternates between the two free buffers
+  EXPECT_EQ(pinned->positions[0], pinnedPosition);
+  EXPECT_EQ(pinned->step, 1);
+  auto second = sim.snapshots.read();
+  EXPECT_EQ(second->step, 6);
+  sim.update(); //goes to the one unpinned buffer
+  EXPECT_EQ(sim.snapshots.read()->step, 7);
+  sim.update(); //both non-latest buffers are pinned, so this publish is skipped
+  EXPECT_EQ(sim.snapshots.read()->step, 7);
+  EXPECT_EQ(sim.step_count, 8);
+}
+
+TEST_F(SimulatorFixture, AddMoversFromArrays) {
+  sim.add_interaction(new Coulomb(1.0), {0.0f});
+  sim.add_mover(typeid(NewtMover));
+  const int n = 10000; //enough to be split over the thread pool
+  std::vector<Vect2> positions(n);
+  std::vector<float> charges(n);
+  for (int i = 0; i < n; i++) {
+    positions[i] = Vect2(i, -i);
+    charges[i] = i % 2 ? 1.0f : -1.0f;
+  }
+  MoverArrays arrays;
+  arrays.count = n;
+  arrays.positions = positions.data();
+  arrays.paramColumns[typeid(Coulomb)] = {charges.data()};
+  EXPECT_EQ(sim.add_movers(typeid(NewtMover), arrays), 1);
+  ASSERT_EQ(sim.movers.size(), n + 1);
+  EXPECT_EQ(sim.movers[n]->id, n);
+  EXPECT_EQ(sim.movers[n]->position, Vect2(n - 1, 1 - n));
+  EXPECT_EQ(std::any_cast<float>(sim.movers[2]->interactionParams[typeid(Coulomb)][0]), 1.0f);
+  EXPECT_EQ(sim.add_mover(typeid(Mover)), n + 1);
+  EXPECT_NE(sim.find_mover(5000), sim.movers.end());
+}
+
+TEST_F(SimulatorFixture, BulkMoverState) {
+  sim.add_mover(typeid(Mover), MoverArgs(Vect2(1, 2), Vect2(3, 4), Vect2(), 5, 0));
+  sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(6, 7), Vect2(8, 9), Vect2(), 10, 11));
+  std::vector<int> ids(2);
+  std::vector<Vect2> positions(2), velocities(2);
+  std::vector<float> masses(2), radii(2);
+  sim.get_mover_state(2, ids.data(), positions.data(), velocities.data(), masses.data(), radii.data());
+  EXPECT_EQ(ids, std::vector<int>({0, 1}));
+  EXPECT_EQ(positions[1], Vect2(6, 7));
+  EXPECT_EQ(velocities[0], Vect2(3, 4));
+  EXPECT_EQ(masses, std::vector<float>({0, 11}));
+  EXPECT_EQ(radii[1], 10);
+
+  positions = {Vect2(-1, -1), Vect2(-2, -2)};
+  sim.set_mover_state(2, positions.data(), nullptr, nullptr, nullptr);
+  EXPECT_EQ(sim.movers[1]->position, Vect2(-2, -2));
+  EXPECT_EQ(sim.movers[1]->velocity, Vect2(8, 9)); //skipped
+  EXPECT_EQ(sim.snapshots.read()->positions[0], Vect2(-1, -1));
+  masses = {0, 0}; //fine for the Mover, not for the NewtMover
+  EXPECT_THROW(sim.set_mover_state(2, nullptr, nullptr, masses.data(), nullptr), std::invalid_argument);
+  EXPECT_EQ(sim.movers[1]->mass, 11);
+  // arrays sized for a mover count that has changed since
+  sim.add_mover(typeid(Mover));
+  EXPECT_THROW(sim.get_mover_state(2, ids.data(), nullptr, nullptr, nullptr, nullptr), std::invalid_argument);
+  EXPECT_THROW(sim.set_mover_state(2, positions.data(), nullptr, nullptr, nullptr), std::invalid_argument);
+  EXPECT_EQ(sim.movers[0]->position, Vect2(-1, -1));
+}
+
+TEST_F(SimulatorFixture, SnapshotReadersRunAlongsideSteps) {
+  for (int i = 0; i < 200; i++) sim.add_mover(typeid(NewtMover), MoverArgs(Vect2(i, 0), Vect2(1, 1), Vect2(), 1, 1));
+  std::atomic<bool> done = false;
+  std::atomic<int> inconsistent = 0;
+  std::thread reader([&]() {
+    while (!done) {
+      auto snapshot = sim.snapshots.read();
+      // every mover moves by the same amount, so a torn snapshot would show different offsets
+      for (int i = 1; i < snapshot->positions.size(); i++) {
+        if (snapshot->positions[i].y != snapshot->positions[0].y) inconsistent++;
+      }
+    }
+  });
+  sim.update(200);
+  done = true;
+  reader.join();
+  EXPECT_EQ(inconsistent, 0);
+  EXPECT_EQ(sim.snapshots.read()->step, 200);
+}
+
 // Memory management test
 class DeletionSpy : public NewtMover {
 public:
@@ -0,0 +1,45 @@
+// Plugin kernels loaded by Simulator_test through KernelRegistry::load, built as a shared library
+#include "PhysKernelABI.h"
+#include <cmath>
+
+namespace {
+
+// constants: k, x0. same force as SpringPairKernel
+void spring(const phys_tile* first, const phys_tile* second, const float* constants, float* fx, float* fy) {
+  for (int l = 0; l < first->count; l++) {
+    float dx = first->x[l] - second->x[l];
+    float dy = first->y[l] - second->y[l];
+    float r = std::sqrt(dx*dx + dy*dy);
+    if (r == 0) continue;
+    float magnitude = -constants[0]*(r - constants[1])/r;
+    fx[l] = magnitude*dx;
+    fy[l] = magnitude*dy;
+  }
+}
+
+// parameter: drag coefficient. same force as Drag
+void drag(const phys_tile* movers, float time, const float* constants, float* fx, float* fy) {
+  for (int l = 0; l < movers->count; l++) {
+    fx[l] = -movers->params[0][l]*movers->vx[l];
+    fy[l] = -movers->params[0][l]*movers->vy[l];
+  }
+}
+
+const phys_kernel kernels[] = {
+  {"test_spring", PHYS_PAIR_KERNEL, 0, 2, spring, nullptr},
+  {"test_drag", PHYS_EFFECT_KERNEL, 1, 0, nullptr, drag},
+};
+
+}
+
+#ifdef _WIN32
+#define EXPORT __declspec(dllexport)
+#else
+#define EXPORT __attribute__((visibility("default")))
+#endif
+
+extern "C" EXPORT const phys_kernel* phys_kernels(int abiVersion, int* count) {
+  if (abiVersion != PHYS_KERNEL_ABI_VERSION) return nullptr;
+  *count = 2;
+  return kernels;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file. The OS pages the file in as it is read,
+// so readers can use the data in place instead of reading and parsing it first.
+class MappedFile {
+  public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile() { unmap(); };
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return bytes; };
+    size_t size() const { return length; };
+
+  private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+    void unmap();
+};
+
+inline MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+  fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE) throw std::runtime_error("MappedFile: could not open " + path);
+  LARGE_INTEGER size;
+  GetFileSizeEx(fileHandle, &size);
+  length = size.QuadPart;
+  if (length == 0) return; //empty files can't be mapped, and have nothing to read
+  mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mappingHandle != nullptr) bytes = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (bytes == nullptr) {
+    unmap();
+    throw std::runtime_error("MappedFile: could not map " + path);
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("MappedFile: could not open " + path);
+  struct stat info;
+  fstat(fd, &info);
+  length = info.st_size;
+  if (length > 0) {
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("MappedFile: could not map " + path);
+    }
+    bytes = static_cast<const uint8_t*>(mapped);
+  }
+  close(fd); //the mapping keeps the file open
+#endif
+};
+
+inline void MappedFile::unmap() {
+#ifdef _WIN32
+  if (bytes != nullptr) UnmapViewOfFile(bytes);
+  if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+  if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+  mappingHandle = nullptr;
+  fileHandle = INVALID_HANDLE_VALUE;
+#else
+  if (bytes != nullptr) munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+  bytes = nullptr;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+
+// Lock-free buffer handoff from one writer to any number of readers.
+// The writer fills a buffer no reader holds and publishes it as the latest. Readers pin the latest
+// buffer while they read it, so it can't be rewritten underneath them. Neither side ever waits:
+// if slow readers hold both non-latest buffers, beginWrite() returns nullptr and that publish is skipped.
+// Buffers are reused, so a T holding vectors stops allocating once they reach their steady size.
+template <class T>
+class TripleBuffer {
+  public:
+    class ReadHandle {
+      public:
+        ReadHandle(TripleBuffer* owner, int index) : owner(owner), index(index) {}
+        ReadHandle(ReadHandle&& other) : owner(other.owner), index(other.index) { other.owner = nullptr; }
+        ReadHandle(const ReadHandle&) = delete;
+        ReadHandle& operator=(const ReadHandle&) = delete;
+        ~ReadHandle() { if (owner) owner->readers[index]--; }
+        const T& operator*() const { return owner->buffers[index]; }
+        const T* operator->() const { return &owner->buffers[index]; }
+      private:
+        TripleBuffer* owner;
+        int index;
+    };
+
+    // a buffer to fill, or nullptr if every non-latest buffer is pinned by a reader. writer thread only
+    T* beginWrite() {
+      int latestIndex = latest.load();
+      for (int i = 0; i < 3; i++) {
+        if (i == latestIndex || readers[i].load() != 0) continue;
+        writing = i;
+        return &buffers[i];
+      }
+      writing = -1;
+      return nullptr;
+    }
+
+    // makes the buffer from beginWrite the latest
+    void publish() {
+      if (writing < 0) return;
+      latest.store(writing);
+      published.fetch_add(1);
+      writing = -1;
+    }
+
+    // pins and returns the latest published buffer
+    ReadHandle read() {
+      while (true) {
+        int index = latest.load();
+        readers[index]++;
+        // the writer never starts on the latest buffer, so if it is still the latest it is safe to read
+        if (latest.load() == index) return ReadHandle(this, index);
+        readers[index]--;
+      }
+    }
+
+    long long publishCount() const { return published.load(); }
+
+  private:
+    T buffers[3];
+    std::atomic<int> readers[3] = {0, 0, 0};
+    std::atomic<int> latest{0};
+    std::atomic<long long> published{0};
+    int writing = -1;
+};